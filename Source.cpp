@@ -7,29 +7,64 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <shader.h>
 #include <model.h>
+#include <scene.h>
+#include <occlusion.h>
+#include <indirectrenderer.h>
+#include <gpuculling.h>
+#include <glcaps.h>
+#include <softwareocclusion.h>
+#include <jobsystem.h>
+#include <gpuresource.h>
+#include <profiler.h>
+#include <uniformbuffers.h>
+#include <renderthread.h>
+#include <simulation.h>
+#include <framepacer.h>
+#include <input.h>
+#include <camera.h>
+#include <level.h>
+#include <autosave.h>
+#include <undojournal.h>
+#include <picking.h>
+#include <ui.h>
+#include <uirenderer.h>
+#include <font.h>
+#include <perfhud.h>
+#include <gputimer.h>
+#include <debugdraw.h>
+#include <debugrenderer.h>
+#include <glstats.h>
 
 // Constants //
 const unsigned short windowX = 640;
 const unsigned short windowY = 480;
 const char* const windowName = "C++ Game"; //   c-string as GLFW doesn't like stl strings
+const bool gpuDrivenCulling = true; // cull with a compute shader and draw without the CPU touching objects, when the driver can
+const double tickRate = 60.0; // simulation steps per second, independent of the frame rate
+const unsigned int maxCatchUpTicks = 5; // most steps run in one frame after a stall
+const VSyncMode vsyncMode = VSYNC_ADAPTIVE; // tear instead of stalling a whole refresh when a frame runs late
+const double frameRateCap = 0.0; // frames per second, 0 leaves it to vsync (worth setting with vsync off)
+const bool lateInputSampling = true; // read input after waiting for the frame slot instead of before, less input lag
+const char* const levelPath = "assets/level.bin"; // F5 saves the level here (with a readable copy next to it), F9 loads it
+const char* const levelTextPath = "assets/level.txt";
+const char* const autosavePath = "assets/autosave.bin"; // picked up again after a crash if it was made on top of levelPath as it is
+const double autosaveInterval = 30.0; // seconds, each autosave only writes what changed since the last
+const size_t undoBudget = 16 * 1024 * 1024; // bytes of undo history, the oldest edits are forgotten past this
+const double undoCoalesceSeconds = 0.5; // a drag that pauses for longer than this undoes in two parts
+// the first of these that exists is the UI font, no font means no text. the repo doesn't ship one, any TTF works
+const char* const fontPaths[] = { "assets/fonts/font.ttf", "C:/Windows/Fonts/consola.ttf", "/usr/share/fonts/truetype/dejavu/DejaVuSansMono.ttf" };
+const bool gpuPicking = false; // clicks are answered from an object ID buffer read back from the GPU instead of a ray cast against the triangles
+const bool splitScreen = false; // a second, overhead view in the right half of the window, both are culled in one pass
+const bool renderOnThread = true; // GL on its own thread, overlapping with the next frame's simulation
+const bool softwareOcclusion = true; // CPU rasterized occlusion (same frame, same result on every driver) instead of the GPU hi-z readback
 // Constants //
 
 // Function Prototypes //
-void mouse_callback(GLFWwindow* window, double xpos, double ypos); // mouse input function
-void processInput(GLFWwindow* window);
+void processInput(SimulationState& state, float step, bool look);
+void simulate(SimulationState& state, float step, bool look); // advances the game by one fixed step, look turns the camera with the mouse
 // Function Prototypes //
 
 // global vars OH NO
-float yaw = -90.0f;
-float pitch = 0.0f;
-float lastX = 400;
-float lastY = 300; // stores the last mouse position (initialized to center of screen)
-bool firstMouse = true; // prevents jump when capturing cursor
-// Camera
-// we need to find relative (local?) axes for the camera
-glm::vec3 cameraPos = glm::vec3(0.0f, 0.0f, 3.0f);
-glm::vec3 cameraFront = glm::vec3(0.0f, 0.0f, -1.0f);
-glm::vec3 cameraUp = glm::vec3(0.0f, 1.0f, 0.0f);
 // Deltatime
 // this is used to adjust for the speed of different computers so that higher FPS doesn't make things faster
 float deltaTime = 0.0f;	// Time between current frame and last frame
@@ -57,18 +92,25 @@ int main() {
 	}
 
 	glfwMakeContextCurrent(window); // sets current opengl context to generated window
-	glfwSwapInterval(1); // v-sync
+	FramePacer framePacer; // v-sync and frame rate cap, the swap interval itself is set by whichever thread swaps
+	framePacer.Detect();
+	framePacer.SetVSync(vsyncMode);
+	framePacer.SetFrameCap(frameRateCap);
+	framePacer.SetLateInput(lateInputSampling);
 	// Window //
 
 	// GLAD //
 	if (!gladLoadGL(glfwGetProcAddress)) {
 		std::cout << "Failed to initialize GLAD" << std::endl;
 	}
+	GLStats::Get().Install(); // only does anything in a GL_INSTRUMENTATION build
+	GLCaps::Get().Detect();
 	// GLAD //
 
 	// Shaders //
 	Shader defaultShader("assets/shaders/default.vert", "assets/shaders/default.frag");
-	glUseProgram(defaultShader.ID);
+	glUseProgram(defaultShader.ID());
+	UniformBuffers uniformBuffers; // camera and per object transforms for every shader, see the blocks in default.vert
 	// Shaders // 
 
 	// Textures // 
@@ -86,18 +128,75 @@ int main() {
 	
 	// Misc //
 	glEnable(GL_DEPTH_TEST); // z layers
-	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED); // hides and captures the cursor
-	glfwSetCursorPosCallback(window, mouse_callback); // monitors mouse input
+	Input::Get().Attach(window); // key, mouse and cursor events get queued up for the simulation
+	Input::Get().Bind(ACTION_MOVE_FORWARD, Input::DEVICE_KEYBOARD, GLFW_KEY_W);
+	Input::Get().Bind(ACTION_MOVE_BACK, Input::DEVICE_KEYBOARD, GLFW_KEY_S);
+	Input::Get().Bind(ACTION_MOVE_LEFT, Input::DEVICE_KEYBOARD, GLFW_KEY_A);
+	Input::Get().Bind(ACTION_MOVE_RIGHT, Input::DEVICE_KEYBOARD, GLFW_KEY_D);
+	Input::Get().Bind(ACTION_SAVE_LEVEL, Input::DEVICE_KEYBOARD, GLFW_KEY_F5);
+	Input::Get().Bind(ACTION_LOAD_LEVEL, Input::DEVICE_KEYBOARD, GLFW_KEY_F9);
+	Input::Get().Bind(ACTION_TOGGLE_PLAY, Input::DEVICE_KEYBOARD, GLFW_KEY_P);
+	Input::Get().Bind(ACTION_UNDO, Input::DEVICE_KEYBOARD, GLFW_KEY_Z);
+	Input::Get().Bind(ACTION_REDO, Input::DEVICE_KEYBOARD, GLFW_KEY_Y);
+	Input::Get().Bind(ACTION_SELECT, Input::DEVICE_MOUSE, GLFW_MOUSE_BUTTON_LEFT);
+	Input::Get().Bind(ACTION_LOOK, Input::DEVICE_MOUSE, GLFW_MOUSE_BUTTON_RIGHT);
+	Input::Get().Bind(ACTION_TOGGLE_HUD, Input::DEVICE_KEYBOARD, GLFW_KEY_F3);
 	// Misc //
 
 	/*\\\\\\\\\\\\\\\\\\******************** Initialization ********************\\\\\\\\\\\\\\\\\\*/
 	////////////////////--------------------------------------------------------////////////////////
-	Model defaultModel("assets/models/turtle.obj");
+	Scene scene;
+	scene.uniforms = &uniformBuffers;
+	if (!std::ifstream(levelPath) || !LevelFile::Load(scene, levelPath)) { // nothing saved yet, start with the test level
+		unsigned int turtleModel = scene.LoadModel("assets/models/turtle.obj");
+		scene.Create(turtleModel, TransformComponent(glm::vec3(0.0f, 0.0f, 0.0f)));
+	}
+	std::vector<TransformComponent> recovered;
+	if (Autosave::Recover(autosavePath, levelPath, recovered) && recovered.size() == scene.Size()) {
+		unsigned int moved = 0;
+		for (GameObject object = 0; object < scene.Size(); object++) {
+			if (recovered[object] != scene.transforms[object]) {
+				scene.SetTransform(object, recovered[object]);
+				moved++;
+			}
+		}
+		std::cout << "Recovered " << moved << " changed objects from the autosave" << std::endl;
+	}
+
+	// Occlusion // 
+	// skips objects hidden behind RENDER_OCCLUDER objects. the hi-z pyramid (its shaders, depth texture and framebuffer)
+	// is only made when something reads it, GPU occlusion on the CPU path or the GPU culling pass
+	bool gpuCulling = gpuDrivenCulling && GPUCulling::Supported();
+	std::unique_ptr<HiZOcclusion> gpuOcclusion;
+	if (!softwareOcclusion || gpuCulling) {
+		gpuOcclusion.reset(new HiZOcclusion());
+	}
+	SoftwareOcclusion cpuOcclusion;
+	if (softwareOcclusion) {
+		scene.occlusion = &cpuOcclusion;
+	}
+	else {
+		scene.occlusion = gpuOcclusion.get();
+	}
+	// Occlusion // 
+
+	// Indirect Drawing //
+	// one multi-draw call for the whole scene on GL 4.3+, otherwise the scene keeps drawing model by model
+	std::unique_ptr<IndirectRenderer> indirectRenderer;
+	if (IndirectRenderer::Supported()) {
+		indirectRenderer.reset(new IndirectRenderer());
+		scene.indirect = indirectRenderer.get();
+	}
+	std::unique_ptr<GPUCulling> gpuCuller;
+	if (gpuCulling) {
+		gpuCuller.reset(new GPUCulling(*indirectRenderer, gpuOcclusion.get())); // tests against the hi-z pyramid on the GPU
+		scene.gpuCulling = gpuCuller.get();
+	}
+	// Indirect Drawing //
 
 	// Texture //
-	unsigned int texture;
-	glGenTextures(1, &texture);
-	glBindTexture(GL_TEXTURE_2D, texture); // all upcoming GL_TEXTURE_2D operations now have effect on this texture object
+	GLTexture texture = GLTexture::Create("assets/textures/container.jpg");
+	glBindTexture(GL_TEXTURE_2D, texture.ID()); // all upcoming GL_TEXTURE_2D operations now have effect on this texture object
 	// load image, create texture and generate mipmaps
 	int width, height, nrChannels;
 	stbi_set_flip_vertically_on_load(true); // flips it the right way up since GL expects y = 0.0 to be bottom, images tend to have it top!
@@ -107,6 +206,7 @@ int main() {
 		// generate texture
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
 		glGenerateMipmap(GL_TEXTURE_2D); // mipmaps are smaller versions of the texture that get viewed from a distance
+		GPUResourceRegistry::Get().SetBytes(GPUResourceType::Texture, texture.ID(), (size_t)width * height * 3 * 4 / 3); // the mip chain adds roughly a third
 	}
 	else
 	{
@@ -120,134 +220,526 @@ int main() {
  // scale the cube
 	//model = glm::translate(model, glm::vec3(0.0f, 0.3f, 0.0f)); // move it up
 	
-	glm::mat4 projection;
-	projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
-
-	glm::mat4 view;
-	view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
+	Camera camera(45.0f, 0.1f, 100.0f); // drawn from a blend of the last two simulation steps, see the render loop
+	camera.SetPosition(glm::vec3(0.0f, 0.0f, 3.0f));
+	Camera overviewCamera(45.0f, 0.1f, 100.0f); // looks down on the level from above and behind, for splitScreen
+	overviewCamera.SetPosition(glm::vec3(0.0f, 15.0f, 15.0f));
+	overviewCamera.SetRotation(-90.0f, -45.0f);
 	// Coordinate Systems //
 
 	/*\\\\\\\\\\\\\\\\\\********************   Render Loop  ********************\\\\\\\\\\\\\\\\\\*/
 	////////////////////--------------------------------------------------------////////////////////
-	float rValue = 0.2; // will be used to make background a pulsing blue color
-	float gValue = 0.3;
-	float bValue = 0.4;
-	bool rise = true;
+	// Simulation //
+	SimulationState currentState;
+	currentState.cameraPosition = camera.Position();
+	currentState.yaw = camera.Yaw();
+	currentState.pitch = camera.Pitch();
+	currentState.backgroundColor = glm::vec3(0.2f, 0.3f, 0.4f); // will be used to make background a pulsing blue color
+	currentState.backgroundRising = true;
+	currentState.transforms.Assign(scene.transforms); // the scene belongs to the render thread from here on
+	SimulationState previousState = currentState;
+	bool playing = false; // design mode otherwise
+	SimulationState designState; // the level as it was when play mode started, shares every chunk play hasn't touched
+	FixedTimestep timestep(tickRate, maxCatchUpTicks);
+	std::vector<unsigned char> movingChunks;
+	Autosave autosave; // writes on its own thread, the loop only hands it a snapshot
+	autosave.Start(autosavePath, levelPath, autosaveInterval);
+	UndoJournal undoJournal(undoBudget, undoCoalesceSeconds); // design mode edits, record them with a snapshot from before
+	// Simulation //
+
+	// Editing //
+	// design mode has a free cursor (captured only while ACTION_LOOK is held, and always while playing). clicking asks
+	// the render thread what's under it, and once the answer is back dragging moves the object across the view at the
+	// depth it was grabbed
+	ObjectPicker picker(gpuPicking ? ObjectPicker::PICK_GPU : ObjectPicker::PICK_CPU);
+	bool cursorCaptured = false;
+	int windowWidth = windowX; // window pixels, which the cursor is in (the framebuffer can be bigger)
+	int windowHeight = windowY;
+	unsigned int lastPick = 0; // id of the newest pick, older answers are ignored
+	GameObject selected = noObject;
+	bool dragging = false;
+	float dragDistance = 0.0f; // how far from the camera the selection was grabbed
+	const uint32_t dragUndoTag = 1; // a drag's steps undo together
+	const uint32_t propertyUndoTag = 2; // and so do a property slider's
+	UIAtlas uiAtlas;
+	UIContext ui(uiAtlas); // built here every frame, drawn by the render thread
+	Font uiFont(uiAtlas);
+	for (const char* fontPath : fontPaths) {
+		if (uiFont.Load(fontPath)) {
+			break;
+		}
+	}
+	if (uiFont.Loaded()) {
+		ui.SetFont(&uiFont);
+	}
+	else {
+		std::cout << "Error: no font found, put a TrueType font at " << fontPaths[0] << " for text" << std::endl;
+	}
+	UIRenderer uiRenderer;
+	PerfHUD perfHUD; // F3
+	GPUTimer gpuFrameTimer("gpu.frame"); // everything the render thread draws in a frame
+	DebugDraw debugDraw; // lines from the simulation side (any thread), collected into each frame's commands
+	DebugDraw renderDebugDraw; // lines from the render side, collected right before they're drawn
+	DebugRenderer debugRenderer;
+	PickRequest pickRay; // the last pick and where it hit, for DEBUG_PICKING
+	PickResult pickHit = {};
+	bool uiActions[ACTION_COUNT] = {}; // buttons standing in for keys, they count as pressed in the next frame's first step
+	bool propertyEdited = false; // the property sliders moved, applied in the next frame's first step the same way
+	GameObject propertyObject = noObject;
+	TransformComponent propertyEdit;
+	bool mousePressed = false; // since the UI last looked
+	bool mouseReleased = false;
+	// Editing //
+
+	// Render Thread //
+	// from here on only the render thread touches GL and the scene, this loop just describes each frame to it
+	RenderThread renderThread;
+	std::vector<std::vector<GameObject>> viewObjects; // what each view can see, only used on the render thread
+	renderThread.Start(window, [&](RenderCommandList& commands) {
+		for (const RenderCommandList::TransformChange& change : commands.transformChanges) {
+			scene.SetTransform(change.object, change.transform);
+		}
+		// the autosave is only dropped once the level file really holds everything it had
+		if (commands.levelRequest == LEVEL_SAVE) {
+			if (LevelFile::Save(scene, levelPath)) {
+				autosave.LevelChanged();
+			}
+			LevelFile::ExportText(scene, levelTextPath);
+		}
+		else if (commands.levelRequest == LEVEL_LOAD) {
+			if (LevelFile::Load(scene, levelPath)) {
+				autosave.LevelChanged();
+			}
+		}
 
-	
+		// Debug Lines //
+		// every object's bounds, split over the job system with a batch per chunk, then whatever else this side drew
+		if (DebugDraw::Enabled(DEBUG_BOUNDS)) {
+			const uint32_t boundsColor = UIColor(0.2f, 0.9f, 0.9f);
+			JobSystem::Get().ParallelFor(scene.Size(), 4096, [&](unsigned int begin, unsigned int end, unsigned int thread) {
+				DebugDraw::Batch batch(renderDebugDraw, DEBUG_BOUNDS);
+				for (unsigned int object = begin; object < end; object++) {
+					batch.Box(scene.worldBounds[object], boundsColor);
+				}
+			});
+		}
+		renderDebugDraw.Collect(commands.debug);
+		debugRenderer.Upload(commands.debug); // once, every view draws from the same copy
+		// Debug Lines //
 
-	while (!glfwWindowShouldClose(window)) 
-	{
-		// Misc //
+		gpuFrameTimer.Begin();
+		glViewport(0, 0, commands.width, commands.height); // clear the whole window, each view then draws into its own part
+		glClearColor(commands.clearColor.x, commands.clearColor.y, commands.clearColor.z, commands.clearColor.w);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // ensures z-order is drawn right
-		processInput(window); // monitors key input
-		// Misc //
-
-		// Viewport //
-		int width, height;
-		glfwGetFramebufferSize(window, &width, &height); // auto-adjusts if user resizes window
-		glViewport(0, 0, width, height); // a single viewport filling the window
-		// Viewport //
 
-		// Background //
-		glClearColor(rValue, gValue, bValue, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT);
-		if (rise == true) {
-			rValue += 0.01;
-			gValue += 0.01;
-			bValue += 0.01;
-			if (bValue >= 0.95) {
-				rise = false;
-			}
+		if (commands.views.size() == 1) {
+			const RenderCommandList::View& view = commands.views[0];
+			glViewport(view.x, view.y, view.width, view.height);
+			uniformBuffers.SetFrame(view.frame); // one upload covers every shader that uses the FrameData block
+			scene.Draw(defaultShader, view.viewProjection); // anything outside the camera's view gets skipped
+			debugRenderer.Draw(view.viewProjection);
 		}
-		else {
-			rValue -= 0.01;
-			gValue -= 0.01;
-			bValue -= 0.01;
-			if (bValue <= 0.05) {
-				rise = true;
+		else if (!commands.views.empty()) {
+			// every view is culled in one walk of the BVH, so objects more than one of them sees are only tested once.
+			// the GPU culling and occlusion paths only know about one camera, they sit this out
+			Frustum frusta[BVH::maxFrusta];
+			unsigned int viewCount = std::min((unsigned int)commands.views.size(), BVH::maxFrusta);
+			for (unsigned int view = 0; view < viewCount; view++) {
+				frusta[view] = commands.views[view].frustum;
+			}
+			scene.CullViews(frusta, viewCount, viewObjects);
+			for (unsigned int view = 0; view < viewCount; view++) {
+				const RenderCommandList::View& current = commands.views[view];
+				glViewport(current.x, current.y, current.width, current.height);
+				uniformBuffers.SetFrame(current.frame);
+				scene.DrawObjects(defaultShader, viewObjects[view], current.viewProjection);
+				debugRenderer.Draw(current.viewProjection);
 			}
 		}
-		// Background //
+		uiRenderer.Upload(commands.uiUploads);
+		uiRenderer.Draw(commands.ui, commands.width, commands.height);
+		picker.Process(scene, commands.pick); // after drawing, so the frame isn't held up behind it
+		gpuFrameTimer.End();
+		uniformBuffers.EndFrame(); // this frame's constants are fenced from here on
+		uiRenderer.EndFrame();
+		debugRenderer.EndFrame();
+		GLStats::Get().EndFrame();
+	}, renderOnThread);
+	// Render Thread //
+
+	Profiler::Get().reportInterval = 5.0; // print frame stats to the console every few seconds
+
+	while (!glfwWindowShouldClose(window)) 
+	{
+		framePacer.BeginFrame(); // waits for this frame's slot when the frame rate is capped
+		Profiler::Get().BeginFrame();
+		RenderCommandList& commands = renderThread.Commands();
+
+		// Input //
+		if (framePacer.LateInput()) {
+			glfwPollEvents(); // right before the simulation reads it, so it didn't sit through the wait
+		}
+		// Input //
+
+		// Viewport //
+		glfwGetFramebufferSize(window, &commands.width, &commands.height); // auto-adjusts if user resizes window
+		glfwGetWindowSize(window, &windowWidth, &windowHeight);
+		// Viewport //
 	
 		// Delta Time //	
 		float currentFrame = glfwGetTime();
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
 		// Delta Time //	
-	
-		// Draw //
 
-		defaultModel.Draw(defaultShader);
+		// Simulation //
+		// the game moves in fixed steps, what gets drawn is blended between the last two so motion stays smooth
+		// whether frames come faster or slower than the steps
+		// Picking //
+		// picks are answered on the render thread, a frame or a few later. a drag starts once the grabbed object is
+		// known, if the button is still down by then
+		PickResult pickResult;
+		if (picker.Poll(pickResult) && pickResult.request == lastPick && !playing) {
+			pickHit = pickResult;
+			selected = pickResult.object;
+			dragDistance = pickResult.distance;
+			dragging = selected != noObject && Input::Get().Held(ACTION_SELECT);
+			if (selected != noObject) {
+				std::cout << "Selected object " << selected << " (" << dragDistance << " away)" << std::endl;
+			}
+		}
+		// turns a cursor position (window pixels from the top left) into a pick in whichever view it's over
+		auto pickAt = [&](const glm::vec2& cursor) {
+			if (windowWidth == 0 || windowHeight == 0 || commands.width == 0 || commands.height == 0) {
+				return PickRequest(); // minimized
+			}
+			glm::vec2 pixel = cursor * glm::vec2((float)commands.width / windowWidth, (float)commands.height / windowHeight);
+			pixel.y = commands.height - pixel.y; // framebuffer pixels from the bottom left, like the views
+			int viewWidth = splitScreen ? commands.width / 2 : commands.width;
+			bool mainView = pixel.x < viewWidth;
+			glm::vec2 viewOrigin(mainView ? 0.0f : (float)viewWidth, 0.0f);
+			glm::vec2 viewSize(mainView ? (float)viewWidth : (float)(commands.width - viewWidth), (float)commands.height);
+			glm::vec2 ndc = (pixel - viewOrigin) / viewSize * 2.0f - 1.0f;
+			return ObjectPicker::Request(++lastPick, (mainView ? camera : overviewCamera).ViewProjection(), ndc, 2.0f / viewSize);
+		};
+		// Picking //
+
+		auto pressed = [&](InputAction action, unsigned int tick) { return Input::Get().Pressed(action) || (tick == 0 && uiActions[action]); };
+		unsigned int ticks = timestep.Advance(deltaTime);
+		float alpha = timestep.Alpha();
+		double now = glfwGetTime();
+		for (unsigned int tick = 0; tick < ticks; tick++) {
+			// each step only sees the input that arrived before the moment it ends, the newest one ends alpha steps ago
+			double stepEnd = now - (ticks - 1 - tick + alpha) * timestep.Step();
+			Input::Get().Update(stepEnd);
+			mousePressed = mousePressed || Input::Get().Pressed(ACTION_SELECT);
+			mouseReleased = mouseReleased || Input::Get().Released(ACTION_SELECT);
+			if (pressed(ACTION_SAVE_LEVEL, tick)) {
+				if (playing) {
+					std::cout << "Stop playing (P) before saving, the level is mid-game" << std::endl;
+				}
+				else {
+					commands.levelRequest = LEVEL_SAVE;
+				}
+			}
+			if (pressed(ACTION_LOAD_LEVEL, tick)) {
+				commands.levelRequest = LEVEL_LOAD;
+			}
+			if (pressed(ACTION_TOGGLE_HUD, tick)) {
+				perfHUD.visible = !perfHUD.visible;
+			}
+
+			// Play Mode //
+			// starting takes a copy of the level that shares all of its chunks, stopping swaps it back and only
+			// sends the render thread the chunks play actually changed
+			if (pressed(ACTION_TOGGLE_PLAY, tick)) {
+				ScopedTimer timer("sim.playToggle");
+				if (!playing) {
+					designState = currentState;
+					std::cout << "Play mode" << std::endl;
+				}
+				else {
+					ResyncTransforms(currentState, designState, commands.transformChanges);
+					currentState = designState;
+					designState = SimulationState(); // lets go of the design chunks, otherwise later edits would still copy them
+					std::cout << "Design mode" << std::endl;
+				}
+				playing = !playing;
+				undoJournal.EndCoalescing();
+				dragging = false;
+			}
+			// Play Mode //
+
+			// Undo //
+			// the journal edits the transforms in place, only the chunks it touched get sent to the render thread
+			bool undo = pressed(ACTION_UNDO, tick);
+			if (!playing && (undo || pressed(ACTION_REDO, tick))) {
+				SimulationState before = currentState;
+				if (undo ? undoJournal.Undo(currentState.transforms) : undoJournal.Redo(currentState.transforms)) {
+					ResyncTransforms(before, currentState, commands.transformChanges);
+				}
+			}
+			// Undo //
+
+			// Editing //
+			if (!playing) {
+				if (propertyEdited && propertyObject < currentState.transforms.Size()) {
+					// before previousState is copied below, so both states agree and the blend can't pull the object back
+					TransformChunks before = currentState.transforms;
+					currentState.transforms.Edit(propertyObject) = propertyEdit;
+					undoJournal.Record(before, currentState.transforms, propertyUndoTag, stepEnd);
+					commands.transformChanges.push_back({ propertyObject, propertyEdit });
+				}
+				if (Input::Get().Pressed(ACTION_SELECT) && !Input::Get().Held(ACTION_LOOK) && !ui.WantsMouse()) {
+					commands.pick = pickAt(Input::Get().CursorPosition());
+					pickRay = commands.pick;
+					dragging = false; // until this pick comes back
+				}
+				glm::vec2 drag = Input::Get().MouseDelta();
+				if (dragging && Input::Get().Held(ACTION_SELECT) && (drag.x != 0.0f || drag.y != 0.0f)) {
+					// world units per window pixel at the depth the object was grabbed
+					float scale = 2.0f * dragDistance / (camera.Projection()[1][1] * std::max(windowHeight, 1));
+					glm::vec3 right = glm::normalize(glm::cross(camera.Front(), Camera::worldUp));
+					glm::vec3 up = glm::cross(right, camera.Front());
+					TransformChunks before = currentState.transforms;
+					currentState.transforms.Edit(selected).position += (right * drag.x + up * drag.y) * scale;
+					undoJournal.Record(before, currentState.transforms, dragUndoTag, stepEnd);
+					commands.transformChanges.push_back({ selected, currentState.transforms[selected] });
+				}
+				if (Input::Get().Released(ACTION_SELECT)) {
+					dragging = false;
+					undoJournal.EndCoalescing();
+				}
+			}
+			propertyEdited = false;
+			// Editing //
 
-		// Draw //
+			previousState = currentState;
+			simulate(currentState, timestep.Step(), playing || Input::Get().Held(ACTION_LOOK));
+		}
 
-		// Send Coordinate Systems to Shaders //
-		int projectionLoc = glGetUniformLocation(defaultShader.ID, "projection");
-		glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
+		if (ticks > 0) {
+			std::fill(uiActions, uiActions + ACTION_COUNT, false);
+		}
 
-		view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp); // changed by mouse/key input
-		int viewLoc = glGetUniformLocation(defaultShader.ID, "view");
-		glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
+		// Cursor //
+		// GLFW only allows this on the main thread, which is why it isn't left to the simulation
+		bool captureCursor = playing || Input::Get().Held(ACTION_LOOK);
+		if (captureCursor != cursorCaptured) {
+			glfwSetInputMode(window, GLFW_CURSOR, captureCursor ? GLFW_CURSOR_DISABLED : GLFW_CURSOR_NORMAL); // hides and captures the cursor for looking around
+			cursorCaptured = captureCursor;
+		}
+		// Cursor //
+		camera.SetPosition(glm::mix(previousState.cameraPosition, currentState.cameraPosition, alpha));
+		camera.SetRotation(glm::mix(previousState.yaw, currentState.yaw, alpha), glm::mix(previousState.pitch, currentState.pitch, alpha));
+		commands.clearColor = glm::vec4(glm::mix(previousState.backgroundColor, currentState.backgroundColor, alpha), 1.0f);
+		InterpolateTransforms(previousState, currentState, alpha, movingChunks, commands.transformChanges);
+		autosave.Update(playing ? designState.transforms : currentState.transforms, deltaTime); // never saves a level mid-game
+		// Simulation //
+
+		// Editor UI //
+		// design mode's panel. buttons stand in for the keys and the property sliders queue an edit of the selection, both
+		// are picked up by the next frame's first step. the performance HUD goes over it in any mode
+		ui.BeginFrame(commands.ui, glm::vec2((float)windowWidth, (float)windowHeight), Input::Get().CursorPosition(),
+			Input::Get().Held(ACTION_SELECT) && !cursorCaptured, mousePressed && !cursorCaptured, mouseReleased);
+		mousePressed = false;
+		mouseReleased = false;
+		if (!playing) {
+			ui.BeginPanel("editor", glm::vec2(10.0f, 10.0f), 180.0f);
+			uiActions[ACTION_TOGGLE_PLAY] |= ui.Button("Play");
+			uiActions[ACTION_SAVE_LEVEL] |= ui.Button("Save");
+			uiActions[ACTION_LOAD_LEVEL] |= ui.Button("Load");
+			uiActions[ACTION_UNDO] |= ui.Button("Undo");
+			uiActions[ACTION_REDO] |= ui.Button("Redo");
+			ui.Separator();
+			for (int category = 0; category < DEBUG_CATEGORY_COUNT; category++) {
+				bool enabled = DebugDraw::Enabled((DebugCategory)category);
+				if (ui.Checkbox(std::string("show ") + DebugCategoryName((DebugCategory)category), enabled)) {
+					DebugDraw::SetEnabled((DebugCategory)category, enabled);
+				}
+			}
+			if (selected != noObject && selected < currentState.transforms.Size()) {
+				ui.Separator();
+				// an edit still waiting for a step is what the sliders show, so moving another one doesn't lose it
+				TransformComponent transform = propertyEdited && propertyObject == selected ? propertyEdit : currentState.transforms[selected];
+				const char* const axes[] = { "x", "y", "z" };
+				bool changed = false;
+				for (int axis = 0; axis < 3; axis++) {
+					changed |= ui.Slider(std::string("position ") + axes[axis], transform.position[axis], -50.0f, 50.0f);
+				}
+				for (int axis = 0; axis < 3; axis++) {
+					changed |= ui.Slider(std::string("rotation ") + axes[axis], transform.rotation[axis], 0.0f, 360.0f);
+				}
+				for (int axis = 0; axis < 3; axis++) {
+					changed |= ui.Slider(std::string("scale ") + axes[axis], transform.scale[axis], 0.1f, 10.0f);
+				}
+				if (changed) {
+					propertyEdited = true;
+					propertyObject = selected;
+					propertyEdit = transform;
+				}
+			}
+			ui.EndPanel();
+		}
+		perfHUD.Record();
+		perfHUD.Draw(ui, glm::vec2((float)windowWidth, (float)windowHeight));
+		ui.EndFrame();
+		uiAtlas.TakeUploads(commands.uiUploads);
+		// Editor UI //
+	
 		// Send Coordinate Systems to Shaders //
-		
-		
-		
+		// done before drawing so the frame uses this frame's camera rather than last frame's. the cameras only rebuild
+		// the matrices that changed, their aspect follows the part of the framebuffer they draw into
+		auto addView = [&](const Camera& viewCamera, int x, int width) {
+			RenderCommandList::View view;
+			view.frame.view = viewCamera.View();
+			view.frame.projection = viewCamera.Projection();
+			view.frame.cameraPosition = glm::vec4(viewCamera.Position(), 1.0f);
+			view.frame.time = glm::vec4(currentFrame, deltaTime, 0.0f, 0.0f);
+			view.viewProjection = viewCamera.ViewProjection();
+			view.frustum = viewCamera.ViewFrustum();
+			view.x = x;
+			view.y = 0;
+			view.width = width;
+			view.height = commands.height;
+			commands.views.push_back(view);
+		};
+		int viewWidth = splitScreen ? commands.width / 2 : commands.width;
+		camera.SetViewport(viewWidth, commands.height);
+		addView(camera, 0, viewWidth);
+		if (splitScreen) {
+			overviewCamera.SetViewport(commands.width - viewWidth, commands.height);
+			addView(overviewCamera, viewWidth, commands.width - viewWidth);
+		}
+		// Send Coordinate Systems to Shaders //
+
+		// Debug Lines //
+		// the selection's axes and the last pick in design mode, the main camera's frustum when there's another view to see it from
+		if (!playing) {
+			if (selected != noObject && selected < currentState.transforms.Size()) {
+				debugDraw.Axes(currentState.transforms[selected].Matrix(), 1.0f);
+			}
+			if (pickRay.active) {
+				DebugDraw::Batch batch(debugDraw, DEBUG_PICKING);
+				bool hit = pickHit.request == pickRay.id && pickHit.object != noObject;
+				uint32_t color = hit ? UIColor(1.0f, 0.8f, 0.2f) : UIColor(0.6f, 0.6f, 0.6f);
+				batch.Line(pickRay.origin, pickRay.origin + pickRay.direction * (hit ? pickHit.distance : pickRay.maxDistance), color);
+				if (hit) {
+					batch.Sphere(pickHit.position, 0.1f, color);
+				}
+			}
+		}
+		if (splitScreen) {
+			debugDraw.Frustum(camera.ViewProjection(), UIColor(1.0f, 1.0f, 0.4f));
+		}
+		debugDraw.Collect(commands.debug);
+		// Debug Lines //
+
 		// Update //
-		glfwSwapBuffers(window);
-		glfwPollEvents();
+		commands.swapInterval = framePacer.SwapInterval();
+		bool levelLoading = commands.levelRequest == LEVEL_LOAD;
+		renderThread.Submit(); // drawn while the next frame is simulated
+		if (levelLoading) {
+			// the simulation carries on from whatever was loaded, so it has to wait for the load and take the objects over
+			renderThread.WaitIdle();
+			currentState.transforms.Assign(scene.transforms);
+			previousState.transforms = currentState.transforms;
+			movingChunks.clear();
+			undoJournal.Clear();
+			selected = noObject;
+			propertyEdited = false;
+			dragging = false;
+			if (playing) { // the loaded level is the new design state
+				playing = false;
+				designState = SimulationState();
+				std::cout << "Design mode" << std::endl;
+			}
+		}
+		if (!framePacer.LateInput()) {
+			glfwPollEvents();
+		}
+		Profiler::Get().EndFrame();
 		// Update //
 	}
+	renderThread.Stop(); // the context comes back to this thread for cleanup
+	autosave.Stop();
+	Autosave::Discard(autosavePath); // a clean exit, the autosave is only there for crashes
 	/*\\\\\\\\\\\\\\\\\\********************   Render Loop  ********************\\\\\\\\\\\\\\\\\\*/
 	////////////////////--------------------------------------------------------////////////////////
 
+	// Cleanup //
+	// GL objects have to be freed while the context still exists, so don't leave it to the destructors
+	scene.Unload();
+	if (gpuOcclusion) {
+		gpuOcclusion->Unload();
+	}
+	picker.Unload();
+	uiRenderer.Unload();
+	gpuFrameTimer.Unload();
+	debugRenderer.Unload();
+	if (gpuCuller) {
+		gpuCuller->Unload();
+	}
+	if (indirectRenderer) {
+		indirectRenderer->Unload();
+	}
+	JobSystem::Get().Shutdown();
+	texture.Reset();
+	uniformBuffers.Unload();
+	defaultShader.Unload();
+	GPUResourceRegistry::Get().Report(); // anything still listed here has leaked
+	if (GLStats::Available()) {
+		GLStats::Get().WriteJSON("glstats.json");
+	}
+	// Cleanup //
+
 	glfwDestroyWindow(window);
 	return EXIT_SUCCESS;
 }
 
-void processInput(GLFWwindow* window) {
-	const float cameraSpeed = 2.5f * deltaTime; // adjust accordingly
-	glm::vec3 limit = {cameraFront.x, 0.0f, cameraFront.z}; // limits y movement
-	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-		cameraPos += cameraSpeed * limit; // cameraFront is the direction vector
-	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-		cameraPos -= cameraSpeed * limit;
-	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-		cameraPos -= glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed; // the vectors for strafing are normalized so that the camera orientation doesn't affect speed
-	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-		cameraPos += glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed;	
-}
+void simulate(SimulationState& state, float step, bool look) {
+	processInput(state, step, look); // applies this step's input
 
-void mouse_callback(GLFWwindow* window, double xpos, double ypos) { // automatically run each time the mouse moves
-	
-	if (firstMouse) // initially set to true 
-	{
-		lastX = xpos;
-		lastY = ypos;
-		firstMouse = false;
+	// Background //
+	if (state.backgroundRising == true) {
+		state.backgroundColor += glm::vec3(0.01f);
+		if (state.backgroundColor.z >= 0.95) {
+			state.backgroundRising = false;
+		}
 	}
+	else {
+		state.backgroundColor -= glm::vec3(0.01f);
+		if (state.backgroundColor.z <= 0.05) {
+			state.backgroundRising = true;
+		}
+	}
+	// Background //
+}
 
-	float xoffset = xpos - lastX;
-	float yoffset = lastY - ypos; // reversed since y-coordinates range from bottom to top
-	lastX = xpos;
-	lastY = ypos;
-
+void processInput(SimulationState& state, float step, bool look) {
+	// Look //
 	const float sensitivity = 0.1f;
-	xoffset *= sensitivity;
-	yoffset *= sensitivity;
-
-	yaw += xoffset;
-	pitch += yoffset;
-
-	if (pitch > 89.0f) // constraints the pitch so you can look directly up and directly down but not break your neck
-		pitch = 89.0f;
-	if (pitch < -89.0f)
-		pitch = -89.0f;
-
-	// by using triangles, we can calculate angles from coordinates by treating them as triangles
-	glm::vec3 direction;
-	direction.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
-	direction.y = sin(glm::radians(pitch));
-	direction.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
-	cameraFront = glm::normalize(direction);
-}
\ No newline at end of file
+	glm::vec2 offset = look ? Input::Get().MouseDelta() * sensitivity : glm::vec2(0.0f); // everything the mouse moved during this step
+	state.yaw += offset.x;
+	state.pitch += offset.y;
+
+	if (state.pitch > 89.0f) // constraints the pitch so you can look directly up and directly down but not break your neck
+		state.pitch = 89.0f;
+	if (state.pitch < -89.0f)
+		state.pitch = -89.0f;
+	// Look //
+
+	// Move //
+	const float cameraSpeed = 2.5f * step; // adjust accordingly
+	glm::vec3 front = Camera::Direction(state.yaw, state.pitch);
+	glm::vec3 limit = {front.x, 0.0f, front.z}; // limits y movement
+	if (Input::Get().Held(ACTION_MOVE_FORWARD))
+		state.cameraPosition += cameraSpeed * limit; // front is the direction vector
+	if (Input::Get().Held(ACTION_MOVE_BACK))
+		state.cameraPosition -= cameraSpeed * limit;
+	if (Input::Get().Held(ACTION_MOVE_LEFT))
+		state.cameraPosition -= glm::normalize(glm::cross(front, Camera::worldUp)) * cameraSpeed; // the vectors for strafing are normalized so that the camera orientation doesn't affect speed
+	if (Input::Get().Held(ACTION_MOVE_RIGHT))
+		state.cameraPosition += glm::normalize(glm::cross(front, Camera::worldUp)) * cameraSpeed;
+	// Move //
+}
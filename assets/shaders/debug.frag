@@ -0,0 +1,7 @@
+#version 330 compatibility
+in vec4 color;
+out vec4 FragColor;
+void main()
+{
+	FragColor = color;
+}
\ No newline at end of file
@@ -0,0 +1,10 @@
+#version 330 compatibility
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec4 aColor; // normalized from RGBA8
+out vec4 color;
+uniform mat4 viewProjection;
+void main()
+{
+	color = aColor;
+	gl_Position = viewProjection * vec4(aPos, 1.0);
+};
\ No newline at end of file
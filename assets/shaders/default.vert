@@ -3,9 +3,15 @@ layout(location = 0) in vec3 aPos;
 layout(location = 1) in vec3 aNormal;
 layout(location = 2) in vec2 aTexCoord;
 out vec2 TexCoord;
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+layout(std140) uniform FrameData { // FrameUniforms, set once per frame
+	mat4 view;
+	mat4 projection;
+	vec4 cameraPosition;
+	vec4 time;
+};
+layout(std140) uniform ObjectData { // ObjectUniforms, one slot per draw
+	mat4 model;
+};
 void main()
 {
 	gl_Position = projection * view * model * vec4(aPos, 1.0);
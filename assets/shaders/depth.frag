@@ -0,0 +1,5 @@
+#version 330 compatibility
+void main()
+{
+	// no colour output, only the depth buffer is written
+}
\ No newline at end of file
@@ -0,0 +1,8 @@
+#version 330 compatibility
+layout(location = 0) in vec3 aPos;
+uniform mat4 model;
+uniform mat4 viewProjection;
+void main()
+{
+	gl_Position = viewProjection * model * vec4(aPos, 1.0); // depth only, nothing else is needed
+};
\ No newline at end of file
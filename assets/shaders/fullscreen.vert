@@ -0,0 +1,7 @@
+#version 330 compatibility
+void main()
+{
+	// one triangle big enough to cover the whole screen, built from the vertex number so no vertex buffer is needed
+	vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+	gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
+};
\ No newline at end of file
@@ -0,0 +1,12 @@
+#version 330 compatibility
+uniform sampler2D previousLevel; // the depth pyramid, its base level is the one above the level being written
+void main()
+{
+	// every texel of this level covers 2x2 texels of the previous one, keep the furthest depth so the test stays conservative
+	ivec2 texel = ivec2(gl_FragCoord.xy) * 2;
+	float depth00 = texelFetch(previousLevel, texel, 0).r;
+	float depth10 = texelFetch(previousLevel, texel + ivec2(1, 0), 0).r;
+	float depth01 = texelFetch(previousLevel, texel + ivec2(0, 1), 0).r;
+	float depth11 = texelFetch(previousLevel, texel + ivec2(1, 1), 0).r;
+	gl_FragDepth = max(max(depth00, depth10), max(depth01, depth11));
+}
@@ -0,0 +1,7 @@
+#version 330 compatibility
+layout(location = 0) out uint id;
+uniform uint objectID;
+void main()
+{
+	id = objectID; // object + 1, the target is cleared to 0 for nothing
+}
\ No newline at end of file
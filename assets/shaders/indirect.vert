@@ -0,0 +1,20 @@
+#version 430 compatibility
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in vec2 aTexCoord;
+layout(location = 3) in uint aDrawID; // per instance attribute, baseInstance makes it the index of the draw command
+layout(std430, binding = 0) readonly buffer Transforms {
+	mat4 transforms[]; // one model matrix per draw command
+};
+out vec2 TexCoord;
+layout(std140) uniform FrameData { // FrameUniforms, set once per frame
+	mat4 view;
+	mat4 projection;
+	vec4 cameraPosition;
+	vec4 time;
+};
+void main()
+{
+	gl_Position = projection * view * transforms[aDrawID] * vec4(aPos, 1.0);
+	TexCoord = aTexCoord;
+};
\ No newline at end of file
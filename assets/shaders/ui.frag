@@ -0,0 +1,19 @@
+#version 330 compatibility
+in vec2 texCoord;
+in vec4 color;
+in float sdf;
+out vec4 FragColor;
+uniform sampler2D atlas;
+void main()
+{
+	vec4 texel = texture(atlas, texCoord);
+	if (sdf > 0.5) {
+		// text: alpha is the distance from the glyph outline, 0.5 right on it. fwidth is how much it changes across a
+		// pixel, so the edge stays about a pixel soft however big the text is drawn
+		float smoothing = max(fwidth(texel.a) * 0.7, 0.0001);
+		FragColor = vec4(color.rgb, color.a * smoothstep(0.5 - smoothing, 0.5 + smoothing, texel.a));
+	}
+	else {
+		FragColor = texel * color; // solid quads sample a white corner of the atlas
+	}
+}
\ No newline at end of file
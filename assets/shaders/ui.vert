@@ -0,0 +1,16 @@
+#version 330 compatibility
+layout(location = 0) in vec2 aPos;
+layout(location = 1) in vec2 aTexCoord;
+layout(location = 2) in vec4 aColor; // normalized from RGBA8
+layout(location = 3) in float aSdf;
+out vec2 texCoord;
+out vec4 color;
+out float sdf;
+uniform vec2 screenSize; // window pixels, the UI is laid out top down in them
+void main()
+{
+	texCoord = aTexCoord;
+	color = aColor;
+	sdf = aSdf;
+	gl_Position = vec4(aPos.x / screenSize.x * 2.0 - 1.0, 1.0 - aPos.y / screenSize.y * 2.0, 0.0, 1.0);
+};
\ No newline at end of file
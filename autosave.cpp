@@ -0,0 +1,315 @@
+#include "autosave.h"
+#include "deltacodec.h"
+#include "mappedfile.h"
+#include "profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+static const uint32_t autosaveVersion = 2;
+
+// FNV-1a over the whole file, 0 when it can't be read so an autosave of the test level only matches while there's no level file
+static uint64_t HashFile(const std::string& path) {
+	std::ifstream in(path, std::ios::binary);
+	if (!in) {
+		return 0;
+	}
+	uint64_t hash = 14695981039346656037ull;
+	char buffer[64 * 1024];
+	while (in.read(buffer, sizeof(buffer)) || in.gcount() > 0) {
+		for (std::streamsize index = 0; index < in.gcount(); index++) {
+			hash = (hash ^ (unsigned char)buffer[index]) * 1099511628211ull;
+		}
+	}
+	return hash;
+}
+
+static void AppendRecord(std::vector<unsigned char>& file, uint32_t chunk, const std::vector<unsigned char>& delta) {
+	uint32_t size = (uint32_t)delta.size();
+	file.insert(file.end(), (const unsigned char*)&chunk, (const unsigned char*)&chunk + sizeof(chunk));
+	file.insert(file.end(), (const unsigned char*)&size, (const unsigned char*)&size + sizeof(size));
+	file.insert(file.end(), delta.begin(), delta.end());
+}
+
+void Autosave::Start(const std::string& path, const std::string& level, double intervalSeconds) {
+	basePath = path;
+	deltaPath = path + ".delta";
+	levelPath = level;
+	interval = intervalSeconds;
+	// seeded from the clock so a base from an earlier run never has the generation of one written in this run
+	generation = (uint32_t)std::chrono::system_clock::now().time_since_epoch().count();
+	thread = std::thread(&Autosave::Loop, this);
+}
+
+void Autosave::Update(const TransformChunks& transforms, double frameSeconds) {
+	sinceLastSave += frameSeconds;
+	if (sinceLastSave < interval || !thread.joinable()) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (busy) {
+			return; // still writing the last one, try again next frame
+		}
+		ScopedTimer timer("autosave.snapshot");
+		pending = transforms; // a pointer per chunk, the chunks themselves are shared
+		pendingEpoch = levelEpoch;
+		busy = true;
+	}
+	sinceLastSave = 0.0;
+	wake.notify_one();
+}
+
+void Autosave::LevelChanged() {
+	if (!thread.joinable()) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		levelEpoch++;
+	}
+	wake.notify_one();
+}
+
+void Autosave::Stop() {
+	if (!thread.joinable()) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	wake.notify_one();
+	thread.join();
+}
+
+void Autosave::Loop() {
+	while (true) {
+		TransformChunks snapshot;
+		bool took;
+		bool levelChanged;
+		bool save;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [this] { return busy || quit || savedEpoch != levelEpoch; });
+			took = busy;
+			levelChanged = savedEpoch != levelEpoch;
+			savedEpoch = levelEpoch;
+			if (!took && !levelChanged) {
+				break; // quit, and nothing left to save
+			}
+			// a snapshot handed over before the level was saved or loaded may be older than the level file, recovering it would undo work
+			save = took && pendingEpoch == levelEpoch;
+			snapshot = pending;
+			pending = TransformChunks();
+		}
+
+		if (levelChanged) {
+			// anything already written (a save that finished after LevelChanged included) is older than the level now
+			Discard(basePath);
+			hasBase = false;
+			base = TransformChunks();
+			last = TransformChunks();
+			chunkDeltas.clear();
+		}
+		if (save) {
+			Save(snapshot);
+		}
+
+		if (took) {
+			std::lock_guard<std::mutex> lock(mutex);
+			busy = false;
+		}
+	}
+}
+
+void Autosave::Save(const TransformChunks& snapshot) {
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	if (!hasBase || snapshot.Size() != base.Size()) {
+		WriteBase(snapshot);
+		return;
+	}
+
+	// Diff //
+	// only chunks that changed since the last save are diffed again, the rest keep the diff they had
+	const size_t chunkBytes = TransformChunks::chunkSize * sizeof(TransformComponent);
+	chunkDeltas.resize(snapshot.ChunkCount());
+	size_t encoded = 0;
+	size_t deltaBytes = 0;
+	uint32_t records = 0;
+	bool changed = false;
+	for (size_t chunk = 0; chunk < snapshot.ChunkCount(); chunk++) {
+		if (snapshot.SharesChunk(base, chunk)) {
+			changed = changed || !chunkDeltas[chunk].empty(); // back to what the base has (play mode stopped, say)
+			chunkDeltas[chunk].clear();
+		}
+		else if (!snapshot.SharesChunk(last, chunk)) {
+			chunkDeltas[chunk].clear();
+			DeltaCodec::Encode((const unsigned char*)base.ChunkData(chunk), (const unsigned char*)snapshot.ChunkData(chunk),
+				snapshot.ChunkLength(chunk) * sizeof(TransformComponent), chunkDeltas[chunk]);
+			encoded++;
+			changed = true;
+		}
+		deltaBytes += chunkDeltas[chunk].size();
+		records += chunkDeltas[chunk].empty() ? 0 : 1;
+	}
+	last = snapshot;
+	if (!changed) {
+		return; // nothing changed since the last save
+	}
+	if (deltaBytes > snapshot.ChunkCount() * chunkBytes / 2) {
+		WriteBase(snapshot); // the delta has stopped saving much, start over from here
+		return;
+	}
+	// Diff //
+
+	// Write //
+	AutosaveHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, "ASV", 4);
+	header.version = autosaveVersion;
+	header.isDelta = 1;
+	header.generation = generation;
+	header.transformSize = sizeof(TransformComponent);
+	header.chunkSize = (uint32_t)TransformChunks::chunkSize;
+	header.objectCount = (uint32_t)snapshot.Size();
+	header.recordCount = records;
+	header.levelHash = levelHash;
+	std::vector<unsigned char> file((const unsigned char*)&header, (const unsigned char*)&header + sizeof(header));
+	file.reserve(sizeof(header) + deltaBytes + records * 2 * sizeof(uint32_t));
+	for (size_t chunk = 0; chunk < chunkDeltas.size(); chunk++) {
+		if (!chunkDeltas[chunk].empty()) {
+			AppendRecord(file, (uint32_t)chunk, chunkDeltas[chunk]);
+		}
+	}
+	if (!WriteFileAtomic(deltaPath, file)) {
+		std::cout << "Error: autosave couldn't write " << deltaPath << std::endl;
+		return;
+	}
+	// Write //
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	std::cout << "Autosaved " << encoded << " changed chunks (" << records << " differ from the base, " << file.size() / 1024
+		<< " KB) in " << elapsed.count() << " ms" << std::endl;
+}
+
+bool Autosave::WriteBase(const TransformChunks& snapshot) {
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	// the old delta goes first, if we crash before the new base is in place the old base is still whole on its own
+	std::remove(deltaPath.c_str());
+	generation++;
+	levelHash = HashFile(levelPath);
+
+	AutosaveHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, "ASV", 4);
+	header.version = autosaveVersion;
+	header.isDelta = 0;
+	header.generation = generation;
+	header.transformSize = sizeof(TransformComponent);
+	header.chunkSize = (uint32_t)TransformChunks::chunkSize;
+	header.objectCount = (uint32_t)snapshot.Size();
+	header.recordCount = (uint32_t)snapshot.ChunkCount();
+	header.levelHash = levelHash;
+	std::vector<unsigned char> file((const unsigned char*)&header, (const unsigned char*)&header + sizeof(header));
+	std::vector<unsigned char> delta;
+	for (size_t chunk = 0; chunk < snapshot.ChunkCount(); chunk++) {
+		delta.clear();
+		DeltaCodec::Encode(nullptr, (const unsigned char*)snapshot.ChunkData(chunk), snapshot.ChunkLength(chunk) * sizeof(TransformComponent), delta);
+		AppendRecord(file, (uint32_t)chunk, delta);
+	}
+	if (!WriteFileAtomic(basePath, file)) {
+		std::cout << "Error: autosave couldn't write " << basePath << std::endl;
+		hasBase = false;
+		return false;
+	}
+
+	base = snapshot;
+	last = snapshot;
+	chunkDeltas.assign(snapshot.ChunkCount(), std::vector<unsigned char>());
+	hasBase = true;
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	std::cout << "Autosaved the whole level (" << file.size() / 1024 << " KB) in " << elapsed.count() << " ms" << std::endl;
+	return true;
+}
+
+// Recovery //
+static bool ReadAutosave(const std::string& path, AutosaveHeader& header, std::vector<unsigned char>& bytes) {
+	std::ifstream in(path, std::ios::binary);
+	if (!in) {
+		return false;
+	}
+	bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	if (bytes.size() < sizeof(header)) {
+		return false;
+	}
+	std::memcpy(&header, bytes.data(), sizeof(header));
+	return std::memcmp(header.magic, "ASV", 4) == 0 && header.version == autosaveVersion && header.transformSize == sizeof(TransformComponent)
+		&& header.chunkSize == TransformChunks::chunkSize;
+}
+
+// XORs every record into transforms, which has to have the header's object count already
+static bool ApplyRecords(const AutosaveHeader& header, const std::vector<unsigned char>& bytes, std::vector<TransformComponent>& transforms) {
+	size_t read = sizeof(AutosaveHeader);
+	for (uint32_t record = 0; record < header.recordCount; record++) {
+		uint32_t chunk;
+		uint32_t size;
+		if (bytes.size() - read < 2 * sizeof(uint32_t)) {
+			return false;
+		}
+		std::memcpy(&chunk, bytes.data() + read, sizeof(chunk));
+		std::memcpy(&size, bytes.data() + read + sizeof(chunk), sizeof(size));
+		read += 2 * sizeof(uint32_t);
+		size_t first = (size_t)chunk * header.chunkSize;
+		if (first >= transforms.size() || size > bytes.size() - read) {
+			return false;
+		}
+		size_t length = std::min((size_t)header.chunkSize, transforms.size() - first);
+		if (!DeltaCodec::Apply((unsigned char*)&transforms[first], length * sizeof(TransformComponent), bytes.data() + read, size)) {
+			return false;
+		}
+		read += size;
+	}
+	return true;
+}
+
+bool Autosave::Recover(const std::string& path, const std::string& levelPath, std::vector<TransformComponent>& transforms) {
+	AutosaveHeader baseHeader;
+	std::vector<unsigned char> bytes;
+	if (!ReadAutosave(path, baseHeader, bytes) || baseHeader.isDelta) {
+		return false;
+	}
+	if (baseHeader.levelHash != HashFile(levelPath)) {
+		// the level was saved (or replaced) after this autosave, so it's either older than the level or for another one
+		std::cout << "Ignoring " << path << ", it was made for a different " << levelPath << std::endl;
+		return false;
+	}
+	transforms.resize(baseHeader.objectCount);
+	std::memset((void*)transforms.data(), 0, transforms.size() * sizeof(TransformComponent)); // the base is diffed against zeros
+	if (!ApplyRecords(baseHeader, bytes, transforms)) {
+		std::cout << "Error: " << path << " is damaged" << std::endl;
+		return false;
+	}
+
+	AutosaveHeader deltaHeader;
+	if (ReadAutosave(path + ".delta", deltaHeader, bytes) && deltaHeader.isDelta && deltaHeader.generation == baseHeader.generation
+		&& deltaHeader.objectCount == baseHeader.objectCount && deltaHeader.levelHash == baseHeader.levelHash) {
+		std::vector<TransformComponent> recovered = transforms;
+		if (ApplyRecords(deltaHeader, bytes, recovered)) {
+			transforms.swap(recovered);
+		}
+		else {
+			std::cout << "Error: " << path << ".delta is damaged, recovering the older base only" << std::endl;
+		}
+	}
+	return true;
+}
+
+void Autosave::Discard(const std::string& path) {
+	std::remove((path + ".delta").c_str()); // the delta first, the same order WriteBase uses
+	std::remove(path.c_str());
+}
+// Recovery //
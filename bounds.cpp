@@ -0,0 +1,209 @@
+#include "bounds.h"
+#include <algorithm>
+#include <cmath>
+#include <immintrin.h> // SSE/AVX intrinsics
+
+// AABB //
+float AABB::SurfaceArea() const {
+	if (Empty()) {
+		return 0.0f;
+	}
+	glm::vec3 size = max - min;
+	return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+void AABB::Expand(const glm::vec3& point) {
+	min = glm::min(min, point);
+	max = glm::max(max, point);
+}
+
+void AABB::Expand(const AABB& box) {
+	min = glm::min(min, box.min);
+	max = glm::max(max, box.max);
+}
+
+AABB AABB::Transformed(const glm::mat4& matrix) const {
+	if (Empty()) {
+		return *this;
+	}
+	// rather than transforming all 8 corners, move the center and work out how far the rotated extents reach along each axis
+	glm::vec3 center = glm::vec3(matrix * glm::vec4(Center(), 1.0f));
+	glm::vec3 extents = Extents();
+	glm::vec3 newExtents;
+	for (int axis = 0; axis < 3; axis++) {
+		newExtents[axis] = std::abs(matrix[0][axis]) * extents.x + std::abs(matrix[1][axis]) * extents.y + std::abs(matrix[2][axis]) * extents.z;
+	}
+	return AABB(center - newExtents, center + newExtents);
+}
+// AABB //
+
+// Bounding Sphere //
+BoundingSphere BoundingSphere::Transformed(const glm::mat4& matrix) const {
+	// the radius grows by the largest scale on any axis so the sphere still contains everything
+	float scaleX = glm::length(glm::vec3(matrix[0]));
+	float scaleY = glm::length(glm::vec3(matrix[1]));
+	float scaleZ = glm::length(glm::vec3(matrix[2]));
+	float scale = std::max(scaleX, std::max(scaleY, scaleZ));
+	return BoundingSphere(glm::vec3(matrix * glm::vec4(center, 1.0f)), radius * scale);
+}
+// Bounding Sphere //
+
+// Frustum //
+Frustum::Frustum(const glm::mat4& viewProjection) {
+	// glm is column major so row i of the matrix is (m[0][i], m[1][i], m[2][i], m[3][i])
+	const glm::mat4& m = viewProjection;
+	glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+	glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+	glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+	glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+	planes[0] = row3 + row0; // left
+	planes[1] = row3 - row0; // right
+	planes[2] = row3 + row1; // bottom
+	planes[3] = row3 - row1; // top
+	planes[4] = row3 + row2; // near
+	planes[5] = row3 - row2; // far
+
+	for (int plane = 0; plane < 6; plane++) { // normalize so distances come out in world units (needed for the sphere test)
+		float length = glm::length(glm::vec3(planes[plane]));
+		planes[plane] = planes[plane] / length;
+	}
+}
+
+bool Frustum::Intersects(const AABB& box) const {
+	glm::vec3 center = box.Center();
+	glm::vec3 extents = box.Extents();
+	for (int plane = 0; plane < 6; plane++) {
+		glm::vec3 normal = glm::vec3(planes[plane]);
+		float distance = glm::dot(normal, center) + planes[plane].w;
+		float reach = glm::dot(glm::abs(normal), extents); // how far the box sticks out towards the plane
+		if (distance + reach < 0.0f) {
+			return false; // completely behind this plane
+		}
+	}
+	return true;
+}
+
+bool Frustum::Intersects(const BoundingSphere& sphere) const {
+	for (int plane = 0; plane < 6; plane++) {
+		if (glm::dot(glm::vec3(planes[plane]), sphere.center) + planes[plane].w < -sphere.radius) {
+			return false;
+		}
+	}
+	return true;
+}
+// Frustum //
+
+// Bounds List //
+void BoundsList::Clear() {
+	count = 0;
+	centerX.clear(); centerY.clear(); centerZ.clear();
+	extentX.clear(); extentY.clear(); extentZ.clear();
+	radius.clear();
+}
+
+void BoundsList::Add(const AABB& box, const BoundingSphere& sphere) {
+	count++;
+	Pad();
+	Set(count - 1, box, sphere);
+}
+
+void BoundsList::Set(unsigned int index, const AABB& box, const BoundingSphere& sphere) {
+	glm::vec3 center = box.Center();
+	glm::vec3 extents = box.Extents();
+	centerX[index] = center.x;
+	centerY[index] = center.y;
+	centerZ[index] = center.z;
+	extentX[index] = extents.x;
+	extentY[index] = extents.y;
+	extentZ[index] = extents.z;
+	radius[index] = sphere.radius;
+	// the sphere shares the box's center in the SIMD layout, so grow its radius to cover any offset between the two
+	radius[index] += glm::length(sphere.center - center);
+}
+
+void BoundsList::Pad() {
+	const unsigned int padded = (count + 7) & ~7u;
+	centerX.resize(padded); centerY.resize(padded); centerZ.resize(padded);
+	extentX.resize(padded); extentY.resize(padded); extentZ.resize(padded);
+	radius.resize(padded);
+}
+
+unsigned int BoundsList::Cull(const Frustum& frustum, unsigned char* visible) const {
+	unsigned int numVisible = 0;
+
+#if defined(__AVX__)
+	// 8 at a time //
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 signMask = _mm256_set1_ps(-0.0f);
+	for (unsigned int first = 0; first < count; first += 8) {
+		__m256 cx = _mm256_loadu_ps(&centerX[first]);
+		__m256 cy = _mm256_loadu_ps(&centerY[first]);
+		__m256 cz = _mm256_loadu_ps(&centerZ[first]);
+		__m256 ex = _mm256_loadu_ps(&extentX[first]);
+		__m256 ey = _mm256_loadu_ps(&extentY[first]);
+		__m256 ez = _mm256_loadu_ps(&extentZ[first]);
+		__m256 r = _mm256_loadu_ps(&radius[first]);
+		__m256 outside = zero;
+
+		for (int plane = 0; plane < 6; plane++) {
+			const glm::vec4& p = frustum.planes[plane];
+			__m256 nx = _mm256_set1_ps(p.x);
+			__m256 ny = _mm256_set1_ps(p.y);
+			__m256 nz = _mm256_set1_ps(p.z);
+			__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, cx), _mm256_mul_ps(ny, cy)),
+				_mm256_add_ps(_mm256_mul_ps(nz, cz), _mm256_set1_ps(p.w)));
+			__m256 reach = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_andnot_ps(signMask, nx), ex), _mm256_mul_ps(_mm256_andnot_ps(signMask, ny), ey)),
+				_mm256_mul_ps(_mm256_andnot_ps(signMask, nz), ez));
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, reach), zero, _CMP_LT_OQ)); // box behind plane
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, r), zero, _CMP_LT_OQ)); // sphere behind plane
+		}
+
+		int mask = _mm256_movemask_ps(outside);
+		unsigned int lanes = std::min(8u, count - first);
+		for (unsigned int lane = 0; lane < lanes; lane++) {
+			visible[first + lane] = ((mask >> lane) & 1) ? 0 : 1;
+			numVisible += visible[first + lane];
+		}
+	}
+	// 8 at a time //
+#else
+	// 4 at a time //
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	for (unsigned int first = 0; first < count; first += 4) {
+		__m128 cx = _mm_loadu_ps(&centerX[first]);
+		__m128 cy = _mm_loadu_ps(&centerY[first]);
+		__m128 cz = _mm_loadu_ps(&centerZ[first]);
+		__m128 ex = _mm_loadu_ps(&extentX[first]);
+		__m128 ey = _mm_loadu_ps(&extentY[first]);
+		__m128 ez = _mm_loadu_ps(&extentZ[first]);
+		__m128 r = _mm_loadu_ps(&radius[first]);
+		__m128 outside = zero;
+
+		for (int plane = 0; plane < 6; plane++) {
+			const glm::vec4& p = frustum.planes[plane];
+			__m128 nx = _mm_set1_ps(p.x);
+			__m128 ny = _mm_set1_ps(p.y);
+			__m128 nz = _mm_set1_ps(p.z);
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)),
+				_mm_add_ps(_mm_mul_ps(nz, cz), _mm_set1_ps(p.w)));
+			__m128 reach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signMask, nx), ex), _mm_mul_ps(_mm_andnot_ps(signMask, ny), ey)),
+				_mm_mul_ps(_mm_andnot_ps(signMask, nz), ez));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, reach), zero)); // box behind plane
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, r), zero)); // sphere behind plane
+		}
+
+		int mask = _mm_movemask_ps(outside);
+		unsigned int lanes = std::min(4u, count - first);
+		for (unsigned int lane = 0; lane < lanes; lane++) {
+			visible[first + lane] = ((mask >> lane) & 1) ? 0 : 1;
+			numVisible += visible[first + lane];
+		}
+	}
+	// 4 at a time //
+#endif
+
+	return numVisible;
+}
+// Bounds List //
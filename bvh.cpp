@@ -0,0 +1,548 @@
+#include "bvh.h"
+#include <algorithm>
+#include <cmath>
+
+static AABB Merge(const AABB& a, const AABB& b) {
+	AABB box = a;
+	box.Expand(b);
+	return box;
+}
+
+static bool Contains(const AABB& outer, const AABB& inner) {
+	return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z &&
+		outer.max.x >= inner.max.x && outer.max.y >= inner.max.y && outer.max.z >= inner.max.z;
+}
+
+BVH::BVH() : fatMargin(0.1f), root(nullNode), freeList(nullNode) {}
+
+// Node Pool //
+int BVH::AllocateNode() {
+	if (freeList == nullNode) { // pool is empty so grow it
+		nodes.push_back(Node());
+		freeList = (int)nodes.size() - 1;
+		nodes[freeList].parent = nullNode;
+	}
+	int node = freeList;
+	freeList = nodes[node].parent;
+	nodes[node].box = AABB();
+	nodes[node].parent = nullNode;
+	nodes[node].child1 = nullNode;
+	nodes[node].child2 = nullNode;
+	nodes[node].height = 0;
+	nodes[node].userData = 0;
+	return node;
+}
+
+void BVH::FreeNode(int node) {
+	nodes[node].parent = freeList;
+	nodes[node].height = -1;
+	freeList = node;
+}
+
+void BVH::Clear() {
+	nodes.clear();
+	root = nullNode;
+	freeList = nullNode;
+}
+// Node Pool //
+
+// Leaves //
+int BVH::Insert(const AABB& box, unsigned int userData) {
+	int leaf = AllocateNode();
+	nodes[leaf].box = AABB(box.min - glm::vec3(fatMargin), box.max + glm::vec3(fatMargin));
+	nodes[leaf].userData = userData;
+	InsertLeaf(leaf);
+	return leaf;
+}
+
+int BVH::Add(const AABB& box, unsigned int userData) {
+	int leaf = AllocateNode();
+	nodes[leaf].box = AABB(box.min - glm::vec3(fatMargin), box.max + glm::vec3(fatMargin));
+	nodes[leaf].userData = userData;
+	return leaf;
+}
+
+void BVH::Remove(int proxy) {
+	RemoveLeaf(proxy);
+	FreeNode(proxy);
+}
+
+void BVH::Move(int proxy, const AABB& box) {
+	const AABB& fat = nodes[proxy].box;
+	if (Contains(fat, box)) {
+		return; // still inside the fattened box, nothing in the tree needs to change
+	}
+
+	AABB newFat(box.min - glm::vec3(fatMargin), box.max + glm::vec3(fatMargin));
+	// small moves just refit the ancestors in place (the rotations on the way up keep the tree in shape),
+	// a big jump would leave the leaf under a far away parent so it gets reinserted instead
+	glm::vec3 travelled = glm::abs(newFat.Center() - fat.Center());
+	glm::vec3 size = fat.max - fat.min;
+	if (travelled.x <= size.x && travelled.y <= size.y && travelled.z <= size.z) {
+		nodes[proxy].box = newFat;
+		RefitUpwards(nodes[proxy].parent);
+	}
+	else {
+		RemoveLeaf(proxy);
+		nodes[proxy].box = newFat;
+		InsertLeaf(proxy);
+	}
+}
+
+void BVH::InsertLeaf(int leaf) {
+	if (root == nullNode) {
+		root = leaf;
+		nodes[root].parent = nullNode;
+		return;
+	}
+
+	// Find Best Sibling //
+	// walk down towards whichever child would grow the least, stopping when making a new parent here is cheaper than going further
+	const AABB leafBox = nodes[leaf].box; // a copy, allocating the new parent below can move the node array
+	int index = root;
+	while (!nodes[index].IsLeaf()) {
+		int child1 = nodes[index].child1;
+		int child2 = nodes[index].child2;
+
+		float area = nodes[index].box.SurfaceArea();
+		float combinedArea = Merge(nodes[index].box, leafBox).SurfaceArea();
+		float cost = 2.0f * combinedArea; // cost of pairing the leaf with this whole node
+		float inheritance = 2.0f * (combinedArea - area); // every ancestor below here grows by at least this much
+
+		float cost1 = Merge(leafBox, nodes[child1].box).SurfaceArea() + inheritance;
+		if (!nodes[child1].IsLeaf()) {
+			cost1 -= nodes[child1].box.SurfaceArea();
+		}
+		float cost2 = Merge(leafBox, nodes[child2].box).SurfaceArea() + inheritance;
+		if (!nodes[child2].IsLeaf()) {
+			cost2 -= nodes[child2].box.SurfaceArea();
+		}
+
+		if (cost < cost1 && cost < cost2) {
+			break;
+		}
+		index = cost1 < cost2 ? child1 : child2;
+	}
+	int sibling = index;
+	// Find Best Sibling //
+
+	// New Parent //
+	int oldParent = nodes[sibling].parent;
+	int newParent = AllocateNode();
+	nodes[newParent].parent = oldParent;
+	nodes[newParent].box = Merge(leafBox, nodes[sibling].box);
+	nodes[newParent].height = nodes[sibling].height + 1;
+	nodes[newParent].child1 = sibling;
+	nodes[newParent].child2 = leaf;
+	nodes[sibling].parent = newParent;
+	nodes[leaf].parent = newParent;
+
+	if (oldParent == nullNode) {
+		root = newParent;
+	}
+	else if (nodes[oldParent].child1 == sibling) {
+		nodes[oldParent].child1 = newParent;
+	}
+	else {
+		nodes[oldParent].child2 = newParent;
+	}
+	// New Parent //
+
+	RefitUpwards(oldParent);
+}
+
+void BVH::RemoveLeaf(int leaf) {
+	if (leaf == root) {
+		root = nullNode;
+		return;
+	}
+
+	int parent = nodes[leaf].parent;
+	int grandParent = nodes[parent].parent;
+	int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+	// the sibling takes the parent's place
+	if (grandParent == nullNode) {
+		root = sibling;
+		nodes[sibling].parent = nullNode;
+	}
+	else {
+		if (nodes[grandParent].child1 == parent) {
+			nodes[grandParent].child1 = sibling;
+		}
+		else {
+			nodes[grandParent].child2 = sibling;
+		}
+		nodes[sibling].parent = grandParent;
+	}
+	FreeNode(parent);
+	nodes[leaf].parent = nullNode;
+
+	RefitUpwards(grandParent);
+}
+// Leaves //
+
+// Refitting //
+void BVH::RefitUpwards(int node) {
+	while (node != nullNode) {
+		Node& current = nodes[node];
+		current.box = Merge(nodes[current.child1].box, nodes[current.child2].box);
+		current.height = 1 + std::max(nodes[current.child1].height, nodes[current.child2].height);
+		Rotate(node);
+		node = nodes[node].parent;
+	}
+}
+
+void BVH::Rotate(int a) {
+	// a has children b and c, b has children d and e, c has children f and g
+	// a swap is only worth it if it shrinks whichever child of a got rebuilt, a's own box never changes
+	int b = nodes[a].child1;
+	int c = nodes[a].child2;
+	if (nodes[b].IsLeaf() && nodes[c].IsLeaf()) {
+		return;
+	}
+
+	enum Swap { None, BwithF, BwithG, CwithD, CwithE };
+	Swap best = None;
+	float bestSaving = 0.0f;
+
+	if (!nodes[c].IsLeaf()) { // b could swap with one of c's children
+		int f = nodes[c].child1;
+		int g = nodes[c].child2;
+		float area = nodes[c].box.SurfaceArea();
+		float savingF = area - Merge(nodes[b].box, nodes[g].box).SurfaceArea(); // c would then hold b and g
+		float savingG = area - Merge(nodes[b].box, nodes[f].box).SurfaceArea();
+		if (savingF > bestSaving) { best = BwithF; bestSaving = savingF; }
+		if (savingG > bestSaving) { best = BwithG; bestSaving = savingG; }
+	}
+	if (!nodes[b].IsLeaf()) { // c could swap with one of b's children
+		int d = nodes[b].child1;
+		int e = nodes[b].child2;
+		float area = nodes[b].box.SurfaceArea();
+		float savingD = area - Merge(nodes[c].box, nodes[e].box).SurfaceArea();
+		float savingE = area - Merge(nodes[c].box, nodes[d].box).SurfaceArea();
+		if (savingD > bestSaving) { best = CwithD; bestSaving = savingD; }
+		if (savingE > bestSaving) { best = CwithE; bestSaving = savingE; }
+	}
+
+	// swaps 'outer' (a child of a) with 'inner' (a child of the other child 'middle')
+	auto swapNodes = [this, a](int outer, int middle, int inner) {
+		if (nodes[a].child1 == outer) nodes[a].child1 = inner; else nodes[a].child2 = inner;
+		if (nodes[middle].child1 == inner) nodes[middle].child1 = outer; else nodes[middle].child2 = outer;
+		nodes[inner].parent = a;
+		nodes[outer].parent = middle;
+		nodes[middle].box = Merge(nodes[nodes[middle].child1].box, nodes[nodes[middle].child2].box);
+		nodes[middle].height = 1 + std::max(nodes[nodes[middle].child1].height, nodes[nodes[middle].child2].height);
+		nodes[a].height = 1 + std::max(nodes[nodes[a].child1].height, nodes[nodes[a].child2].height);
+	};
+
+	switch (best) {
+	case BwithF: swapNodes(b, c, nodes[c].child1); break;
+	case BwithG: swapNodes(b, c, nodes[c].child2); break;
+	case CwithD: swapNodes(c, b, nodes[b].child1); break;
+	case CwithE: swapNodes(c, b, nodes[b].child2); break;
+	default: break;
+	}
+}
+// Refitting //
+
+// SAH Build //
+void BVH::Build() {
+	std::vector<int> leaves;
+	for (int node = 0; node < (int)nodes.size(); node++) {
+		if (nodes[node].height == 0) {
+			leaves.push_back(node);
+		}
+		else if (nodes[node].height > 0) {
+			FreeNode(node); // internal nodes get rebuilt from scratch
+		}
+	}
+	if (leaves.empty()) {
+		root = nullNode;
+		return;
+	}
+	root = BuildRange(leaves, 0, (int)leaves.size());
+	nodes[root].parent = nullNode;
+}
+
+int BVH::BuildRange(std::vector<int>& leaves, int begin, int end) {
+	if (end - begin == 1) {
+		return leaves[begin];
+	}
+
+	// split along the axis where the leaf centers are most spread out
+	AABB centers;
+	for (int i = begin; i < end; i++) {
+		centers.Expand(nodes[leaves[i]].box.Center());
+	}
+	glm::vec3 spread = centers.max - centers.min;
+	int axis = 0;
+	if (spread.y > spread[axis]) axis = 1;
+	if (spread.z > spread[axis]) axis = 2;
+
+	int middle = (begin + end) / 2;
+	if (spread[axis] > 1e-6f) {
+		// Binning //
+		// drop every leaf into one of a handful of buckets by its center, then try a split between each pair of buckets
+		const int numBins = 12;
+		int binCount[numBins] = {};
+		AABB binBox[numBins];
+		const float scale = numBins / spread[axis];
+		auto binOf = [&](int leaf) {
+			int bin = (int)((nodes[leaf].box.Center()[axis] - centers.min[axis]) * scale);
+			return std::min(bin, numBins - 1);
+		};
+		for (int i = begin; i < end; i++) {
+			int bin = binOf(leaves[i]);
+			binCount[bin]++;
+			binBox[bin].Expand(nodes[leaves[i]].box);
+		}
+
+		// sweep from the right so each left-to-right split can read the right hand side's cost
+		float rightCost[numBins];
+		AABB rightBox;
+		int rightCount = 0;
+		for (int bin = numBins - 1; bin > 0; bin--) {
+			rightBox.Expand(binBox[bin]);
+			rightCount += binCount[bin];
+			rightCost[bin] = rightCount * rightBox.SurfaceArea();
+		}
+		AABB leftBox;
+		int leftCount = 0;
+		float bestCost = FLT_MAX;
+		int bestSplit = -1;
+		for (int bin = 0; bin < numBins - 1; bin++) {
+			leftBox.Expand(binBox[bin]);
+			leftCount += binCount[bin];
+			float cost = leftCount * leftBox.SurfaceArea() + rightCost[bin + 1];
+			if (leftCount > 0 && leftCount < end - begin && cost < bestCost) {
+				bestCost = cost;
+				bestSplit = bin;
+			}
+		}
+		// Binning //
+
+		if (bestSplit >= 0) {
+			middle = (int)(std::partition(leaves.begin() + begin, leaves.begin() + end, [&](int leaf) { return binOf(leaf) <= bestSplit; }) - leaves.begin());
+		}
+	}
+	if (middle == begin || middle == end) { // everything landed on one side, just split the list in half
+		middle = (begin + end) / 2;
+	}
+
+	int node = AllocateNode();
+	int child1 = BuildRange(leaves, begin, middle);
+	int child2 = BuildRange(leaves, middle, end);
+	nodes[node].child1 = child1;
+	nodes[node].child2 = child2;
+	nodes[child1].parent = node;
+	nodes[child2].parent = node;
+	nodes[node].box = Merge(nodes[child1].box, nodes[child2].box);
+	nodes[node].height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+	return node;
+}
+// SAH Build //
+
+// Queries //
+void BVH::CollectLeaves(int node, std::vector<unsigned int>& results) const {
+	std::vector<int> stack;
+	stack.push_back(node);
+	while (!stack.empty()) {
+		int current = stack.back();
+		stack.pop_back();
+		if (nodes[current].IsLeaf()) {
+			results.push_back(nodes[current].userData);
+		}
+		else {
+			stack.push_back(nodes[current].child1);
+			stack.push_back(nodes[current].child2);
+		}
+	}
+}
+
+void BVH::QueryFrustum(const Frustum& frustum, std::vector<unsigned int>& results) const {
+	if (root == nullNode) {
+		return;
+	}
+
+	// each entry carries a bit per plane that still needs testing, once a box is fully inside a plane its children are too
+	struct Entry { int node; unsigned int planeMask; };
+	std::vector<Entry> stack;
+	stack.push_back({ root, 0x3F });
+
+	while (!stack.empty()) {
+		Entry entry = stack.back();
+		stack.pop_back();
+		const Node& node = nodes[entry.node];
+
+		glm::vec3 center = node.box.Center();
+		glm::vec3 extents = node.box.Extents();
+		bool outside = false;
+		for (int plane = 0; plane < 6; plane++) {
+			if (!(entry.planeMask & (1u << plane))) {
+				continue;
+			}
+			glm::vec3 normal = glm::vec3(frustum.planes[plane]);
+			float distance = glm::dot(normal, center) + frustum.planes[plane].w;
+			float reach = glm::dot(glm::abs(normal), extents);
+			if (distance + reach < 0.0f) {
+				outside = true;
+				break;
+			}
+			if (distance - reach >= 0.0f) {
+				entry.planeMask &= ~(1u << plane);
+			}
+		}
+		if (outside) {
+			continue;
+		}
+
+		if (entry.planeMask == 0) {
+			CollectLeaves(entry.node, results); // fully inside, no more tests needed below here
+		}
+		else if (node.IsLeaf()) {
+			results.push_back(node.userData);
+		}
+		else {
+			stack.push_back({ node.child1, entry.planeMask });
+			stack.push_back({ node.child2, entry.planeMask });
+		}
+	}
+}
+
+void BVH::CollectLeaves(int node, unsigned char mask, std::vector<unsigned int>& results, std::vector<unsigned char>& masks) const {
+	CollectLeaves(node, results);
+	masks.resize(results.size(), mask); // the two stay the same length, so only the new leaves get the mask
+}
+
+void BVH::QueryFrusta(const Frustum* frusta, unsigned int count, std::vector<unsigned int>& results, std::vector<unsigned char>& masks) const {
+	if (root == nullNode || count == 0) {
+		return;
+	}
+	count = std::min(count, maxFrusta);
+
+	// like QueryFrustum, but with plane bits for every frustum. testing holds the frusta the node is partly inside,
+	// inside the ones that fully contain it (their planes are all cleared, nothing below needs them)
+	struct Entry {
+		int node;
+		unsigned char testing;
+		unsigned char inside;
+		unsigned char planeMasks[maxFrusta];
+	};
+	std::vector<Entry> stack;
+	Entry first;
+	first.node = root;
+	first.testing = (unsigned char)((1u << count) - 1);
+	first.inside = 0;
+	for (unsigned int frustum = 0; frustum < count; frustum++) {
+		first.planeMasks[frustum] = 0x3F;
+	}
+	stack.push_back(first);
+
+	while (!stack.empty()) {
+		Entry entry = stack.back();
+		stack.pop_back();
+		const Node& node = nodes[entry.node];
+
+		glm::vec3 center = node.box.Center();
+		glm::vec3 extents = node.box.Extents();
+		for (unsigned int frustum = 0; frustum < count; frustum++) {
+			unsigned char bit = (unsigned char)(1u << frustum);
+			if (!(entry.testing & bit)) {
+				continue;
+			}
+			for (int plane = 0; plane < 6; plane++) {
+				if (!(entry.planeMasks[frustum] & (1u << plane))) {
+					continue;
+				}
+				const glm::vec4& equation = frusta[frustum].planes[plane];
+				glm::vec3 normal = glm::vec3(equation);
+				float distance = glm::dot(normal, center) + equation.w;
+				float reach = glm::dot(glm::abs(normal), extents);
+				if (distance + reach < 0.0f) {
+					entry.testing &= ~bit; // this view can't see anything below here
+					break;
+				}
+				if (distance - reach >= 0.0f) {
+					entry.planeMasks[frustum] &= ~(1u << plane);
+				}
+			}
+			if ((entry.testing & bit) && entry.planeMasks[frustum] == 0) {
+				entry.testing &= ~bit;
+				entry.inside |= bit;
+			}
+		}
+		if ((entry.testing | entry.inside) == 0) {
+			continue; // outside every view
+		}
+
+		if (entry.testing == 0) {
+			CollectLeaves(entry.node, entry.inside, results, masks); // fully inside every view that sees it
+		}
+		else if (node.IsLeaf()) {
+			results.push_back(node.userData);
+			masks.push_back(entry.testing | entry.inside);
+		}
+		else {
+			Entry child = entry;
+			child.node = node.child1;
+			stack.push_back(child);
+			child.node = node.child2;
+			stack.push_back(child);
+		}
+	}
+}
+
+// slab test, returns the distance the ray enters the box or -1 if it misses (or enters past maxDistance)
+static float RayBox(const glm::vec3& origin, const glm::vec3& inverseDirection, const AABB& box, float maxDistance) {
+	float tMin = 0.0f;
+	float tMax = maxDistance;
+	for (int axis = 0; axis < 3; axis++) {
+		float t1 = (box.min[axis] - origin[axis]) * inverseDirection[axis];
+		float t2 = (box.max[axis] - origin[axis]) * inverseDirection[axis];
+		tMin = std::max(tMin, std::min(t1, t2));
+		tMax = std::min(tMax, std::max(t1, t2));
+	}
+	return tMin <= tMax ? tMin : -1.0f;
+}
+
+float BVH::RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, const std::function<float(unsigned int, float)>& callback) const {
+	if (root == nullNode) {
+		return maxDistance;
+	}
+	glm::vec3 inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z); // infinities are fine for the slab test
+
+	struct Entry { int node; float distance; };
+	std::vector<Entry> stack;
+	float rootDistance = RayBox(origin, inverseDirection, nodes[root].box, maxDistance);
+	if (rootDistance >= 0.0f) {
+		stack.push_back({ root, rootDistance });
+	}
+
+	while (!stack.empty()) {
+		Entry entry = stack.back();
+		stack.pop_back();
+		if (entry.distance > maxDistance) {
+			continue; // something closer was already hit
+		}
+		const Node& node = nodes[entry.node];
+		if (node.IsLeaf()) {
+			maxDistance = callback(node.userData, maxDistance);
+			continue;
+		}
+
+		float distance1 = RayBox(origin, inverseDirection, nodes[node.child1].box, maxDistance);
+		float distance2 = RayBox(origin, inverseDirection, nodes[node.child2].box, maxDistance);
+		// push the far child first so the near one is popped (and can clip the ray) first
+		if (distance1 >= 0.0f && distance2 >= 0.0f && distance1 < distance2) {
+			stack.push_back({ node.child2, distance2 });
+			stack.push_back({ node.child1, distance1 });
+		}
+		else {
+			if (distance1 >= 0.0f) stack.push_back({ node.child1, distance1 });
+			if (distance2 >= 0.0f) stack.push_back({ node.child2, distance2 });
+		}
+	}
+	return maxDistance;
+}
+// Queries //
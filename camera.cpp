@@ -0,0 +1,87 @@
+#include "camera.h"
+#include <cmath>
+
+const glm::vec3 Camera::worldUp = glm::vec3(0.0f, 1.0f, 0.0f);
+
+Camera::Camera(float fovDegrees, float near, float far)
+	: position(0.0f), yaw(-90.0f), pitch(0.0f), fov(fovDegrees), nearPlane(near), farPlane(far), aspect(4.0f / 3.0f),
+	viewDirty(true), projectionDirty(true), viewProjectionDirty(true) {}
+
+void Camera::SetPosition(const glm::vec3& newPosition) {
+	if (newPosition != position) {
+		position = newPosition;
+		viewDirty = true;
+	}
+}
+
+void Camera::SetRotation(float yawDegrees, float pitchDegrees) {
+	if (yawDegrees != yaw || pitchDegrees != pitch) {
+		yaw = yawDegrees;
+		pitch = pitchDegrees;
+		viewDirty = true;
+	}
+}
+
+void Camera::SetPerspective(float fovDegrees, float near, float far) {
+	if (fovDegrees != fov || near != nearPlane || far != farPlane) {
+		fov = fovDegrees;
+		nearPlane = near;
+		farPlane = far;
+		projectionDirty = true;
+	}
+}
+
+void Camera::SetViewport(int width, int height) {
+	if (width <= 0 || height <= 0) {
+		return;
+	}
+	float newAspect = (float)width / (float)height;
+	if (newAspect != aspect) {
+		aspect = newAspect;
+		projectionDirty = true;
+	}
+}
+
+const glm::mat4& Camera::View() const {
+	if (viewDirty) {
+		view = glm::lookAt(position, position + Front(), worldUp);
+		viewDirty = false;
+		viewProjectionDirty = true;
+	}
+	return view;
+}
+
+const glm::mat4& Camera::Projection() const {
+	if (projectionDirty) {
+		projection = glm::perspective(glm::radians(fov), aspect, nearPlane, farPlane);
+		projectionDirty = false;
+		viewProjectionDirty = true;
+	}
+	return projection;
+}
+
+const glm::mat4& Camera::ViewProjection() const {
+	// both have to be asked first, they're what flag the product as stale
+	const glm::mat4& currentView = View();
+	const glm::mat4& currentProjection = Projection();
+	if (viewProjectionDirty) {
+		viewProjection = currentProjection * currentView;
+		frustum = Frustum(viewProjection);
+		viewProjectionDirty = false;
+	}
+	return viewProjection;
+}
+
+const Frustum& Camera::ViewFrustum() const {
+	ViewProjection();
+	return frustum;
+}
+
+glm::vec3 Camera::Direction(float yawDegrees, float pitchDegrees) {
+	// by using triangles, we can calculate angles from coordinates by treating them as triangles
+	glm::vec3 direction;
+	direction.x = cos(glm::radians(yawDegrees)) * cos(glm::radians(pitchDegrees));
+	direction.y = sin(glm::radians(pitchDegrees));
+	direction.z = sin(glm::radians(yawDegrees)) * cos(glm::radians(pitchDegrees));
+	return glm::normalize(direction);
+}
@@ -0,0 +1,213 @@
+#include "debugdraw.h"
+#include "profiler.h"
+#include "ui.h"
+#include <cmath>
+
+const char* DebugCategoryName(DebugCategory category) {
+	static const char* const names[DEBUG_CATEGORY_COUNT] = { "general", "bounds", "transforms", "culling", "picking" };
+	return category < DEBUG_CATEGORY_COUNT ? names[category] : "unknown";
+}
+
+// Debug Draw List //
+void DebugDrawList::Take(DebugLayer layer, std::vector<DebugVertex>& vertices) {
+	if (vertices.empty()) {
+		return;
+	}
+	if (batchCount[layer] == batches[layer].size()) {
+		batches[layer].emplace_back();
+	}
+	batches[layer][batchCount[layer]++].swap(vertices); // the thread gets back a buffer a frame or two old, memory and all
+}
+
+size_t DebugDrawList::Vertices(DebugLayer layer) const {
+	size_t vertices = 0;
+	for (size_t batch = 0; batch < batchCount[layer]; batch++) {
+		vertices += batches[layer][batch].size();
+	}
+	return vertices;
+}
+
+void DebugDrawList::Clear() {
+	for (int layer = 0; layer < DEBUG_LAYER_COUNT; layer++) {
+		for (size_t batch = 0; batch < batchCount[layer]; batch++) {
+			batches[layer][batch].clear();
+		}
+		batchCount[layer] = 0;
+	}
+}
+// Debug Draw List //
+
+// Debug Draw //
+std::atomic<uint32_t> DebugDraw::enabledCategories(1u << DEBUG_GENERAL | 1u << DEBUG_TRANSFORMS | 1u << DEBUG_PICKING);
+std::atomic<unsigned int> DebugDraw::nextID(1);
+
+DebugDraw::DebugDraw() : id(nextID++) {}
+
+DebugDraw::~DebugDraw() = default;
+
+void DebugDraw::SetEnabled(DebugCategory category, bool enabled) {
+	if (enabled) {
+		enabledCategories.fetch_or(1u << category, std::memory_order_relaxed);
+	}
+	else {
+		enabledCategories.fetch_and(~(1u << category), std::memory_order_relaxed);
+	}
+}
+
+DebugDraw::ThreadBuffer& DebugDraw::Local() {
+	// a thread only ever draws into one or two DebugDraws, so a short list per thread finds its buffer without locking
+	struct Cached {
+		unsigned int id;
+		ThreadBuffer* buffer;
+	};
+	thread_local std::vector<Cached> cached;
+	for (const Cached& entry : cached) {
+		if (entry.id == id) {
+			return *entry.buffer;
+		}
+	}
+	std::lock_guard<std::mutex> lock(buffersMutex);
+	buffers.emplace_back(new ThreadBuffer());
+	cached.push_back({ id, buffers.back().get() });
+	return *buffers.back();
+}
+
+void DebugDraw::Collect(DebugDrawList& list) {
+	std::lock_guard<std::mutex> lock(buffersMutex);
+	size_t before = list.Vertices(DEBUG_DEPTH_TESTED) + list.Vertices(DEBUG_OVERLAY);
+	for (std::unique_ptr<ThreadBuffer>& buffer : buffers) {
+		std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+		for (int layer = 0; layer < DEBUG_LAYER_COUNT; layer++) {
+			list.Take((DebugLayer)layer, buffer->vertices[layer]);
+		}
+	}
+	Profiler::Get().AddCounter("debug.lines", (list.Vertices(DEBUG_DEPTH_TESTED) + list.Vertices(DEBUG_OVERLAY) - before) / 2);
+}
+
+void DebugDraw::Line(const glm::vec3& start, const glm::vec3& end, uint32_t color, DebugCategory category, DebugLayer layer) {
+	Batch(*this, category, layer).Line(start, end, color);
+}
+
+void DebugDraw::Box(const AABB& box, uint32_t color, DebugCategory category, DebugLayer layer) {
+	Batch(*this, category, layer).Box(box, color);
+}
+
+void DebugDraw::Axes(const glm::mat4& matrix, float size, DebugCategory category, DebugLayer layer) {
+	Batch(*this, category, layer).Axes(matrix, size);
+}
+
+void DebugDraw::Sphere(const glm::vec3& center, float radius, uint32_t color, DebugCategory category, DebugLayer layer) {
+	Batch(*this, category, layer).Sphere(center, radius, color);
+}
+
+void DebugDraw::Frustum(const glm::mat4& viewProjection, uint32_t color, DebugCategory category, DebugLayer layer) {
+	Batch(*this, category, layer).Frustum(viewProjection, color);
+}
+// Debug Draw //
+
+// Batch //
+DebugDraw::Batch::Batch(DebugDraw& draw, DebugCategory category, DebugLayer layer) : vertices(nullptr) {
+	if (!Enabled(category)) {
+		return; // the category check is all a switched off category costs
+	}
+	ThreadBuffer& buffer = draw.Local();
+	lock = std::unique_lock<std::mutex>(buffer.mutex);
+	vertices = &buffer.vertices[layer];
+}
+
+DebugVertex* DebugDraw::Batch::Extend(size_t count) {
+	size_t first = vertices->size();
+	vertices->resize(first + count);
+	return &(*vertices)[first];
+}
+
+namespace {
+	// the 12 edges of a box whose corners are numbered by bits (x = 1, y = 2, z = 4)
+	const int boxEdges[12][2] = { { 0, 1 }, { 2, 3 }, { 4, 5 }, { 6, 7 }, { 0, 2 }, { 1, 3 }, { 4, 6 }, { 5, 7 }, { 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 } };
+
+	void Edges(const glm::vec3* corners, uint32_t color, DebugVertex* write) {
+		for (const int* edge : boxEdges) {
+			write[0] = { corners[edge[0]], color };
+			write[1] = { corners[edge[1]], color };
+			write += 2;
+		}
+	}
+}
+
+void DebugDraw::Batch::Box(const AABB& box, uint32_t color) {
+	if (!vertices) {
+		return;
+	}
+	glm::vec3 corners[8];
+	for (int corner = 0; corner < 8; corner++) {
+		corners[corner] = glm::vec3(corner & 1 ? box.max.x : box.min.x, corner & 2 ? box.max.y : box.min.y, corner & 4 ? box.max.z : box.min.z);
+	}
+	Edges(corners, color, Extend(24));
+}
+
+void DebugDraw::Batch::Box(const glm::mat4& matrix, const AABB& box, uint32_t color) {
+	if (!vertices) {
+		return;
+	}
+	glm::vec3 corners[8];
+	for (int corner = 0; corner < 8; corner++) {
+		glm::vec3 local(corner & 1 ? box.max.x : box.min.x, corner & 2 ? box.max.y : box.min.y, corner & 4 ? box.max.z : box.min.z);
+		corners[corner] = glm::vec3(matrix * glm::vec4(local, 1.0f));
+	}
+	Edges(corners, color, Extend(24));
+}
+
+void DebugDraw::Batch::Axes(const glm::mat4& matrix, float size) {
+	if (!vertices) {
+		return;
+	}
+	glm::vec3 origin(matrix[3]);
+	const uint32_t colors[3] = { UIColor(1.0f, 0.2f, 0.2f), UIColor(0.2f, 1.0f, 0.2f), UIColor(0.3f, 0.4f, 1.0f) };
+	for (int axis = 0; axis < 3; axis++) {
+		glm::vec3 direction(matrix[axis]);
+		float length = glm::length(direction);
+		if (length > 0.0f) {
+			Line(origin, origin + direction * (size / length), colors[axis]); // the same length whatever the scale
+		}
+	}
+}
+
+void DebugDraw::Batch::Sphere(const glm::vec3& center, float radius, uint32_t color) {
+	if (!vertices) {
+		return;
+	}
+	const int segments = 24;
+	const float step = 6.28318531f / segments;
+	for (int axis = 0; axis < 3; axis++) {
+		// the circle goes round the other two axes
+		int u = (axis + 1) % 3;
+		int v = (axis + 2) % 3;
+		glm::vec3 previous = center;
+		previous[u] += radius;
+		DebugVertex* write = Extend(segments * 2);
+		for (int segment = 1; segment <= segments; segment++) {
+			glm::vec3 point = center;
+			point[u] += std::cos(segment * step) * radius;
+			point[v] += std::sin(segment * step) * radius;
+			write[0] = { previous, color };
+			write[1] = { point, color };
+			write += 2;
+			previous = point;
+		}
+	}
+}
+
+void DebugDraw::Batch::Frustum(const glm::mat4& viewProjection, uint32_t color) {
+	if (!vertices) {
+		return;
+	}
+	// the corners of clip space, back through the camera
+	glm::mat4 inverse = glm::inverse(viewProjection);
+	glm::vec3 corners[8];
+	for (int corner = 0; corner < 8; corner++) {
+		glm::vec4 point = inverse * glm::vec4(corner & 1 ? 1.0f : -1.0f, corner & 2 ? 1.0f : -1.0f, corner & 4 ? 1.0f : -1.0f, 1.0f);
+		corners[corner] = glm::vec3(point) / point.w;
+	}
+	Edges(corners, color, Extend(24));
+}
+// Batch //
@@ -0,0 +1,104 @@
+#include "debugrenderer.h"
+#include "profiler.h"
+#include <glm/gtc/type_ptr.hpp>
+#include <cstddef>
+#include <cstring>
+
+DebugRenderer::DebugRenderer() : shader("assets/shaders/debug.vert", "assets/shaders/debug.frag"), layoutBuffer(0) {
+	vertexArray = GLVertexArray::Create("debug draw");
+	viewProjectionLoc = glGetUniformLocation(shader.ID(), "viewProjection");
+	for (int layer = 0; layer < DEBUG_LAYER_COUNT; layer++) {
+		first[layer] = 0;
+		count[layer] = 0;
+	}
+}
+
+void DebugRenderer::Unload() {
+	if (stream) {
+		stream->Unload();
+		stream.reset();
+	}
+	layoutBuffer = 0;
+	vertexArray.Reset();
+	shader.Unload();
+}
+
+void DebugRenderer::Upload(const DebugDrawList& list) {
+	for (int layer = 0; layer < DEBUG_LAYER_COUNT; layer++) {
+		count[layer] = 0;
+	}
+	size_t vertices = list.Vertices(DEBUG_DEPTH_TESTED) + list.Vertices(DEBUG_OVERLAY);
+	if (vertices == 0) {
+		return;
+	}
+	ScopedTimer timer("debug.upload");
+
+	// Stream //
+	if (!stream) {
+		stream.reset(new StreamBuffer(GL_ARRAY_BUFFER, bufferBytes, "debug draw"));
+	}
+	if (stream->ID() != layoutBuffer) { // made just now, or grown into a new buffer
+		glBindVertexArray(vertexArray.ID());
+		glBindBuffer(GL_ARRAY_BUFFER, stream->ID());
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(DebugVertex), (void*)offsetof(DebugVertex, position));
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(DebugVertex), (void*)offsetof(DebugVertex, color));
+		glEnableVertexAttribArray(1);
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		layoutBuffer = stream->ID();
+	}
+	// Stream //
+
+	size_t maxVertices = maxLines * 2;
+	if (vertices > maxVertices) {
+		Profiler::Get().AddCounter("debug.linesDropped", (vertices - maxVertices) / 2);
+		vertices = maxVertices;
+	}
+	// a whole number of vertices in, so the offset works as the first vertex of the draws
+	StreamBuffer::Allocation allocation = stream->Map(vertices * sizeof(DebugVertex), sizeof(DebugVertex));
+	if (!allocation.data) {
+		stream->Unmap();
+		return;
+	}
+	DebugVertex* write = (DebugVertex*)allocation.data;
+	size_t written = 0;
+	for (int layer = 0; layer < DEBUG_LAYER_COUNT; layer++) {
+		first[layer] = (GLint)(allocation.offset / sizeof(DebugVertex) + written);
+		for (size_t batch = 0; batch < list.batchCount[layer] && written < vertices; batch++) {
+			const std::vector<DebugVertex>& source = list.batches[layer][batch];
+			size_t copy = source.size() < vertices - written ? source.size() : vertices - written;
+			copy -= copy % 2; // never half a line
+			std::memcpy(write + written, source.data(), copy * sizeof(DebugVertex));
+			written += copy;
+		}
+		count[layer] = (GLsizei)(allocation.offset / sizeof(DebugVertex) + written - first[layer]);
+	}
+	stream->Unmap();
+}
+
+void DebugRenderer::Draw(const glm::mat4& viewProjection) {
+	if (count[DEBUG_DEPTH_TESTED] == 0 && count[DEBUG_OVERLAY] == 0) {
+		return;
+	}
+	glUseProgram(shader.ID());
+	glUniformMatrix4fv(viewProjectionLoc, 1, GL_FALSE, glm::value_ptr(viewProjection));
+	glBindVertexArray(vertexArray.ID());
+	if (count[DEBUG_DEPTH_TESTED] > 0) {
+		glDrawArrays(GL_LINES, first[DEBUG_DEPTH_TESTED], count[DEBUG_DEPTH_TESTED]);
+		Profiler::Get().AddCounter("draw.calls", 1);
+	}
+	if (count[DEBUG_OVERLAY] > 0) {
+		glDisable(GL_DEPTH_TEST);
+		glDrawArrays(GL_LINES, first[DEBUG_OVERLAY], count[DEBUG_OVERLAY]);
+		glEnable(GL_DEPTH_TEST);
+		Profiler::Get().AddCounter("draw.calls", 1);
+	}
+	glBindVertexArray(0);
+}
+
+void DebugRenderer::EndFrame() {
+	if (stream) {
+		stream->EndFrame();
+	}
+}
@@ -0,0 +1,81 @@
+#include "deltacodec.h"
+
+static void WriteVarint(size_t value, std::vector<unsigned char>& out) {
+	while (value >= 0x80) {
+		out.push_back((unsigned char)(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back((unsigned char)value);
+}
+
+static bool ReadVarint(const unsigned char*& read, const unsigned char* end, size_t& value) {
+	value = 0;
+	for (int shift = 0; shift < 64; shift += 7) {
+		if (read == end) {
+			return false;
+		}
+		unsigned char byte = *read++;
+		value |= (size_t)(byte & 0x7F) << shift;
+		if (!(byte & 0x80)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+size_t DeltaCodec::Encode(const unsigned char* before, const unsigned char* after, size_t bytes, std::vector<unsigned char>& out) {
+	size_t start = out.size();
+	auto difference = [before, after](size_t index) { return (unsigned char)(after[index] ^ (before ? before[index] : 0)); };
+
+	size_t position = 0;
+	while (position < bytes) {
+		size_t zeros = 0;
+		while (position + zeros < bytes && difference(position + zeros) == 0) {
+			zeros++;
+		}
+		if (position + zeros == bytes) {
+			break; // the trailing zeros don't need writing, applying stops when the diff runs out
+		}
+		// a literal run ends at the first stretch of zeros long enough to be worth a new pair of counts
+		size_t literals = 0;
+		size_t quiet = 0;
+		while (position + zeros + literals + quiet < bytes && quiet < 4) {
+			if (difference(position + zeros + literals + quiet) == 0) {
+				quiet++;
+			}
+			else {
+				literals += quiet + 1;
+				quiet = 0;
+			}
+		}
+
+		WriteVarint(zeros, out);
+		WriteVarint(literals, out);
+		for (size_t index = position + zeros; index < position + zeros + literals; index++) {
+			out.push_back(difference(index));
+		}
+		position += zeros + literals;
+	}
+	return out.size() - start;
+}
+
+bool DeltaCodec::Apply(unsigned char* data, size_t bytes, const unsigned char* encoded, size_t encodedBytes) {
+	const unsigned char* read = encoded;
+	const unsigned char* end = encoded + encodedBytes;
+	size_t position = 0;
+	while (read < end) {
+		size_t zeros;
+		size_t literals;
+		if (!ReadVarint(read, end, zeros) || !ReadVarint(read, end, literals)) {
+			return false;
+		}
+		if (zeros > bytes - position || literals > bytes - position - zeros || literals > (size_t)(end - read)) {
+			return false;
+		}
+		position += zeros;
+		for (size_t index = 0; index < literals; index++) {
+			data[position++] ^= *read++;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,285 @@
+#include "font.h"
+#include "profiler.h"
+#define STB_TRUETYPE_IMPLEMENTATION
+#include <stb_truetype.h> // TrueType rasterizer
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace {
+	const int glyphPadding = 4; // pixels of distance field around each glyph, how far outlines and glow could reach
+	const unsigned char onEdge = 128; // the value the outline itself gets, 0.5 in the shader
+	const float distanceScale = 32.0f; // onEdge / glyphPadding, so the field falls to 0 right at the padding
+
+	// one codepoint from UTF-8 at index, which is moved past it. anything malformed comes out as U+FFFD one byte at a time
+	int DecodeUTF8(const std::string& text, size_t& index) {
+		unsigned char first = (unsigned char)text[index++];
+		if (first < 0x80) {
+			return first;
+		}
+		int length = first >= 0xF0 ? 3 : first >= 0xE0 ? 2 : first >= 0xC0 ? 1 : 0;
+		if (length == 0 || index + length > text.size()) {
+			return 0xFFFD;
+		}
+		int codepoint = first & (0x3F >> length);
+		for (int byte = 0; byte < length; byte++) {
+			unsigned char next = (unsigned char)text[index + byte];
+			if ((next & 0xC0) != 0x80) {
+				return 0xFFFD;
+			}
+			codepoint = codepoint << 6 | (next & 0x3F);
+		}
+		index += length;
+		return codepoint;
+	}
+
+	// FNV-1a, 64 bits since a screen of debug text is thousands of strings
+	uint64_t RunKey(const std::string& text, float size) {
+		uint64_t hash = 14695981039346656037ull;
+		for (char character : text) {
+			hash = (hash ^ (unsigned char)character) * 1099511628211ull;
+		}
+		const unsigned char* sizeBytes = (const unsigned char*)&size;
+		for (size_t index = 0; index < sizeof(size); index++) {
+			hash = (hash ^ sizeBytes[index]) * 1099511628211ull;
+		}
+		return hash;
+	}
+}
+
+Font::Font(UIAtlas& uiAtlas) : atlas(uiAtlas) {}
+
+Font::~Font() = default;
+
+bool Font::Load(const std::string& path) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+	std::vector<unsigned char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	std::unique_ptr<stbtt_fontinfo> info(new stbtt_fontinfo());
+	int offset = data.empty() ? -1 : stbtt_GetFontOffsetForIndex(data.data(), 0);
+	if (offset < 0 || !stbtt_InitFont(info.get(), data.data(), offset)) {
+		std::cout << "Error: " << path << " isn't a TrueType font" << std::endl;
+		return false;
+	}
+	fontData = std::move(data); // stb_truetype keeps pointing into it, moving the vector keeps the same memory
+	font = std::move(info);
+
+	scale = stbtt_ScaleForPixelHeight(font.get(), (float)bakeSize);
+	int fontAscent, fontDescent, lineGap;
+	stbtt_GetFontVMetrics(font.get(), &fontAscent, &fontDescent, &lineGap);
+	ascent = fontAscent * scale;
+	lineHeight = (fontAscent - fontDescent + lineGap) * scale;
+
+	// whatever was baked from a previous font is useless now, the pages themselves are kept
+	glyphs.clear();
+	runs.clear();
+	for (size_t page = 0; page < pages.size(); page++) {
+		Evict((int)page);
+	}
+	// printable ASCII up front, so the first frames of text don't stall baking it
+	for (int codepoint = 32; codepoint < 127; codepoint++) {
+		GetGlyph(codepoint);
+	}
+	return true;
+}
+
+void Font::BeginFrame() {
+	frame++;
+	const unsigned long long keepFrames = 120; // same as the UI's widget cache
+	for (auto entry = runs.begin(); entry != runs.end();) {
+		if (frame - entry->second.lastFrame > keepFrames) {
+			entry = runs.erase(entry);
+		}
+		else {
+			++entry;
+		}
+	}
+	Profiler::Get().AddCounter("text.runs", runs.size());
+}
+
+// Shaping //
+const Font::Run& Font::Shape(const std::string& text, float size) {
+	Run& run = runs[RunKey(text, size)];
+	run.lastFrame = frame;
+	if (run.epoch == epoch || !font) {
+		return run;
+	}
+	ScopedTimer timer("text.shape");
+	run.vertices.clear();
+	run.pages = 0;
+	run.epoch = epoch; // set before shaping, a glyph that can't be baked resets it
+
+	float toSize = size / bakeSize;
+	float lineStep = lineHeight * toSize;
+	glm::vec2 pen(0.0f, ascent * toSize); // on the baseline of the first line
+	float width = 0.0f;
+	int previous = 0;
+	for (size_t index = 0; index < text.size();) {
+		int codepoint = DecodeUTF8(text, index);
+		if (codepoint == '\n') {
+			width = std::max(width, pen.x);
+			pen = glm::vec2(0.0f, pen.y + lineStep);
+			previous = 0;
+			continue;
+		}
+		if (previous) {
+			pen.x += stbtt_GetCodepointKernAdvance(font.get(), previous, codepoint) * scale * toSize;
+		}
+		previous = codepoint;
+		const Glyph* glyph = GetGlyph(codepoint);
+		if (!glyph) {
+			run.epoch = 0; // shaped again next time, when there may be room for it
+			continue;
+		}
+		if (glyph->page >= 0) {
+			glm::vec2 minimum = pen + glyph->offset * toSize;
+			glm::vec2 maximum = minimum + glyph->extent * toSize;
+			run.vertices.push_back({ minimum, glyph->uv0, 0, 1.0f });
+			run.vertices.push_back({ glm::vec2(maximum.x, minimum.y), glm::vec2(glyph->uv1.x, glyph->uv0.y), 0, 1.0f });
+			run.vertices.push_back({ maximum, glyph->uv1, 0, 1.0f });
+			run.vertices.push_back({ glm::vec2(minimum.x, maximum.y), glm::vec2(glyph->uv0.x, glyph->uv1.y), 0, 1.0f });
+			run.pages |= 1u << glyph->page;
+			pages[glyph->page].lastFrame = frame; // the rest of this string can't evict what it's already used
+		}
+		pen.x += glyph->advance * toSize;
+	}
+	run.extent = glm::vec2(std::max(width, pen.x), pen.y - ascent * toSize + lineStep);
+	Profiler::Get().AddCounter("text.shaped", 1);
+	return run;
+}
+
+void Font::Draw(const Run& run, const glm::vec2& position, uint32_t color, std::vector<UIVertex>& out) {
+	for (size_t page = 0; page < pages.size(); page++) {
+		if (run.pages & (1u << page)) {
+			pages[page].lastFrame = frame;
+		}
+	}
+	size_t first = out.size();
+	out.insert(out.end(), run.vertices.begin(), run.vertices.end());
+	for (size_t index = first; index < out.size(); index++) {
+		out[index].position.x += position.x;
+		out[index].position.y += position.y;
+		out[index].color = color;
+	}
+}
+// Shaping //
+
+// Glyph Pages //
+const Font::Glyph* Font::GetGlyph(int codepoint) {
+	auto found = glyphs.find(codepoint);
+	if (found != glyphs.end()) {
+		return &found->second;
+	}
+	Glyph glyph = {};
+	glyph.page = -1;
+	int advance, leftBearing;
+	stbtt_GetCodepointHMetrics(font.get(), codepoint, &advance, &leftBearing);
+	glyph.advance = advance * scale;
+
+	int width = 0, height = 0, xOffset = 0, yOffset = 0;
+	unsigned char* field = stbtt_GetCodepointSDF(font.get(), scale, codepoint, glyphPadding, onEdge, distanceScale, &width, &height, &xOffset, &yOffset);
+	if (field) { // null for glyphs without an outline
+		int page;
+		glm::ivec2 position;
+		if (!Place(width, height, page, position)) {
+			stbtt_FreeSDF(field, nullptr);
+			if (!warnedFull) {
+				std::cout << "Error: every glyph page is in use this frame, some text left out" << std::endl;
+				warnedFull = true;
+			}
+			return nullptr; // not remembered, so it's tried again next frame
+		}
+		// white with the distance in alpha, the shader only looks at alpha for glyphs
+		std::vector<unsigned char> rgba((size_t)width * height * 4, 255);
+		for (int pixel = 0; pixel < width * height; pixel++) {
+			rgba[pixel * 4 + 3] = field[pixel];
+		}
+		stbtt_FreeSDF(field, nullptr);
+
+		UIAtlas::Region region;
+		region.position = pages[page].region.position + position;
+		region.extent = glm::ivec2(width, height);
+		region.uv0 = glm::vec2((float)region.position.x / UIAtlas::size, (float)region.position.y / UIAtlas::size);
+		region.uv1 = glm::vec2((float)(region.position.x + width) / UIAtlas::size, (float)(region.position.y + height) / UIAtlas::size);
+		atlas.Write(region, rgba.data());
+		Profiler::Get().AddCounter("text.glyphsBaked", 1);
+
+		glyph.page = page;
+		glyph.uv0 = region.uv0;
+		glyph.uv1 = region.uv1;
+		glyph.offset = glm::vec2((float)xOffset, (float)yOffset);
+		glyph.extent = glm::vec2((float)width, (float)height);
+	}
+	return &(glyphs[codepoint] = glyph);
+}
+
+bool Font::Place(int width, int height, int& page, glm::ivec2& position) {
+	const int gutter = 1;
+	// rows left to right, top to bottom within a page, like the atlas' shelves but all glyphs are about the same height
+	auto fit = [&](Page& candidate) {
+		if (candidate.cursor.x + width > pageSize) {
+			candidate.cursor = glm::ivec2(0, candidate.cursor.y + candidate.rowHeight + gutter);
+			candidate.rowHeight = 0;
+		}
+		if (width > pageSize || candidate.cursor.y + height > pageSize) {
+			return false;
+		}
+		position = candidate.cursor;
+		candidate.cursor.x += width + gutter;
+		candidate.rowHeight = std::max(candidate.rowHeight, height);
+		return true;
+	};
+	for (size_t index = 0; index < pages.size(); index++) {
+		if (fit(pages[index])) {
+			page = (int)index;
+			return true;
+		}
+	}
+
+	// a new page while the atlas has room for one, otherwise the page drawn longest ago (never one drawn this frame)
+	Page fresh = {};
+	if ((int)pages.size() < maxPages && atlas.Allocate(pageSize, pageSize, fresh.region)) {
+		pages.push_back(fresh);
+		page = (int)pages.size() - 1;
+		Evict(page); // clears the pixels, the atlas texture starts out undefined
+	}
+	else {
+		page = -1;
+		for (size_t index = 0; index < pages.size(); index++) {
+			if (pages[index].lastFrame != frame && (page < 0 || pages[index].lastFrame < pages[page].lastFrame)) {
+				page = (int)index;
+			}
+		}
+		if (page < 0) {
+			return false;
+		}
+		Evict(page);
+		Profiler::Get().AddCounter("text.pagesEvicted", 1);
+	}
+	return fit(pages[page]);
+}
+
+void Font::Evict(int page) {
+	for (auto entry = glyphs.begin(); entry != glyphs.end();) {
+		if (entry->second.page == page) {
+			entry = glyphs.erase(entry);
+		}
+		else {
+			++entry;
+		}
+	}
+	Page& evicted = pages[page];
+	evicted.cursor = glm::ivec2(0);
+	evicted.rowHeight = 0;
+	// transparent, so filtering at a new glyph's edge can't pick up what the old ones left behind
+	std::vector<unsigned char> clear((size_t)pageSize * pageSize * 4, 255);
+	for (size_t pixel = 0; pixel < (size_t)pageSize * pageSize; pixel++) {
+		clear[pixel * 4 + 3] = 0;
+	}
+	atlas.Write(evicted.region, clear.data());
+	epoch++; // every run is shaped again the next time it's used, the ones that didn't use this page get the same quads
+}
+// Glyph Pages //
@@ -0,0 +1,128 @@
+#include "framepacer.h"
+#include "profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+void FramePacer::Detect() {
+	// the swap control extension is a WGL or GLX one depending on the platform, either means negative intervals work
+	tearControl = glfwExtensionSupported("WGL_EXT_swap_control_tear") || glfwExtensionSupported("GLX_EXT_swap_control_tear");
+	const GLFWvidmode* mode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+	refreshRate = mode ? mode->refreshRate : 0;
+	std::cout << "Display: " << refreshRate << " Hz (adaptive vsync: " << tearControl << ")\n";
+}
+
+int FramePacer::SwapInterval() const {
+	switch (vsync) {
+	case VSYNC_OFF:
+		return 0;
+	case VSYNC_ADAPTIVE:
+		return tearControl ? -1 : 1;
+	default:
+		return 1;
+	}
+}
+
+void FramePacer::SetFrameCap(double framesPerSecond) {
+	frameCap = framesPerSecond > 0.0 ? framesPerSecond : 0.0;
+	started = false; // start the slots over from the next frame
+}
+
+void FramePacer::BeginFrame() {
+	Clock::time_point waitStart = Clock::now();
+	if (frameCap > 0.0 && started) {
+		WaitUntil(nextFrame);
+	}
+	Clock::time_point now = Clock::now();
+	double waitedMs = std::chrono::duration<double, std::milli>(now - waitStart).count();
+	Profiler::Get().AddTime("pace.wait", waitedMs);
+	waited += waitedMs;
+
+	if (started) {
+		intervals.push_back(std::chrono::duration<double, std::milli>(now - lastFrame).count());
+	}
+	else {
+		lastReport = now;
+	}
+	lastFrame = now;
+
+	if (frameCap > 0.0) {
+		Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / frameCap));
+		nextFrame = started ? nextFrame + period : now + period;
+		if (nextFrame < now) {
+			nextFrame = now + period; // more than a whole frame late, don't try to make up for it with a burst of short frames
+		}
+	}
+	started = true;
+
+	if (reportInterval > 0.0 && std::chrono::duration<double>(now - lastReport).count() >= reportInterval) {
+		Report();
+		lastReport = now;
+	}
+}
+
+void FramePacer::WaitUntil(Clock::time_point deadline) {
+	// Sleep //
+	while (true) {
+		double remaining = std::chrono::duration<double>(deadline - Clock::now()).count();
+		double estimate = sleepMean + std::sqrt(sleepM2 / sleepCount);
+		if (remaining <= estimate) {
+			break;
+		}
+		Clock::time_point start = Clock::now();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		double slept = std::chrono::duration<double>(Clock::now() - start).count();
+
+		sleepCount++;
+		double delta = slept - sleepMean;
+		sleepMean += delta / sleepCount;
+		sleepM2 += delta * (slept - sleepMean);
+		if (sleepCount > 1000) { // forget old samples slowly so the estimate follows the OS timer if it changes
+			sleepM2 *= 0.5;
+			sleepCount = 500;
+		}
+	}
+	// Sleep //
+
+	// Spin //
+	while (Clock::now() < deadline) {
+		std::this_thread::yield();
+	}
+	// Spin //
+}
+
+void FramePacer::Report() {
+	if (intervals.empty()) {
+		return;
+	}
+	double mean = 0.0;
+	for (double interval : intervals) {
+		mean += interval;
+	}
+	mean /= intervals.size();
+	double variance = 0.0;
+	for (double interval : intervals) {
+		variance += (interval - mean) * (interval - mean);
+	}
+	double jitter = std::sqrt(variance / intervals.size());
+
+	// what a frame should take: the cap, else the display when vsync holds frames to it, else whatever is usual
+	double target = mean;
+	if (frameCap > 0.0) {
+		target = 1000.0 / frameCap;
+	}
+	else if (vsync != VSYNC_OFF && refreshRate > 0) {
+		target = 1000.0 / refreshRate;
+	}
+	size_t missed = std::count_if(intervals.begin(), intervals.end(), [target](double interval) { return interval > target * 1.5; });
+
+	std::sort(intervals.begin(), intervals.end());
+	double worst = intervals.back();
+	double p99 = intervals[std::min(intervals.size() - 1, intervals.size() * 99 / 100)];
+
+	std::cout << "Pacing: " << intervals.size() << " frames, " << mean << " ms average (target " << target << " ms), jitter "
+		<< jitter << " ms, 99% " << p99 << " ms, worst " << worst << " ms, " << missed << " late, " << waited << " ms waited\n";
+	intervals.clear();
+	waited = 0.0;
+}
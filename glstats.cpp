@@ -0,0 +1,297 @@
+#include "glstats.h"
+#include "profiler.h"
+#include <glad\gl.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+GLStats& GLStats::Get() {
+	static GLStats stats;
+	return stats;
+}
+
+#ifdef GL_INSTRUMENTATION
+// Functions //
+// every GL function the engine calls, anything missing here still works but goes straight to the driver uncounted
+#define GL_FUNCTIONS(X) \
+	X(glActiveTexture) \
+	X(glAttachShader) \
+	X(glBeginQuery) \
+	X(glBindBuffer) \
+	X(glBindBufferBase) \
+	X(glBindBufferRange) \
+	X(glBindFramebuffer) \
+	X(glBindTexture) \
+	X(glBindVertexArray) \
+	X(glBlendFunc) \
+	X(glBufferData) \
+	X(glBufferStorage) \
+	X(glBufferSubData) \
+	X(glCheckFramebufferStatus) \
+	X(glClear) \
+	X(glClearBufferfv) \
+	X(glClearBufferuiv) \
+	X(glClearColor) \
+	X(glClientWaitSync) \
+	X(glCompileShader) \
+	X(glCopyBufferSubData) \
+	X(glCreateProgram) \
+	X(glCreateShader) \
+	X(glDeleteBuffers) \
+	X(glDeleteFramebuffers) \
+	X(glDeleteProgram) \
+	X(glDeleteQueries) \
+	X(glDeleteShader) \
+	X(glDeleteSync) \
+	X(glDeleteTextures) \
+	X(glDeleteVertexArrays) \
+	X(glDepthFunc) \
+	X(glDepthMask) \
+	X(glDisable) \
+	X(glDispatchCompute) \
+	X(glDrawArrays) \
+	X(glDrawBuffer) \
+	X(glDrawElements) \
+	X(glDrawElementsBaseVertex) \
+	X(glEnable) \
+	X(glEnableVertexAttribArray) \
+	X(glEndQuery) \
+	X(glFenceSync) \
+	X(glFramebufferTexture2D) \
+	X(glGenBuffers) \
+	X(glGenFramebuffers) \
+	X(glGenQueries) \
+	X(glGenTextures) \
+	X(glGenVertexArrays) \
+	X(glGenerateMipmap) \
+	X(glGetIntegerv) \
+	X(glGetProgramiv) \
+	X(glGetQueryObjectui64v) \
+	X(glGetQueryObjectuiv) \
+	X(glGetShaderInfoLog) \
+	X(glGetShaderiv) \
+	X(glGetUniformBlockIndex) \
+	X(glGetUniformLocation) \
+	X(glLinkProgram) \
+	X(glMapBufferRange) \
+	X(glMemoryBarrier) \
+	X(glMultiDrawElementsIndirect) \
+	X(glMultiDrawElementsIndirectCountARB) \
+	X(glPixelStorei) \
+	X(glReadBuffer) \
+	X(glReadPixels) \
+	X(glShaderSource) \
+	X(glTexImage2D) \
+	X(glTexParameterfv) \
+	X(glTexParameteri) \
+	X(glTexSubImage2D) \
+	X(glUniform1i) \
+	X(glUniform1ui) \
+	X(glUniform2f) \
+	X(glUniform4fv) \
+	X(glUniformBlockBinding) \
+	X(glUniformMatrix4fv) \
+	X(glUnmapBuffer) \
+	X(glUseProgram) \
+	X(glVertexAttribDivisor) \
+	X(glVertexAttribIPointer) \
+	X(glVertexAttribPointer) \
+	X(glViewport)
+
+namespace {
+	enum Function {
+#define X(name) FUNCTION_##name,
+		GL_FUNCTIONS(X)
+#undef X
+		FUNCTION_COUNT
+	};
+
+	const char* const functionNames[FUNCTION_COUNT] = {
+#define X(name) #name,
+		GL_FUNCTIONS(X)
+#undef X
+	};
+
+	struct Record {
+		long long calls = 0; // since Install
+		double milliseconds = 0.0;
+		long long errors = 0;
+		long long frameCalls = 0; // since the last EndFrame
+		double frameMilliseconds = 0.0;
+	};
+	Record records[FUNCTION_COUNT];
+	bool checking = false; // checkErrors as of the last Install or EndFrame, so the wrappers don't go through Get
+	long long frameErrors = 0;
+}
+// Functions //
+
+// Wrappers //
+namespace {
+	typedef std::chrono::high_resolution_clock Clock;
+
+	// lives for the length of one call, the destructor runs once the driver has returned
+	class CallScope {
+	public:
+		CallScope(Function callFunction) : function(callFunction), start(Clock::now()) {}
+		~CallScope() {
+			double milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+			Record& record = records[function];
+			record.calls++;
+			record.milliseconds += milliseconds;
+			record.frameCalls++;
+			record.frameMilliseconds += milliseconds;
+			if (checking) {
+				// glGetError is never wrapped, so this doesn't count itself
+				for (GLenum error = glad_glGetError(); error != GL_NO_ERROR; error = glad_glGetError()) {
+					record.errors++;
+					frameErrors++;
+					std::cout << "Error: GL error 0x" << std::hex << error << std::dec << " from " << functionNames[function] << std::endl;
+				}
+			}
+		}
+	private:
+		Function function;
+		Clock::time_point start;
+	};
+
+	// one wrapper per function, picked out by its index since a function pointer can't be a template parameter without
+	// knowing its type up front (that takes C++17's template<auto>). the signature comes from glad's pointer type
+	template <Function function, typename Pointer>
+	struct Wrapper;
+
+	template <Function function, typename Result, typename... Arguments>
+	struct Wrapper<function, Result (GLAD_API_PTR*)(Arguments...)> {
+		static Result (GLAD_API_PTR* original)(Arguments...);
+		static Result GLAD_API_PTR Call(Arguments... arguments) {
+			CallScope scope(function);
+			return original(arguments...);
+		}
+	};
+
+	template <Function function, typename Result, typename... Arguments>
+	Result (GLAD_API_PTR* Wrapper<function, Result (GLAD_API_PTR*)(Arguments...)>::original)(Arguments...) = nullptr;
+}
+// Wrappers //
+#endif
+
+GLStats::GLStats() : installed(false), frames(0) {
+#ifdef GL_CHECK_ERRORS
+	checkErrors = true;
+#else
+	checkErrors = false;
+#endif
+}
+
+bool GLStats::Available() {
+#ifdef GL_INSTRUMENTATION
+	return true;
+#else
+	return false;
+#endif
+}
+
+void GLStats::Install() {
+#ifdef GL_INSTRUMENTATION
+	if (installed) {
+		return; // wrapping the wrappers would count everything twice
+	}
+	installed = true;
+	checking = checkErrors;
+	// functions the driver doesn't have stay null, capability checks that look at the pointer still see that
+#define X(name) \
+	if (glad_##name) { \
+		Wrapper<FUNCTION_##name, decltype(glad_##name)>::original = glad_##name; \
+		glad_##name = &Wrapper<FUNCTION_##name, decltype(glad_##name)>::Call; \
+	}
+	GL_FUNCTIONS(X)
+#undef X
+	std::cout << "GL instrumentation on, " << FUNCTION_COUNT << " functions wrapped" << (checkErrors ? ", checking errors" : "") << std::endl;
+#endif
+}
+
+void GLStats::EndFrame() {
+#ifdef GL_INSTRUMENTATION
+	if (!installed) {
+		return;
+	}
+	checking = checkErrors;
+	Profiler& profiler = Profiler::Get();
+	long long calls = 0;
+	double milliseconds = 0.0;
+	for (int function = 0; function < FUNCTION_COUNT; function++) {
+		Record& record = records[function];
+		if (record.frameCalls == 0) {
+			continue; // only what was called, there's a lot of them to read through otherwise
+		}
+		std::string name = std::string("gl.") + functionNames[function];
+		profiler.AddCounter(name, record.frameCalls);
+		profiler.AddTime(name, record.frameMilliseconds);
+		calls += record.frameCalls;
+		milliseconds += record.frameMilliseconds;
+		record.frameCalls = 0;
+		record.frameMilliseconds = 0.0;
+	}
+	profiler.AddCounter("gl.calls", calls);
+	profiler.AddTime("gl.driver", milliseconds);
+	if (checkErrors) {
+		profiler.AddCounter("gl.errors", frameErrors);
+	}
+	frameErrors = 0;
+	frames++;
+#endif
+}
+
+bool GLStats::WriteJSON(const std::string& path) const {
+#ifdef GL_INSTRUMENTATION
+	std::ofstream out(path, std::ios::trunc);
+	if (!out) {
+		std::cout << "Error: couldn't write " << path << std::endl;
+		return false;
+	}
+	std::vector<int> order;
+	long long calls = 0;
+	double milliseconds = 0.0;
+	long long errors = 0;
+	for (int function = 0; function < FUNCTION_COUNT; function++) {
+		const Record& record = records[function];
+		if (record.calls > 0) {
+			order.push_back(function);
+			calls += record.calls;
+			milliseconds += record.milliseconds;
+			errors += record.errors;
+		}
+	}
+	std::sort(order.begin(), order.end(), [](int a, int b) { return records[a].milliseconds > records[b].milliseconds; });
+	double perFrame = frames > 0 ? 1.0 / frames : 0.0;
+
+	// names are GL function names so nothing needs escaping
+	out.setf(std::ios::fixed);
+	out.precision(4);
+	out << "{\n";
+	out << "  \"frames\": " << frames << ",\n";
+	out << "  \"errorsChecked\": " << (checkErrors ? "true" : "false") << ",\n";
+	out << "  \"calls\": " << calls << ",\n";
+	out << "  \"callsPerFrame\": " << calls * perFrame << ",\n";
+	out << "  \"driverMs\": " << milliseconds << ",\n";
+	out << "  \"driverMsPerFrame\": " << milliseconds * perFrame << ",\n";
+	out << "  \"errors\": " << errors << ",\n";
+	out << "  \"functions\": [";
+	for (size_t entry = 0; entry < order.size(); entry++) {
+		const Record& record = records[order[entry]];
+		out << (entry > 0 ? ",\n" : "\n");
+		out << "    { \"name\": \"" << functionNames[order[entry]] << "\", \"calls\": " << record.calls
+			<< ", \"callsPerFrame\": " << record.calls * perFrame << ", \"ms\": " << record.milliseconds
+			<< ", \"msPerFrame\": " << record.milliseconds * perFrame << ", \"usPerCall\": " << record.milliseconds * 1000.0 / record.calls
+			<< ", \"errors\": " << record.errors << " }";
+	}
+	out << "\n  ]\n}\n";
+	if (out) {
+		std::cout << "Wrote GL call stats for " << frames << " frames to " << path << std::endl;
+	}
+	return (bool)out;
+#else
+	(void)path;
+	return false;
+#endif
+}
@@ -0,0 +1,195 @@
+#include "gpuculling.h"
+#include "glcaps.h"
+#include "indirectrenderer.h"
+#include "occlusion.h"
+#include "scene.h"
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+
+GPUCulling::GPUCulling(IndirectRenderer& r, HiZOcclusion* p) : renderer(r), pyramid(p), cullShader("assets/shaders/cull.comp"),
+	numInstances(0), uploadedLayout(0), movedRead(0), uploaded(false), compact(GLCaps::Get().indirectCount), pyramidValid(false) {
+	instanceBuffer = GLBuffer::Create("gpu culling");
+	transformBuffer = GLBuffer::Create("gpu culling");
+	commandBuffer = GLBuffer::Create("gpu culling");
+	countBuffer = GLBuffer::Create("gpu culling");
+
+	unsigned int zero = 0;
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, countBuffer.ID());
+	BufferData(GL_SHADER_STORAGE_BUFFER, countBuffer, sizeof(unsigned int), &zero, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+bool GPUCulling::Supported() {
+	return IndirectRenderer::Supported() && GLCaps::Get().computeShaders;
+}
+
+void GPUCulling::Unload() {
+	cullShader.Unload();
+	instanceBuffer.Reset();
+	transformBuffer.Reset();
+	commandBuffer.Reset();
+	countBuffer.Reset();
+	uploaded = false;
+	pyramidValid = false;
+}
+
+void GPUCulling::WriteInstances(const Scene& scene, GameObject object, unsigned int first) {
+	unsigned int model = scene.renders[object].model;
+	const Model& source = *scene.models[model];
+	for (unsigned int mesh = 0; mesh < source.numMeshes; mesh++) {
+		const IndirectRenderer::PooledMesh& pooled = renderer.Mesh(model, mesh);
+		AABB box = source.meshBounds[mesh].Transformed(scene.worldMatrices[object]);
+		instances[first + mesh] = { glm::vec4(box.min, 0.0f), glm::vec4(box.max, 0.0f), pooled.indexCount, pooled.firstIndex, pooled.baseVertex, scene.renders[object].flags };
+		transforms[first + mesh] = scene.worldMatrices[object] * source.transforms[mesh];
+	}
+}
+
+void GPUCulling::UploadInstances(const Scene& scene) {
+	ScopedTimer timer("gpucull.upload");
+	// every object's instances are counted out first, so UploadMoved can find them again
+	objectInstances.resize(scene.Size());
+	unsigned int count = 0;
+	for (GameObject object = 0; object < scene.Size(); object++) {
+		if (!(scene.renders[object].flags & RENDER_VISIBLE)) {
+			objectInstances[object] = noInstance;
+			continue;
+		}
+		objectInstances[object] = count;
+		count += scene.models[scene.renders[object].model]->numMeshes;
+	}
+	instances.resize(count);
+	transforms.resize(count);
+	for (GameObject object = 0; object < scene.Size(); object++) {
+		if (objectInstances[object] != noInstance) {
+			WriteInstances(scene, object, objectInstances[object]);
+		}
+	}
+	numInstances = count;
+
+	// dynamic rather than static, moved objects are written into these in place
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, instanceBuffer.ID());
+	BufferData(GL_SHADER_STORAGE_BUFFER, instanceBuffer, instances.size() * sizeof(Instance), instances.data(), GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, transformBuffer.ID());
+	BufferData(GL_SHADER_STORAGE_BUFFER, transformBuffer, transforms.size() * sizeof(glm::mat4), transforms.data(), GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, commandBuffer.ID());
+	BufferData(GL_SHADER_STORAGE_BUFFER, commandBuffer, instances.size() * sizeof(DrawElementsIndirectCommand), NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	uploadedLayout = scene.LayoutVersion();
+	movedRead = scene.MovedObjects().size();
+	uploaded = true;
+}
+
+void GPUCulling::UploadMoved(const Scene& scene) {
+	const std::vector<GameObject>& moved = scene.MovedObjects();
+	if (movedRead >= moved.size()) {
+		return;
+	}
+	ScopedTimer timer("gpucull.uploadMoved");
+	dirtyInstances.clear();
+	for (size_t entry = movedRead; entry < moved.size(); entry++) {
+		GameObject object = moved[entry];
+		unsigned int first = objectInstances[object];
+		if (first == noInstance) {
+			continue;
+		}
+		WriteInstances(scene, object, first);
+		unsigned int meshes = scene.models[scene.renders[object].model]->numMeshes;
+		for (unsigned int mesh = 0; mesh < meshes; mesh++) {
+			dirtyInstances.push_back(first + mesh);
+		}
+	}
+	movedRead = moved.size();
+	std::sort(dirtyInstances.begin(), dirtyInstances.end());
+	dirtyInstances.erase(std::unique(dirtyInstances.begin(), dirtyInstances.end()), dirtyInstances.end());
+
+	// Ranges //
+	// one glBufferSubData per run of dirty instances, runs with only a few clean instances between them go up as one so
+	// a lot of scattered moves don't turn into a call each
+	const unsigned int mergeGap = 64;
+	size_t uploadedInstances = 0;
+	size_t run = 0;
+	while (run < dirtyInstances.size()) {
+		size_t last = run;
+		while (last + 1 < dirtyInstances.size() && dirtyInstances[last + 1] - dirtyInstances[last] <= mergeGap) {
+			last++;
+		}
+		unsigned int first = dirtyInstances[run];
+		unsigned int count = dirtyInstances[last] - first + 1;
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, instanceBuffer.ID());
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, first * sizeof(Instance), count * sizeof(Instance), &instances[first]);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, transformBuffer.ID());
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, first * sizeof(glm::mat4), count * sizeof(glm::mat4), &transforms[first]);
+		uploadedInstances += count;
+		run = last + 1;
+	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	Profiler::Get().AddCounter("gpucull.movedInstances", uploadedInstances);
+	// Ranges //
+}
+
+void GPUCulling::Draw(const Scene& scene, const glm::mat4& viewProjection) {
+	renderer.Update(scene);
+	if (!uploaded || uploadedLayout != scene.LayoutVersion()) {
+		UploadInstances(scene);
+	}
+	else {
+		UploadMoved(scene);
+	}
+	Profiler::Get().AddCounter("gpucull.instances", numInstances);
+
+	if (numInstances > 0) {
+		// Cull //
+		ScopedTimer timer("gpucull.dispatch"); // CPU side only, the GPU runs it whenever it gets there
+		unsigned int zero = 0;
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, countBuffer.ID());
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(unsigned int), &zero);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+		glUseProgram(cullShader.ID());
+		glUniform1ui(glGetUniformLocation(cullShader.ID(), "numInstances"), numInstances);
+		Frustum frustum(viewProjection);
+		glUniform4fv(glGetUniformLocation(cullShader.ID(), "frustumPlanes"), 6, glm::value_ptr(frustum.planes[0]));
+		glUniform1i(glGetUniformLocation(cullShader.ID(), "compact"), compact);
+
+		bool useOcclusion = pyramid && pyramidValid;
+		glUniform1i(glGetUniformLocation(cullShader.ID(), "useOcclusion"), useOcclusion);
+		if (useOcclusion) {
+			glActiveTexture(GL_TEXTURE1); // leave unit 0 to the material textures
+			glBindTexture(GL_TEXTURE_2D, pyramid->DepthPyramid());
+			glUniform1i(glGetUniformLocation(cullShader.ID(), "depthPyramid"), 1);
+			glUniformMatrix4fv(glGetUniformLocation(cullShader.ID(), "pyramidViewProjection"), 1, GL_FALSE, glm::value_ptr(pyramid->PyramidViewProjection()));
+			glUniform2f(glGetUniformLocation(cullShader.ID(), "pyramidSize"), (float)pyramid->Width(), (float)pyramid->Height());
+			glUniform1i(glGetUniformLocation(cullShader.ID(), "pyramidLevels"), pyramid->Levels());
+		}
+
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, instanceBuffer.ID());
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, commandBuffer.ID());
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, countBuffer.ID());
+		glDispatchCompute((numInstances + 63) / 64, 1, 1);
+		// the commands and count are read by the draw itself, not by a shader
+		glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+
+		if (useOcclusion) {
+			glBindTexture(GL_TEXTURE_2D, 0);
+			glActiveTexture(GL_TEXTURE0);
+		}
+		// Cull //
+
+		// Draw //
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, transformBuffer.ID());
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer.ID());
+		renderer.Submit(numInstances, compact ? countBuffer.ID() : 0);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		Profiler::Get().AddCounter("draw.gpuDriven", numInstances); // how many survive (and their triangles) is only known on the GPU
+		// Draw //
+	}
+
+	// Next Frame's Pyramid //
+	// drawn after the culling so it is always one frame behind, the occlusion test reprojects boxes with the old camera
+	if (pyramid) {
+		pyramid->Render(scene, viewProjection);
+		pyramidValid = true;
+	}
+	// Next Frame's Pyramid //
+}
@@ -0,0 +1,182 @@
+#include "gpuresource.h"
+
+GPUResourceRegistry& GPUResourceRegistry::Get() {
+	static GPUResourceRegistry registry; // constructed on first use
+	return registry;
+}
+
+GPUResourceRegistry::GPUResourceRegistry() {
+	for (int type = 0; type < (int)GPUResourceType::Count; type++) {
+		totalBytes[type] = 0;
+		liveCount[type] = 0;
+	}
+}
+
+void GPUResourceRegistry::Track(GPUResourceType type, unsigned int id, const std::string& owner) {
+	std::lock_guard<std::mutex> lock(mutex);
+	entries[Key(type, id)] = { owner, 0 };
+
+	auto found = owners.find(owner);
+	if (found == owners.end()) { // first resource for this owner so zero its totals
+		OwnerTotals totals;
+		for (int t = 0; t < (int)GPUResourceType::Count; t++) {
+			totals.bytes[t] = 0;
+			totals.count[t] = 0;
+		}
+		found = owners.emplace(owner, totals).first;
+	}
+	found->second.count[(int)type]++;
+	liveCount[(int)type]++;
+}
+
+void GPUResourceRegistry::Untrack(GPUResourceType type, unsigned int id) {
+	std::lock_guard<std::mutex> lock(mutex);
+	auto entry = entries.find(Key(type, id));
+	if (entry == entries.end()) {
+		std::cout << "Error: Untracking a GPU resource that was never tracked.\n";
+		return;
+	}
+
+	auto owner = owners.find(entry->second.owner);
+	owner->second.bytes[(int)type] -= entry->second.bytes;
+	owner->second.count[(int)type]--;
+	bool empty = true; // drop owners with nothing left so unloaded models disappear from the report
+	for (int t = 0; t < (int)GPUResourceType::Count; t++) {
+		if (owner->second.count[t] != 0) {
+			empty = false;
+		}
+	}
+	if (empty) {
+		owners.erase(owner);
+	}
+
+	totalBytes[(int)type] -= entry->second.bytes;
+	liveCount[(int)type]--;
+	entries.erase(entry);
+}
+
+void GPUResourceRegistry::SetBytes(GPUResourceType type, unsigned int id, size_t bytes) {
+	std::lock_guard<std::mutex> lock(mutex);
+	auto entry = entries.find(Key(type, id));
+	if (entry == entries.end()) {
+		return; // untracked objects (e.g. created directly with glGen*) are ignored
+	}
+
+	OwnerTotals& owner = owners[entry->second.owner];
+	owner.bytes[(int)type] = owner.bytes[(int)type] - entry->second.bytes + bytes;
+	totalBytes[(int)type] = totalBytes[(int)type] - entry->second.bytes + bytes;
+	entry->second.bytes = bytes;
+}
+
+size_t GPUResourceRegistry::OwnerBytes(const std::string& owner) const {
+	std::lock_guard<std::mutex> lock(mutex);
+	auto found = owners.find(owner);
+	if (found == owners.end()) {
+		return 0;
+	}
+	size_t bytes = 0;
+	for (int type = 0; type < (int)GPUResourceType::Count; type++) {
+		bytes += found->second.bytes[type];
+	}
+	return bytes;
+}
+
+size_t GPUResourceRegistry::TotalBytes(GPUResourceType type) const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return totalBytes[(int)type];
+}
+
+size_t GPUResourceRegistry::TotalBytes() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	size_t bytes = 0;
+	for (int type = 0; type < (int)GPUResourceType::Count; type++) {
+		bytes += totalBytes[type];
+	}
+	return bytes;
+}
+
+unsigned int GPUResourceRegistry::LiveCount(GPUResourceType type) const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return liveCount[(int)type];
+}
+
+unsigned int GPUResourceRegistry::LiveCount() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	unsigned int count = 0;
+	for (int type = 0; type < (int)GPUResourceType::Count; type++) {
+		count += liveCount[type];
+	}
+	return count;
+}
+
+void GPUResourceRegistry::Report() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	const char* typeNames[] = { "buffers", "textures", "programs", "vertex arrays", "framebuffers" };
+
+	std::cout << "GPU resources:\n";
+	for (const auto& owner : owners) {
+		std::cout << "  " << owner.first << ":";
+		for (int type = 0; type < (int)GPUResourceType::Count; type++) {
+			if (owner.second.count[type] != 0) {
+				std::cout << " " << owner.second.count[type] << " " << typeNames[type] << " (" << owner.second.bytes[type] / 1024 << " KB)";
+			}
+		}
+		std::cout << "\n";
+	}
+	if (owners.empty()) {
+		std::cout << "  none\n";
+	}
+}
+
+namespace GLObjects {
+	unsigned int Generate(GPUResourceType type) {
+		unsigned int id = 0;
+		switch (type) {
+		case GPUResourceType::Buffer:
+			glGenBuffers(1, &id);
+			break;
+		case GPUResourceType::Texture:
+			glGenTextures(1, &id);
+			break;
+		case GPUResourceType::Program:
+			id = glCreateProgram();
+			break;
+		case GPUResourceType::VertexArray:
+			glGenVertexArrays(1, &id);
+			break;
+		case GPUResourceType::Framebuffer:
+			glGenFramebuffers(1, &id);
+			break;
+		default:
+			std::cout << "Error: Unknown GPU resource type.\n";
+		}
+		return id;
+	}
+
+	void Delete(GPUResourceType type, unsigned int id) {
+		switch (type) {
+		case GPUResourceType::Buffer:
+			glDeleteBuffers(1, &id);
+			break;
+		case GPUResourceType::Texture:
+			glDeleteTextures(1, &id);
+			break;
+		case GPUResourceType::Program:
+			glDeleteProgram(id);
+			break;
+		case GPUResourceType::VertexArray:
+			glDeleteVertexArrays(1, &id);
+			break;
+		case GPUResourceType::Framebuffer:
+			glDeleteFramebuffers(1, &id);
+			break;
+		default:
+			std::cout << "Error: Unknown GPU resource type.\n";
+		}
+	}
+}
+
+void BufferData(GLenum target, const GLBuffer& buffer, size_t bytes, const void* data, GLenum usage) {
+	glBufferData(target, bytes, data, usage);
+	GPUResourceRegistry::Get().SetBytes(GPUResourceType::Buffer, buffer.ID(), bytes);
+}
@@ -0,0 +1,56 @@
+#include "gputimer.h"
+#include "profiler.h"
+
+GPUTimer::GPUTimer(const char* timerName) : name(timerName), nextQuery(0), running(false) {
+	glGenQueries(numQueries, queries);
+	for (unsigned int query = 0; query < numQueries; query++) {
+		pending[query] = false;
+	}
+}
+
+void GPUTimer::Begin() {
+	// oldest first, and stop at the first one that isn't ready since the GPU finishes them in order. after a stall several
+	// are ready at once, they're all read to free them but only the newest is reported, AddTime would sum them into one
+	// frame and show a spike that never happened
+	bool finished = false;
+	GLuint64 newest = 0;
+	for (unsigned int offset = 0; offset < numQueries; offset++) {
+		unsigned int query = (nextQuery + offset) % numQueries;
+		if (!pending[query]) {
+			continue;
+		}
+		GLuint available = GL_FALSE;
+		glGetQueryObjectuiv(queries[query], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) {
+			break;
+		}
+		glGetQueryObjectui64v(queries[query], GL_QUERY_RESULT, &newest);
+		finished = true;
+		pending[query] = false;
+	}
+	if (finished) {
+		Profiler::Get().AddTime(name, newest / 1000000.0);
+	}
+
+	running = !pending[nextQuery];
+	if (running) {
+		glBeginQuery(GL_TIME_ELAPSED, queries[nextQuery]);
+	}
+}
+
+void GPUTimer::End() {
+	if (!running) {
+		return;
+	}
+	glEndQuery(GL_TIME_ELAPSED);
+	pending[nextQuery] = true;
+	nextQuery = (nextQuery + 1) % numQueries;
+	running = false;
+}
+
+void GPUTimer::Unload() {
+	glDeleteQueries(numQueries, queries);
+	for (unsigned int query = 0; query < numQueries; query++) {
+		pending[query] = false;
+	}
+}
@@ -0,0 +1,91 @@
+#ifndef AUTOSAVE_H
+#define AUTOSAVE_H
+#include <gameobject.h>
+#include <chunkedarray.h>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef ChunkedArray<TransformComponent> TransformChunks;
+
+// Autosave File //
+// both autosave files are this header followed by one record per chunk: the chunk index, the size of its diff and the
+// diff (DeltaCodec). the base holds every chunk diffed against zeros, the delta holds only the chunks that differ from
+// the base, diffed against the base's copy. the delta names the generation of the base it was made against, so a delta
+// left over from before a new base was written is never applied to it. both also carry a hash of the level file the
+// autosave was made on top of, so it's only recovered over that exact file, never over one saved since or swapped in
+struct AutosaveHeader {
+	char magic[4]; // "ASV" and a zero
+	uint32_t version;
+	uint32_t isDelta;
+	uint32_t generation;
+	uint32_t transformSize; // sizeof(TransformComponent)
+	uint32_t chunkSize; // objects per chunk
+	uint32_t objectCount;
+	uint32_t recordCount;
+	uint64_t levelHash; // FNV-1a of the level file's bytes, 0 when there was no level file
+};
+// Autosave File //
+
+// Autosave //
+// saves the level's transforms every few seconds without holding up the frame. the main thread only takes a snapshot of
+// the chunked transforms (a pointer per chunk, see ChunkedArray) and hands it to a worker thread, which does the rest:
+// chunks the snapshot still shares with the last autosave aren't looked at again, changed ones are diffed against the
+// base and compressed, and the files are written to a temporary name, flushed to disk and renamed over the old ones so a
+// crash mid-save leaves the previous autosave intact. once the delta grows past half the base a new base is written
+class Autosave {
+public:
+	Autosave() {}
+	~Autosave() { Stop(); }
+
+	// the delta is written next to it as basePath + ".delta", levelPath is the level file the autosave is stamped with
+	void Start(const std::string& basePath, const std::string& levelPath, double intervalSeconds);
+	// call every frame with the state worth saving, hands it over once the interval has passed and the last save is done
+	void Update(const TransformChunks& transforms, double frameSeconds);
+	// call once the level file has been written or loaded successfully, from any thread. snapshots handed over before then
+	// are dropped and the autosave files are deleted, the next autosave starts a new base stamped with the new level file
+	void LevelChanged();
+	void Stop(); // finishes the save in progress, if any
+
+	// reads the last autosave back, false if there isn't one, it's damaged, or it was made on top of anything other than
+	// the level file at levelPath as it is now
+	static bool Recover(const std::string& basePath, const std::string& levelPath, std::vector<TransformComponent>& transforms);
+	static void Discard(const std::string& basePath); // deletes the base and delta, for a clean exit
+
+private:
+	void Loop();
+	void Save(const TransformChunks& snapshot);
+	bool WriteBase(const TransformChunks& snapshot);
+
+	std::string basePath;
+	std::string deltaPath;
+	std::string levelPath;
+	double interval = 0.0;
+	double sinceLastSave = 0.0;
+
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable wake;
+	bool busy = false; // a snapshot is waiting or being saved
+	bool quit = false;
+	TransformChunks pending; // handed over by Update
+	uint32_t levelEpoch = 0; // bumped by LevelChanged
+	uint32_t pendingEpoch = 0; // levelEpoch when pending was taken
+
+	// Worker //
+	// only touched by the worker thread
+	TransformChunks base; // what the base file holds
+	TransformChunks last; // what the last save looked at
+	std::vector<std::vector<unsigned char>> chunkDeltas; // per chunk diff against the base, empty where it matches
+	uint32_t generation = 0;
+	uint32_t savedEpoch = 0; // the levelEpoch the files on disk belong to
+	uint64_t levelHash = 0; // stamped into the base and its deltas
+	bool hasBase = false;
+	// Worker //
+};
+// Autosave //
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef BOUNDS_H
+#define BOUNDS_H
+#include <glm/glm.hpp> // openGL Mathematics
+#include <cfloat>
+#include <vector>
+
+// Axis Aligned Bounding Box //
+struct AABB {
+	glm::vec3 min;
+	glm::vec3 max;
+
+	AABB() : min(FLT_MAX), max(-FLT_MAX) {} // starts 'inside out' so the first Expand sets it properly
+	AABB(const glm::vec3& minimum, const glm::vec3& maximum) : min(minimum), max(maximum) {}
+
+	bool Empty() const { return min.x > max.x; }
+	glm::vec3 Center() const { return (min + max) * 0.5f; }
+	glm::vec3 Extents() const { return (max - min) * 0.5f; } // half size
+	float SurfaceArea() const;
+	void Expand(const glm::vec3& point);
+	void Expand(const AABB& box);
+	AABB Transformed(const glm::mat4& matrix) const; // box around this box after it has been moved/rotated/scaled
+};
+// Axis Aligned Bounding Box //
+
+// Bounding Sphere //
+struct BoundingSphere {
+	glm::vec3 center;
+	float radius;
+
+	BoundingSphere() : center(0.0f), radius(0.0f) {}
+	BoundingSphere(const glm::vec3& c, float r) : center(c), radius(r) {}
+	BoundingSphere Transformed(const glm::mat4& matrix) const;
+};
+// Bounding Sphere //
+
+// Frustum //
+// the six planes of the camera's view volume, pulled straight out of projection * view
+// planes are stored as (normal, distance) with the normals pointing inwards
+struct Frustum {
+	glm::vec4 planes[6]; // left, right, bottom, top, near, far
+
+	Frustum() {}
+	explicit Frustum(const glm::mat4& viewProjection);
+	bool Intersects(const AABB& box) const;
+	bool Intersects(const BoundingSphere& sphere) const;
+};
+// Frustum //
+
+// Bounds List //
+// the same boxes and spheres laid out one component per array so the culling kernel can test 4 (SSE) or 8 (AVX) at once,
+// arrays are padded to a multiple of 8 so the kernel never needs a scalar tail
+class BoundsList {
+public:
+	void Clear();
+	void Add(const AABB& box, const BoundingSphere& sphere);
+	void Set(unsigned int index, const AABB& box, const BoundingSphere& sphere);
+	unsigned int Size() const { return count; }
+
+	// writes 1 into visible[i] for every entry that touches the frustum and 0 otherwise, returns how many were visible
+	// visible needs room for Size() entries
+	unsigned int Cull(const Frustum& frustum, unsigned char* visible) const;
+
+private:
+	void Pad();
+
+	unsigned int count = 0;
+	std::vector<float> centerX, centerY, centerZ;
+	std::vector<float> extentX, extentY, extentZ;
+	std::vector<float> radius;
+};
+// Bounds List //
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef BVH_H
+#define BVH_H
+#include <bounds.h>
+#include <functional>
+#include <vector>
+
+// Bounding Volume Hierarchy //
+// a dynamic tree of boxes over every object in the scene, each leaf holds one object's (slightly fattened) box
+// and every parent's box wraps its two children, so whole branches can be skipped at once when culling or ray casting
+//
+// insertion picks the sibling using the surface area heuristic (SAH), and every node on the way back up is refit
+// and 'rotated' (swapping a child with a grandchild) whenever that shrinks the tree's total surface area
+class BVH {
+public:
+	static const int nullNode = -1;
+	static const unsigned int maxFrusta = 8; // per QueryFrusta call
+
+	BVH();
+
+	int Insert(const AABB& box, unsigned int userData); // returns a proxy used to move/remove the leaf later
+	// a leaf that isn't placed in the tree yet, call Build after the last one. much quicker than Insert for whole levels
+	int Add(const AABB& box, unsigned int userData);
+	void Remove(int proxy);
+	void Move(int proxy, const AABB& box); // call whenever the object's box changes
+	void SetUserData(int proxy, unsigned int userData) { nodes[proxy].userData = userData; }
+	unsigned int UserData(int proxy) const { return nodes[proxy].userData; }
+	const AABB& FatBounds(int proxy) const { return nodes[proxy].box; }
+	void Clear();
+
+	void Build(); // throws away the internal nodes and rebuilds them top down with a binned SAH split, use after loading a level
+
+	// adds the user data of every leaf touching the frustum, branches fully inside are added without testing their leaves
+	void QueryFrustum(const Frustum& frustum, std::vector<unsigned int>& results) const;
+	// the same for several frusta (views) in one walk, so a node every view can see is only visited once, and a branch
+	// stops being tested against a frustum once it's fully inside it. masks gets a bit per frustum for each result
+	void QueryFrusta(const Frustum* frusta, unsigned int count, std::vector<unsigned int>& results, std::vector<unsigned char>& masks) const;
+	// walks leaves along the ray nearest first, callback gets (userData, current max distance) and returns the new max distance
+	// (return the hit distance to clip the ray, or the max distance passed in to keep going), returns the final max distance
+	float RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, const std::function<float(unsigned int, float)>& callback) const;
+
+	int Height() const { return root == nullNode ? 0 : nodes[root].height; }
+	float fatMargin; // leaves are grown by this much so small movements don't touch the tree at all
+
+private:
+	struct Node {
+		AABB box;
+		int parent; // doubles as the 'next' link while the node is on the free list
+		int child1;
+		int child2;
+		int height; // 0 for leaves, -1 while free
+		unsigned int userData;
+		bool IsLeaf() const { return child1 == nullNode; }
+	};
+
+	int AllocateNode();
+	void FreeNode(int node);
+	void InsertLeaf(int leaf);
+	void RemoveLeaf(int leaf);
+	void RefitUpwards(int node); // refits and rotates every node from here to the root
+	void Rotate(int node);
+	int BuildRange(std::vector<int>& leaves, int begin, int end);
+	void CollectLeaves(int node, std::vector<unsigned int>& results) const;
+	void CollectLeaves(int node, unsigned char mask, std::vector<unsigned int>& results, std::vector<unsigned char>& masks) const;
+
+	std::vector<Node> nodes;
+	int root;
+	int freeList;
+};
+// Bounding Volume Hierarchy //
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+#include <glm/glm.hpp> // openGL Mathematics
+#include <glm/gtc/matrix_transform.hpp>
+#include <bounds.h>
+
+// Camera //
+// a perspective camera that works out its matrices and frustum on demand. setters only mark what they change as dirty
+// (and only when the value actually changed), so a camera that sits still costs nothing per frame and one that only
+// turns never rebuilds its projection. the aspect ratio comes from the framebuffer it draws into, set with SetViewport
+class Camera {
+public:
+	Camera(float fovDegrees = 45.0f, float nearPlane = 0.1f, float farPlane = 100.0f);
+
+	void SetPosition(const glm::vec3& position);
+	void SetRotation(float yawDegrees, float pitchDegrees); // yaw -90 looks down -z
+	void SetPerspective(float fovDegrees, float nearPlane, float farPlane);
+	void SetViewport(int width, int height); // ignored while either is 0 (minimized window), the last aspect is kept
+
+	const glm::vec3& Position() const { return position; }
+	glm::vec3 Front() const { return Direction(yaw, pitch); }
+	float Yaw() const { return yaw; }
+	float Pitch() const { return pitch; }
+	float Aspect() const { return aspect; }
+
+	// Cached //
+	const glm::mat4& View() const;
+	const glm::mat4& Projection() const;
+	const glm::mat4& ViewProjection() const;
+	const Frustum& ViewFrustum() const;
+	// Cached //
+
+	static glm::vec3 Direction(float yawDegrees, float pitchDegrees); // unit vector the angles look along
+	static const glm::vec3 worldUp;
+
+private:
+	glm::vec3 position;
+	float yaw;
+	float pitch;
+	float fov;
+	float nearPlane;
+	float farPlane;
+	float aspect;
+
+	mutable glm::mat4 view;
+	mutable glm::mat4 projection;
+	mutable glm::mat4 viewProjection;
+	mutable Frustum frustum;
+	mutable bool viewDirty;
+	mutable bool projectionDirty;
+	mutable bool viewProjectionDirty; // covers the frustum too
+};
+// Camera //
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef CHUNKEDARRAY_H
+#define CHUNKEDARRAY_H
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Chunked Array //
+// an array stored as fixed size chunks that copies share until one of them writes. copying the array only copies a
+// pointer per chunk, and the first Edit of a chunk that another copy still holds clones just that chunk, so a snapshot of
+// the whole world costs next to nothing and then only what actually gets changed. two copies that still share a chunk
+// are known to hold the same data there without comparing it, which is what makes diffing snapshots fast.
+// Edit is meant for one thread, but other threads can keep copies (and read the chunks they hold) for as long as they
+// like, a chunk is never written once it's shared
+template<typename T, size_t ChunkSize = 256>
+class ChunkedArray {
+public:
+	static const size_t chunkSize = ChunkSize;
+
+	size_t Size() const { return count; }
+	size_t ChunkCount() const { return chunks.size(); }
+
+	void Assign(const T* data, size_t newCount) {
+		chunks.clear();
+		count = 0;
+		Resize(newCount);
+		for (size_t chunk = 0; chunk < chunks.size(); chunk++) {
+			size_t length = ChunkLength(chunk);
+			std::copy(data + chunk * ChunkSize, data + chunk * ChunkSize + length, chunks[chunk]->items);
+		}
+	}
+	void Assign(const std::vector<T>& data) { Assign(data.data(), data.size()); }
+
+	void Resize(size_t newCount) {
+		chunks.resize((newCount + ChunkSize - 1) / ChunkSize);
+		for (std::shared_ptr<Chunk>& chunk : chunks) {
+			if (!chunk) {
+				chunk = std::make_shared<Chunk>();
+			}
+		}
+		count = newCount;
+	}
+
+	const T& operator[](size_t index) const { return chunks[index / ChunkSize]->items[index % ChunkSize]; }
+	T& Edit(size_t index) { return EditChunk(index / ChunkSize)[index % ChunkSize]; }
+
+	// Chunks //
+	const T* ChunkData(size_t chunk) const { return chunks[chunk]->items; }
+	size_t ChunkLength(size_t chunk) const { return chunk + 1 < chunks.size() ? ChunkSize : count - chunk * ChunkSize; }
+	T* EditChunk(size_t chunk) {
+		std::shared_ptr<Chunk>& storage = chunks[chunk];
+		if (storage.use_count() > 1) {
+			storage = std::make_shared<Chunk>(*storage); // the other copies keep the old contents
+		}
+		else {
+			// use_count is a relaxed load. another thread that read this chunk and then dropped its copy released it,
+			// this pairs with that release so its reads are finished before we write over them
+			std::atomic_thread_fence(std::memory_order_acquire);
+		}
+		return storage->items;
+	}
+	// true when both arrays still point at the same storage for this chunk, so nothing in it can differ
+	bool SharesChunk(const ChunkedArray& other, size_t chunk) const {
+		return chunk < chunks.size() && chunk < other.chunks.size() && chunks[chunk] == other.chunks[chunk];
+	}
+	// Chunks //
+
+private:
+	struct Chunk {
+		T items[ChunkSize];
+	};
+
+	std::vector<std::shared_ptr<Chunk>> chunks;
+	size_t count = 0;
+};
+// Chunked Array //
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef DEBUGDRAW_H
+#define DEBUGDRAW_H
+#include <glm/glm.hpp> // openGL Mathematics
+#include <bounds.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Debug Geometry //
+struct DebugVertex {
+	glm::vec3 position; // world space
+	uint32_t color; // packed like UIColor
+};
+
+// what a line is of, each can be switched off on its own (drawing into a switched off category costs next to nothing)
+enum DebugCategory {
+	DEBUG_GENERAL, // anything temporary
+	DEBUG_BOUNDS, // object bounding boxes
+	DEBUG_TRANSFORMS, // object axes
+	DEBUG_CULLING, // camera frusta
+	DEBUG_PICKING, // pick rays and hits
+	DEBUG_CATEGORY_COUNT
+};
+const char* DebugCategoryName(DebugCategory category);
+
+enum DebugLayer {
+	DEBUG_DEPTH_TESTED, // hidden behind the level like anything else
+	DEBUG_OVERLAY, // always on top
+	DEBUG_LAYER_COUNT
+};
+
+// a frame's worth of lines, two vertices each, kept in the buffers the threads drew them into (swapped in, not copied)
+struct DebugDrawList {
+	std::vector<std::vector<DebugVertex>> batches[DEBUG_LAYER_COUNT];
+	size_t batchCount[DEBUG_LAYER_COUNT] = {}; // batches past this are empty ones kept for their memory
+
+	void Take(DebugLayer layer, std::vector<DebugVertex>& vertices); // swaps vertices in, leaving an empty buffer behind
+	size_t Vertices(DebugLayer layer) const;
+	void Clear();
+};
+// Debug Geometry //
+
+// Debug Draw //
+// lines and wire shapes for seeing what the code sees, drawable from any thread. each thread writes into a buffer of its
+// own, so threads never wait on each other, and whoever owns the DebugDraw collects every thread's buffer into a
+// DebugDrawList once a frame (after the jobs it started have finished). the lines are drawn a frame at a time, they have
+// to be drawn again every frame to stay up.
+// one call locks the thread's buffer once, so a shape costs the same as a line. loops that draw a lot (every object's
+// bounds, say) should open a Batch and keep it for the whole loop or job chunk, which brings a line down to two stores
+class DebugDraw {
+public:
+	DebugDraw();
+	~DebugDraw();
+
+	static void SetEnabled(DebugCategory category, bool enabled); // for every DebugDraw
+	static bool Enabled(DebugCategory category) { return ((enabledCategories.load(std::memory_order_relaxed) >> category) & 1u) != 0; }
+
+	// Batch //
+	// holds the calling thread's buffer for its lifetime, everything drawn through it goes in one category and layer
+	class Batch {
+	public:
+		Batch(DebugDraw& draw, DebugCategory category, DebugLayer layer = DEBUG_DEPTH_TESTED);
+		bool Active() const { return vertices != nullptr; } // false when the category is switched off
+
+		void Line(const glm::vec3& start, const glm::vec3& end, uint32_t color) {
+			if (vertices) {
+				vertices->push_back({ start, color });
+				vertices->push_back({ end, color });
+			}
+		}
+		void Box(const AABB& box, uint32_t color);
+		void Box(const glm::mat4& matrix, const AABB& box, uint32_t color); // box in the space matrix moves into the world
+		void Axes(const glm::mat4& matrix, float size); // x red, y green, z blue
+		void Sphere(const glm::vec3& center, float radius, uint32_t color); // a circle around each axis
+		void Frustum(const glm::mat4& viewProjection, uint32_t color); // the volume that camera sees
+
+	private:
+		DebugVertex* Extend(size_t count); // room for count more vertices, one size check for a whole shape
+
+		std::unique_lock<std::mutex> lock;
+		std::vector<DebugVertex>* vertices;
+	};
+	// Batch //
+
+	// Shapes //
+	// each is a Batch of one
+	void Line(const glm::vec3& start, const glm::vec3& end, uint32_t color, DebugCategory category = DEBUG_GENERAL, DebugLayer layer = DEBUG_DEPTH_TESTED);
+	void Box(const AABB& box, uint32_t color, DebugCategory category = DEBUG_GENERAL, DebugLayer layer = DEBUG_DEPTH_TESTED);
+	void Axes(const glm::mat4& matrix, float size, DebugCategory category = DEBUG_TRANSFORMS, DebugLayer layer = DEBUG_OVERLAY);
+	void Sphere(const glm::vec3& center, float radius, uint32_t color, DebugCategory category = DEBUG_GENERAL, DebugLayer layer = DEBUG_DEPTH_TESTED);
+	void Frustum(const glm::mat4& viewProjection, uint32_t color, DebugCategory category = DEBUG_CULLING, DebugLayer layer = DEBUG_DEPTH_TESTED);
+	// Shapes //
+
+	void Collect(DebugDrawList& list); // takes everything drawn so far, from every thread
+
+private:
+	struct ThreadBuffer {
+		std::mutex mutex; // only ever contended by Collect
+		std::vector<DebugVertex> vertices[DEBUG_LAYER_COUNT];
+	};
+	ThreadBuffer& Local(); // the calling thread's buffer, made the first time it draws
+
+	static std::atomic<uint32_t> enabledCategories; // bit per category
+	static std::atomic<unsigned int> nextID;
+
+	unsigned int id; // how threads find their buffer, never reused so a thread can't mistake a new DebugDraw for a dead one
+	std::mutex buffersMutex;
+	std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+};
+// Debug Draw //
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef DEBUGRENDERER_H
+#define DEBUGRENDERER_H
+#include <glad\gl.h>
+#include <glm/glm.hpp> // openGL Mathematics
+#include <debugdraw.h>
+#include <gpuresource.h>
+#include <shader.h>
+#include <streambuffer.h>
+#include <memory>
+
+// Debug Renderer //
+// draws a DebugDrawList: every thread's lines are copied into one stream buffer allocation, depth tested ones first,
+// and each layer is a single GL_LINES draw out of it (two draws per view, the overlay just has the depth test off).
+// the stream buffer is big enough for a million lines a frame, so it's only made the first time there's something to draw
+class DebugRenderer {
+public:
+	DebugRenderer(); // the GL context has to be current
+	void Upload(const DebugDrawList& list); // once a frame, before any Draw
+	void Draw(const glm::mat4& viewProjection); // this frame's lines into the current viewport
+	void EndFrame(); // after the last Draw of the frame
+	void Unload();
+
+private:
+	static const size_t maxLines = 1024 * 1024; // per frame, anything past this is left out
+	static const size_t bufferBytes = maxLines * 2 * sizeof(DebugVertex) * 2; // room for two frames
+
+	Shader shader;
+	GLVertexArray vertexArray;
+	std::unique_ptr<StreamBuffer> stream;
+	unsigned int layoutBuffer; // the buffer the vertex array points at
+	int viewProjectionLoc;
+	GLint first[DEBUG_LAYER_COUNT]; // vertices of this frame's allocation
+	GLsizei count[DEBUG_LAYER_COUNT];
+};
+// Debug Renderer //
+
+#endif
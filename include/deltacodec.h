@@ -0,0 +1,21 @@
+#ifndef DELTACODEC_H
+#define DELTACODEC_H
+#include <cstddef>
+#include <vector>
+
+// Delta Codec //
+// compact binary diffs between two versions of the same block of memory. the versions are XORed, so every byte that
+// didn't change becomes zero, and the result is stored as alternating runs: a varint count of zero bytes to skip, then
+// a varint count of literal bytes and the bytes themselves. a few edited fields in a chunk of components come out as
+// a handful of bytes. XOR is its own inverse, so applying a delta to the new version gives back the old one and applying
+// it again gives the new one, the same diff serves for undo and redo
+namespace DeltaCodec {
+	// appends the diff between before and after (bytes long each) to out, before can be nullptr for all zeros
+	// returns how many bytes were appended, 0 when the two are identical
+	size_t Encode(const unsigned char* before, const unsigned char* after, size_t bytes, std::vector<unsigned char>& out);
+	// XORs an encoded diff into data (bytes long), false if the diff is corrupt or doesn't fit (data may be half applied)
+	bool Apply(unsigned char* data, size_t bytes, const unsigned char* encoded, size_t encodedBytes);
+}
+// Delta Codec //
+
+#endif
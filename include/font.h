@@ -0,0 +1,85 @@
+#ifndef FONT_H
+#define FONT_H
+#include <glm/glm.hpp> // openGL Mathematics
+#include <ui.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct stbtt_fontinfo;
+
+// Font //
+// a TrueType font drawn from signed distance field glyphs, so one bake looks sharp at any size. glyphs are baked (with
+// stb_truetype) the first time they're needed into pages carved out of the UI atlas, which means text goes out in the
+// same single draw as the rest of the UI. when every page is full the one used least recently is cleared for reuse, and
+// anything shaped with its glyphs gets shaped again.
+// shaping a string (decoding it, looking its glyphs up, kerning, line breaks) is done once and kept as a run of quads,
+// drawing a run that's already been shaped only moves its quads into place, which is what keeps screens full of
+// changing debug text cheap. everything here runs on the simulation thread, the atlas carries the pixels over
+class Font {
+public:
+	static const int bakeSize = 32; // pixel height the glyphs are baked at
+	static const int pageSize = 250; // four pages side by side fit across the atlas
+	static const int maxPages = 8;
+
+	// Text Run //
+	struct Run {
+		std::vector<UIVertex> vertices; // at the origin (top left of the text), in the size it was shaped for
+		glm::vec2 extent; // width of the longest line and total height
+		uint32_t pages; // bit per page the glyphs are on, to keep them from being evicted while in use
+		unsigned int epoch; // the font's epoch when it was shaped, older runs may point at evicted glyphs
+		unsigned long long lastFrame;
+	};
+	// Text Run //
+
+	explicit Font(UIAtlas& atlas);
+	~Font();
+	bool Load(const std::string& path); // false (and no text) if the file can't be read or isn't a font
+	bool Loaded() const { return font != nullptr; }
+
+	void BeginFrame(); // ages the glyph pages and forgets runs that haven't been drawn in a while
+	// the run for text at size pixels, shaped now if it isn't cached. valid until the next Shape or BeginFrame
+	const Run& Shape(const std::string& text, float size);
+	// appends the run's quads at position (top left) in color, marking its pages as used this frame
+	void Draw(const Run& run, const glm::vec2& position, uint32_t color, std::vector<UIVertex>& out);
+	float LineHeight(float size) const { return lineHeight * size / bakeSize; }
+
+private:
+	struct Glyph {
+		int page; // -1 for glyphs with nothing to draw (spaces)
+		glm::vec2 uv0;
+		glm::vec2 uv1;
+		glm::vec2 offset; // from the pen position on the baseline to the top left of the bitmap, at bakeSize
+		glm::vec2 extent; // of the bitmap, at bakeSize
+		float advance; // at bakeSize
+	};
+	struct Page {
+		UIAtlas::Region region;
+		glm::ivec2 cursor; // where the next glyph goes
+		int rowHeight; // of the current row
+		unsigned long long lastFrame; // last frame a run drawn from this page was drawn
+	};
+
+	const Glyph* GetGlyph(int codepoint); // bakes it if it isn't already, nullptr if there's no room left
+	bool Place(int width, int height, int& page, glm::ivec2& position);
+	void Evict(int page);
+
+	UIAtlas& atlas;
+	std::vector<unsigned char> fontData;
+	std::unique_ptr<stbtt_fontinfo> font;
+	float scale = 0.0f; // font units to bakeSize pixels
+	float ascent = 0.0f; // at bakeSize
+	float lineHeight = 0.0f;
+
+	std::vector<Page> pages;
+	std::unordered_map<int, Glyph> glyphs;
+	std::unordered_map<uint64_t, Run> runs; // by hash of the text and size
+	unsigned int epoch = 1; // goes up every time a page is evicted, runs start at 0 so they're always shaped once
+	unsigned long long frame = 0;
+	bool warnedFull = false;
+};
+// Font //
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef FRAMEPACER_H
+#define FRAMEPACER_H
+#include <GLFW\glfw3.h>
+#include <chrono>
+#include <vector>
+
+enum VSyncMode {
+	VSYNC_OFF, // swap as soon as a frame is done, tears but has the least latency
+	VSYNC_ON, // always wait for the display, a missed refresh costs a whole extra one
+	VSYNC_ADAPTIVE // wait for the display unless the frame is already late, then swap right away (falls back to on without tear control)
+};
+
+// Frame Pacer //
+// decides when a frame starts. with a frame rate cap each frame gets a slot of 1 / cap seconds and the pacer waits for the
+// start of the next one, sleeping while there's plenty of time and spinning for the last bit since the OS sleep is only
+// good to a millisecond or so (how much it oversleeps is measured as it goes). the wait happens before input is read, so
+// with late input sampling the frame is simulated from input that's as fresh as it can be instead of input that sat
+// through the wait. vsync itself is applied by whoever swaps buffers, this only says which swap interval to use.
+// jitter (how far frame intervals stray from their average) is printed every reportInterval seconds
+class FramePacer {
+public:
+	// needs the window's context current, glfwExtensionSupported asks the context
+	void Detect();
+
+	void SetVSync(VSyncMode mode) { vsync = mode; }
+	VSyncMode VSync() const { return vsync; }
+	int SwapInterval() const; // for glfwSwapInterval, -1 is adaptive
+	void SetFrameCap(double framesPerSecond); // 0 for no cap
+	double FrameCap() const { return frameCap; }
+	void SetLateInput(bool late) { lateInput = late; }
+	bool LateInput() const { return lateInput; }
+
+	// waits for the next frame slot (if capped) and records how long the last frame took, call once at the top of the loop
+	void BeginFrame();
+
+	double reportInterval = 5.0; // seconds between jitter summaries, 0 turns them off
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	void WaitUntil(Clock::time_point deadline);
+	void Report();
+
+	VSyncMode vsync = VSYNC_ON;
+	bool tearControl = false; // EXT_swap_control_tear, swap interval -1
+	int refreshRate = 0; // of the primary monitor, 0 if unknown
+	double frameCap = 0.0;
+	bool lateInput = true;
+
+	Clock::time_point nextFrame; // start of the next frame slot
+	Clock::time_point lastFrame;
+	bool started = false;
+
+	// Sleep Estimate //
+	// running mean and variance (Welford) of how long a 1 ms sleep really takes, sleeping stops once less than
+	// mean + one deviation is left
+	double sleepMean = 0.002;
+	double sleepM2 = 0.0;
+	long long sleepCount = 1;
+	// Sleep Estimate //
+
+	// Stats //
+	std::vector<double> intervals; // milliseconds, since the last report
+	double waited = 0.0; // milliseconds spent waiting since the last report
+	Clock::time_point lastReport;
+	// Stats //
+};
+// Frame Pacer //
+
+#endif
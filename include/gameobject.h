@@ -1,22 +1,67 @@
-#ifndef GAMEOBJECT_H 
+#ifndef GAMEOBJECT_H
 #define GAMEOBJECT_H
+#include <glm/glm.hpp> // openGL Mathematics
+#include <glm/gtc/matrix_transform.hpp>
 
-class GameObject {
-	// Transform Component //
+// a game object is just an index into the scene's component arrays, each component type lives in its own
+// tightly packed array (see scene.h) so systems only touch the data they actually use
+typedef unsigned int GameObject;
 
-	// Transform Component //
+// Transform Component //
+struct TransformComponent {
+	glm::vec3 position;
+	glm::vec3 rotation; // euler angles in degrees, applied y then x then z
+	glm::vec3 scale;
 
+	TransformComponent() : position(0.0f), rotation(0.0f), scale(1.0f) {}
+	TransformComponent(const glm::vec3& pos) : position(pos), rotation(0.0f), scale(1.0f) {}
 
+	glm::mat4 Matrix() const {
+		glm::mat4 matrix = glm::translate(glm::mat4(1.0f), position);
+		matrix = glm::rotate(matrix, glm::radians(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
+		matrix = glm::rotate(matrix, glm::radians(rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
+		matrix = glm::rotate(matrix, glm::radians(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
+		return glm::scale(matrix, scale);
+	}
 
-	// Render Component //
-	
-	// Render Component //
+	bool operator==(const TransformComponent& other) const {
+		return position == other.position && rotation == other.rotation && scale == other.scale;
+	}
+	bool operator!=(const TransformComponent& other) const { return !(*this == other); }
+
+	// blends between two transforms, each angle takes the short way round so 350 -> 10 doesn't spin backwards
+	static TransformComponent Interpolate(const TransformComponent& from, const TransformComponent& to, float t) {
+		TransformComponent result;
+		result.position = glm::mix(from.position, to.position, t);
+		result.scale = glm::mix(from.scale, to.scale, t);
+		for (int axis = 0; axis < 3; axis++) {
+			float difference = glm::mod(to.rotation[axis] - from.rotation[axis] + 180.0f, 360.0f) - 180.0f;
+			result.rotation[axis] = from.rotation[axis] + difference * t;
+		}
+		return result;
+	}
+};
+// Transform Component //
 
 
 
-	// Physics Component //
+// Render Component //
+enum RenderFlags {
+	RENDER_VISIBLE = 1,
+	RENDER_OCCLUDER = 2, // big solid things (walls, floors) that are worth drawing into occlusion buffers
+	RENDER_TRANSLUCENT = 4, // blended, so drawn back to front after the opaque objects
+};
 
-	// Physics Component //
+struct RenderComponent {
+	unsigned int model; // index into the scene's model list
+	unsigned int flags; // RenderFlags
 };
+// Render Component //
+
+
+
+// Physics Component //
+
+// Physics Component //
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,37 @@
+#ifndef GLCAPS_H
+#define GLCAPS_H
+#include <glad\gl.h>
+#include <iostream>
+
+// GL Capabilities //
+// glad only loads up to GL 3.3, anything newer is used through the matching ARB extension,
+// so this records which of those the driver actually gave us (call Detect once right after gladLoadGL)
+struct GLCaps {
+	int major = 3;
+	int minor = 3;
+	bool multiDrawIndirect = false; // glMultiDrawElementsIndirect with baseInstance (GL 4.3)
+	bool shaderStorage = false; // shader storage buffers (GL 4.3)
+	bool computeShaders = false; // GL 4.3
+	bool indirectCount = false; // draw count read from a GPU buffer (ARB_indirect_parameters, core in 4.6)
+	bool bufferStorage = false; // immutable storage and persistent mapping (GL 4.4)
+
+	static GLCaps& Get() {
+		static GLCaps caps;
+		return caps;
+	}
+
+	void Detect() {
+		glGetIntegerv(GL_MAJOR_VERSION, &major);
+		glGetIntegerv(GL_MINOR_VERSION, &minor);
+		multiDrawIndirect = GLAD_GL_ARB_multi_draw_indirect && GLAD_GL_ARB_base_instance;
+		shaderStorage = GLAD_GL_ARB_shader_storage_buffer_object != 0;
+		computeShaders = GLAD_GL_ARB_compute_shader != 0;
+		indirectCount = GLAD_GL_ARB_indirect_parameters != 0;
+		bufferStorage = GLAD_GL_ARB_buffer_storage != 0;
+		std::cout << "OpenGL " << major << "." << minor << " (multi-draw indirect: " << multiDrawIndirect << ", storage buffers: " << shaderStorage
+			<< ", compute: " << computeShaders << ", indirect count: " << indirectCount << ", buffer storage: " << bufferStorage << ")\n";
+	}
+};
+// GL Capabilities //
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef GLSTATS_H
+#define GLSTATS_H
+#include <string>
+
+// GL Stats //
+// counts every GL call the engine makes and the time it spends in the driver, per function, in builds made with the
+// GL_INSTRUMENTATION cmake option. Install swaps glad's function pointers for wrappers that count and time the call
+// before handing it on, so nothing that calls GL has to change. in a normal build Install does nothing and it all reads zero.
+// the numbers are only touched by whichever thread has the context current, the same as GL itself
+class GLStats {
+public:
+	static GLStats& Get();
+	static bool Available(); // true when built with GL_INSTRUMENTATION
+
+	void Install(); // straight after gladLoadGL, wraps the functions in the list at the top of glstats.cpp
+	void EndFrame(); // after the frame's last GL call, puts the frame's calls and driver time into the profiler as gl.*
+	bool WriteJSON(const std::string& path) const; // totals and per frame averages since Install, slowest function first
+
+	bool checkErrors; // glGetError after every wrapped call, printing the function that raised it. a driver round trip per call
+
+private:
+	GLStats();
+
+	bool installed;
+	long long frames;
+};
+// GL Stats //
+
+#endif
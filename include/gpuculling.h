@@ -0,0 +1,67 @@
+#ifndef GPUCULLING_H
+#define GPUCULLING_H
+#include <glad\gl.h>
+#include <glm/glm.hpp> // openGL Mathematics
+#include <gameobject.h>
+#include <gpuresource.h>
+#include <shader.h>
+#include <vector>
+
+class Scene;
+class IndirectRenderer;
+class HiZOcclusion;
+
+// GPU Culling //
+// culls and draws the whole scene without the CPU looking at a single object: every mesh of every object is an instance
+// whose bounds live on the GPU, a compute shader tests them against the frustum and last frame's hi-z pyramid and writes
+// the survivors straight into the indirect draw buffer, which IndirectRenderer then draws. nothing is ever read back.
+//
+// with ARB_indirect_parameters the survivors are packed to the front and the draw count comes from the GPU too,
+// without it every instance keeps its own command and hidden ones just ask for zero instances
+class GPUCulling {
+public:
+	GPUCulling(IndirectRenderer& renderer, HiZOcclusion* pyramid = nullptr); // without a pyramid only the frustum is tested
+	static bool Supported(); // compute shaders on top of what IndirectRenderer needs
+
+	void Draw(const Scene& scene, const glm::mat4& viewProjection);
+	void Unload();
+
+private:
+	// matches Instance in cull.comp (std430)
+	struct Instance {
+		glm::vec4 boundsMin;
+		glm::vec4 boundsMax;
+		unsigned int indexCount;
+		unsigned int firstIndex;
+		int baseVertex;
+		unsigned int flags;
+	};
+
+	void UploadInstances(const Scene& scene); // everything, only when objects have been created or removed
+	void UploadMoved(const Scene& scene); // just the instances of objects moved since the last upload
+	void WriteInstances(const Scene& scene, GameObject object, unsigned int first); // object's meshes into instances and transforms
+
+	IndirectRenderer& renderer;
+	HiZOcclusion* pyramid;
+	Shader cullShader;
+	GLBuffer instanceBuffer;
+	GLBuffer transformBuffer;
+	GLBuffer commandBuffer;
+	GLBuffer countBuffer;
+
+	unsigned int numInstances;
+	unsigned int uploadedLayout; // Scene::LayoutVersion() of the last full upload
+	size_t movedRead; // how far into Scene::MovedObjects() has been uploaded
+	bool uploaded;
+	bool compact;
+	bool pyramidValid; // the pyramid has been drawn at least once
+
+	std::vector<Instance> instances;
+	std::vector<glm::mat4> transforms;
+	std::vector<unsigned int> objectInstances; // each object's first instance, noInstance for hidden ones
+	std::vector<unsigned int> dirtyInstances; // reused by UploadMoved
+	static const unsigned int noInstance = 0xFFFFFFFF;
+};
+// GPU Culling //
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef GPURESOURCE_H
+#define GPURESOURCE_H
+#include <glad\gl.h>
+#include <cstddef>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+enum class GPUResourceType { Buffer, Texture, Program, VertexArray, Framebuffer, Count };
+
+// GPU Resource Registry //
+// every GL object created through a GLHandle is recorded here along with the name of whoever owns it (a model file, a shader, ...)
+// so we can see how much GPU memory each owner holds and spot anything that was never freed when a level is unloaded
+class GPUResourceRegistry {
+public:
+	static GPUResourceRegistry& Get(); // there is only one GL context so there is only one registry
+
+	void Track(GPUResourceType type, unsigned int id, const std::string& owner);
+	void Untrack(GPUResourceType type, unsigned int id);
+	void SetBytes(GPUResourceType type, unsigned int id, size_t bytes); // called whenever storage is (re)allocated
+
+	size_t OwnerBytes(const std::string& owner) const;
+	size_t TotalBytes(GPUResourceType type) const;
+	size_t TotalBytes() const;
+	unsigned int LiveCount(GPUResourceType type) const;
+	unsigned int LiveCount() const;
+	void Report() const; // prints a per-owner breakdown to the console
+
+private:
+	GPUResourceRegistry();
+
+	struct Entry {
+		std::string owner;
+		size_t bytes;
+	};
+	struct OwnerTotals {
+		size_t bytes[(int)GPUResourceType::Count];
+		unsigned int count[(int)GPUResourceType::Count];
+	};
+
+	static unsigned long long Key(GPUResourceType type, unsigned int id) { return ((unsigned long long)type << 32) | id; }
+
+	std::unordered_map<unsigned long long, Entry> entries;
+	std::unordered_map<std::string, OwnerTotals> owners;
+	size_t totalBytes[(int)GPUResourceType::Count];
+	unsigned int liveCount[(int)GPUResourceType::Count];
+	mutable std::mutex mutex;
+};
+// GPU Resource Registry //
+
+// these do the actual glGen*/glDelete* calls for each resource type
+namespace GLObjects {
+	unsigned int Generate(GPUResourceType type);
+	void Delete(GPUResourceType type, unsigned int id);
+}
+
+// GL Handle //
+// owns a single GL object and deletes it when it goes out of scope, it can be moved but never copied
+// so there is always exactly one owner responsible for freeing the object
+template <GPUResourceType Type>
+class GLHandle {
+public:
+	GLHandle() : id(0) {}
+	~GLHandle() { Reset(); }
+
+	GLHandle(const GLHandle&) = delete;
+	GLHandle& operator=(const GLHandle&) = delete;
+
+	GLHandle(GLHandle&& other) noexcept : id(other.id) { other.id = 0; }
+	GLHandle& operator=(GLHandle&& other) noexcept {
+		if (this != &other) {
+			Reset();
+			id = other.id;
+			other.id = 0;
+		}
+		return *this;
+	}
+
+	static GLHandle Create(const std::string& owner) { // generates a new GL object
+		return Adopt(GLObjects::Generate(Type), owner);
+	}
+	static GLHandle Adopt(unsigned int existing, const std::string& owner) { // takes ownership of an object made elsewhere (e.g. glCreateProgram)
+		GLHandle handle;
+		handle.id = existing;
+		if (existing != 0) {
+			GPUResourceRegistry::Get().Track(Type, existing, owner);
+		}
+		return handle;
+	}
+
+	void Reset() { // deletes the object now rather than waiting for the destructor
+		if (id != 0) {
+			GPUResourceRegistry::Get().Untrack(Type, id);
+			GLObjects::Delete(Type, id);
+			id = 0;
+		}
+	}
+
+	unsigned int ID() const { return id; }
+	explicit operator bool() const { return id != 0; }
+
+private:
+	unsigned int id;
+};
+
+typedef GLHandle<GPUResourceType::Buffer> GLBuffer;
+typedef GLHandle<GPUResourceType::Texture> GLTexture;
+typedef GLHandle<GPUResourceType::Program> GLProgram;
+typedef GLHandle<GPUResourceType::VertexArray> GLVertexArray;
+typedef GLHandle<GPUResourceType::Framebuffer> GLFramebuffer;
+// GL Handle //
+
+// glBufferData that also tells the registry how big the buffer now is, the buffer must already be bound to target
+void BufferData(GLenum target, const GLBuffer& buffer, size_t bytes, const void* data, GLenum usage);
+
+#endif
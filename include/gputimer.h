@@ -0,0 +1,29 @@
+#ifndef GPUTIMER_H
+#define GPUTIMER_H
+#include <glad\gl.h>
+
+// GPU Timer //
+// how long the GPU takes to get through the commands between Begin and End, measured with GL_TIME_ELAPSED queries.
+// a query's answer only exists once the GPU has caught up, so a few are kept in flight and each one is read when it's
+// ready instead of waiting for it: the times reach the profiler a couple of frames late but the CPU never stalls.
+// each Begin reports at most one time, the newest that's ready. queries can't nest, only one timer can be running at a
+// time. render thread only
+class GPUTimer {
+public:
+	explicit GPUTimer(const char* name); // the profiler time the results go into, the GL context has to be current
+	void Begin();
+	void End();
+	void Unload();
+
+private:
+	static const unsigned int numQueries = 4; // frames that can be in flight before one gets skipped
+
+	const char* name;
+	GLuint queries[numQueries];
+	bool pending[numQueries]; // started and not read back yet
+	unsigned int nextQuery;
+	bool running; // false when every query was still in flight at Begin, that frame isn't timed
+};
+// GPU Timer //
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef INDIRECTRENDERER_H
+#define INDIRECTRENDERER_H
+#include <glad\gl.h>
+#include <glm/glm.hpp> // openGL Mathematics
+#include <gameobject.h>
+#include <bounds.h>
+#include <gpuresource.h>
+#include <shader.h>
+#include <vector>
+
+class Scene;
+
+// laid out exactly as glMultiDrawElementsIndirect reads it
+struct DrawElementsIndirectCommand {
+	unsigned int count; // number of indices
+	unsigned int instanceCount;
+	unsigned int firstIndex;
+	int baseVertex;
+	unsigned int baseInstance; // we use it as the draw's index into the transform buffer
+};
+
+// Indirect Renderer //
+// draws every visible mesh in the scene with one glMultiDrawElementsIndirect call (GL 4.3) instead of a
+// bind/uniform/draw per mesh. all meshes are packed into one shared vertex and index buffer so a single VAO
+// covers everything, and each draw's model matrix is read from a storage buffer using its draw index
+class IndirectRenderer {
+public:
+	struct PooledMesh {
+		unsigned int firstIndex;
+		int baseVertex;
+		unsigned int indexCount;
+	};
+
+	IndirectRenderer();
+	static bool Supported(); // false on plain GL 3.3, the scene goes through its RenderQueue there
+
+	// builds the commands on the CPU from an already culled list of objects
+	void Draw(const Scene& scene, const std::vector<GameObject>& visible, const glm::mat4& viewProjection);
+	void Unload();
+
+	// Lower Level //
+	// for passes that fill the command buffer themselves (see GPUCulling)
+	void Update(const Scene& scene); // packs any models loaded since the last call into the shared buffers
+	const PooledMesh& Mesh(unsigned int model, unsigned int mesh) const { return pooledMeshes[model][mesh]; }
+	// draws the commands in whatever is bound to GL_DRAW_INDIRECT_BUFFER, with the transforms bound to storage buffer 0
+	// and the camera taken from the FrameData block. if countBuffer is given the real number of draws is read from its
+	// first uint on the GPU (ARB_indirect_parameters)
+	void Submit(unsigned int maxDraws, unsigned int countBuffer = 0);
+	// Lower Level //
+
+private:
+	void Build(const Scene& scene); // packs every model's meshes into the shared buffers
+	void ReserveDrawIDs(unsigned int count);
+
+	Shader shader;
+	GLVertexArray VAO;
+	GLBuffer vertexBuffer;
+	GLBuffer indexBuffer;
+	GLBuffer drawIDBuffer; // 0, 1, 2, ... read once per instance
+	GLBuffer commandBuffer;
+	GLBuffer transformBuffer;
+
+	std::vector<std::vector<PooledMesh>> pooledMeshes; // [model][mesh]
+	unsigned int pooledModels; // how many of the scene's models have been packed so far
+	unsigned int drawIDCapacity;
+
+	std::vector<DrawElementsIndirectCommand> commands; // rebuilt every frame
+	std::vector<glm::mat4> drawTransforms;
+	std::vector<unsigned char> meshVisible;
+};
+// Indirect Renderer //
+
+#endif
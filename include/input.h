@@ -0,0 +1,112 @@
+#ifndef INPUT_H
+#define INPUT_H
+#include <GLFW\glfw3.h>
+#include <glm/glm.hpp> // openGL Mathematics
+#include <spscring.h>
+#include <atomic>
+#include <vector>
+
+// Input Actions //
+// what the game responds to, keys and buttons are bound to these instead of being checked directly
+enum InputAction {
+	ACTION_MOVE_FORWARD,
+	ACTION_MOVE_BACK,
+	ACTION_MOVE_LEFT,
+	ACTION_MOVE_RIGHT,
+	ACTION_SAVE_LEVEL,
+	ACTION_LOAD_LEVEL,
+	ACTION_TOGGLE_PLAY, // design mode <-> play mode
+	ACTION_UNDO, // design mode edits
+	ACTION_REDO,
+	ACTION_SELECT, // pick the object under the cursor, drag to move it
+	ACTION_LOOK, // held to turn the camera in design mode, where the cursor is otherwise free
+	ACTION_TOGGLE_HUD, // the performance overlay
+	ACTION_COUNT
+};
+// Input Actions //
+
+// Input Events //
+enum InputEventType {
+	INPUT_KEY,
+	INPUT_MOUSE_BUTTON,
+	INPUT_CURSOR,
+	INPUT_SCROLL
+};
+
+struct InputEvent {
+	InputEventType type;
+	int code; // key or mouse button
+	int action; // GLFW_PRESS, GLFW_RELEASE or GLFW_REPEAT
+	int mods;
+	double x; // cursor position or scroll offset
+	double y;
+	double time; // glfwGetTime when GLFW reported it
+};
+// Input Events //
+
+// Input //
+// GLFW callbacks only record events, stamped with the time they arrived, into a lock-free ring. the simulation drains
+// the ring one fixed step at a time with Update, taking only the events that happened before the step's end time, so a
+// key tapped between two steps of the same frame lands in the right one and a press and release inside one step still
+// counts as a press. cursor motion is summed over everything the step consumed, none of it is lost between steps or
+// frames. nothing here touches the render thread
+class Input {
+public:
+	enum Device {
+		DEVICE_KEYBOARD,
+		DEVICE_MOUSE
+	};
+
+	static Input& Get();
+
+	void Attach(GLFWwindow* window); // installs the callbacks, call once on the main thread
+	void Bind(InputAction action, Device device, int code); // an action can have any number of bindings
+	void Unbind(InputAction action);
+
+	// consumer side: applies every event up to time (glfwGetTime seconds) and clears the per step state before that
+	void Update(double time);
+
+	// Per Step State //
+	bool Held(InputAction action) const;
+	bool Pressed(InputAction action) const { return pressed[action]; } // went down during the last Update
+	bool Released(InputAction action) const { return released[action]; }
+	glm::vec2 MouseDelta() const { return mouseDelta; } // pixels, y up
+	glm::vec2 Scroll() const { return scroll; }
+	glm::vec2 CursorPosition() const { return cursor; } // pixels from the top left of the window
+	// Per Step State //
+
+	long long Dropped() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+	Input();
+
+	struct Binding {
+		InputAction action;
+		Device device;
+		int code;
+	};
+
+	static void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+	static void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
+	static void CursorCallback(GLFWwindow* window, double x, double y);
+	static void ScrollCallback(GLFWwindow* window, double x, double y);
+	void Push(const InputEvent& event);
+	void Apply(const InputEvent& event);
+
+	SPSCRing<InputEvent, 1024> events;
+	static const size_t reservedForKeys = 256; // slots only key and button events can use, a stall's mouse motion can't take them
+	std::atomic<long long> dropped; // events lost to a full ring
+
+	std::vector<Binding> bindings;
+	bool keys[GLFW_KEY_LAST + 1];
+	bool buttons[GLFW_MOUSE_BUTTON_LAST + 1];
+	bool pressed[ACTION_COUNT];
+	bool released[ACTION_COUNT];
+	glm::vec2 mouseDelta;
+	glm::vec2 scroll;
+	glm::vec2 cursor;
+	bool firstCursor; // prevents jump when capturing cursor
+};
+// Input //
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Job System //
+// a fixed set of worker threads (one less than the number of cores) that split loops between them,
+// the thread calling ParallelFor works on the loop too so nothing sits idle waiting
+class JobSystem {
+public:
+	// begin/end is the range of indices to process, thread is 0 for the caller and 1..NumThreads()-1 for workers
+	// (handy for giving each thread its own output buffer)
+	typedef std::function<void(unsigned int begin, unsigned int end, unsigned int thread)> Job;
+
+	static JobSystem& Get();
+	~JobSystem();
+
+	unsigned int NumThreads() const { return (unsigned int)workers.size() + 1; }
+	// runs job over [0, count) in chunks of chunkSize and returns once every chunk is done, don't call it from inside a job
+	void ParallelFor(unsigned int count, unsigned int chunkSize, const Job& job);
+	double Utilization(); // fraction of worker time spent on jobs since the last call
+	void Shutdown();
+
+private:
+	JobSystem();
+	void WorkerLoop(unsigned int thread);
+	void RunChunks(unsigned int thread); // grabs chunks of the current loop until there are none left
+
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wake; // workers wait here for a new loop
+	std::condition_variable done; // the caller waits here for the last chunk to finish
+
+	// Current Loop //
+	const Job* job;
+	unsigned int count;
+	unsigned int chunkSize;
+	std::atomic<unsigned int> nextChunk;
+	std::atomic<unsigned int> chunksLeft;
+	unsigned int generation; // bumped for every loop so workers know there's new work
+	unsigned int activeWorkers; // workers currently inside RunChunks
+	bool quit;
+	// Current Loop //
+
+	std::atomic<long long> busyMicroseconds;
+	std::chrono::steady_clock::time_point lastUtilization;
+};
+// Job System //
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef LEVEL_H
+#define LEVEL_H
+#include <gameobject.h>
+#include <mappedfile.h>
+#include <cstdint>
+#include <string>
+
+class Scene;
+
+// Level Header //
+// a level file is this header followed by each component array exactly as it sits in memory, then the model table.
+// every section is found through an offset from the start of the file, so reading one is mapping it and adding offsets
+// to the base address (no parsing, no per object work). the component sizes are stored so a file written by a build
+// whose structs are laid out differently is turned away instead of read as garbage
+struct LevelHeader {
+	char magic[4]; // "LVL" and a zero
+	uint32_t version;
+	uint32_t transformSize; // sizeof(TransformComponent) when written
+	uint32_t renderSize; // sizeof(RenderComponent)
+	uint32_t objectCount;
+	uint32_t modelCount;
+	uint64_t transformsOffset; // objectCount TransformComponents
+	uint64_t rendersOffset; // objectCount RenderComponents, model is an index into the model table
+	uint64_t modelsOffset; // modelCount uint32_t offsets of zero terminated file names, from the start of the file
+	uint64_t fileSize;
+};
+// Level Header //
+
+// Level File //
+// a mapped level, everything it hands out points straight into the mapping and stays valid until Close
+class LevelFile {
+public:
+	static const uint32_t version = 1;
+
+	bool Open(const std::string& path); // maps the file, checks it and fixes the section pointers up
+	void Close();
+
+	unsigned int ObjectCount() const { return header ? header->objectCount : 0; }
+	unsigned int ModelCount() const { return header ? header->modelCount : 0; }
+	const TransformComponent* Transforms() const { return transforms; }
+	const RenderComponent* Renders() const { return renders; }
+	const char* ModelName(unsigned int model) const { return (const char*)file.Data() + modelNames[model]; }
+
+	// Scene //
+	static bool Save(const Scene& scene, const std::string& path);
+	static bool Load(Scene& scene, const std::string& path); // replaces every object in the scene, models are kept and reused
+	// one line per model and object, for reading and diffing (loading only goes through the binary file)
+	static bool ExportText(const Scene& scene, const std::string& path);
+	// Scene //
+
+private:
+	MappedFile file;
+	const LevelHeader* header = nullptr;
+	const TransformComponent* transforms = nullptr;
+	const RenderComponent* renders = nullptr;
+	const uint32_t* modelNames = nullptr;
+};
+// Level File //
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Mapped File //
+// a read only view of a whole file through the OS's memory mapping, pages are only read from disk when they're first
+// touched and nothing is copied into our own buffers. moves but doesn't copy, the mapping is released with the object
+class MappedFile {
+public:
+	MappedFile() {}
+	~MappedFile() { Close(); }
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool Open(const std::string& path); // false (with an error printed) if the file can't be opened or is empty
+	void Close();
+
+	const unsigned char* Data() const { return data; }
+	size_t Size() const { return size; }
+	bool IsOpen() const { return data != nullptr; }
+
+private:
+	const unsigned char* data = nullptr;
+	size_t size = 0;
+#ifdef _WIN32
+	void* file = nullptr; // HANDLEs, kept as void* so windows.h stays out of the header
+	void* mapping = nullptr;
+#endif
+};
+// Mapped File //
+
+// Atomic Write //
+// writes everything to path.tmp, makes sure it has reached the disk, then renames it over path. the rename either
+// happens completely or not at all, so whatever was at path before survives a crash or a failed write at any point
+bool WriteFileAtomic(const std::string& path, const std::vector<unsigned char>& bytes);
+// Atomic Write //
+
+#endif
@@ -8,25 +8,59 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <shader.h>
+#include <gpuresource.h>
+#include <bounds.h>
+#include <profiler.h>
+#include <renderqueue.h>
 #include <algorithm>
 #include <memory>
 #include <iostream>
 #include <string>
+#include <vector>
+
+// Mesh Counts //
+// what Draw and Queue did, added up by the caller over a whole pass and handed to the profiler once with Report. the
+// profiler locks and looks the name up on every call, too much to do per object
+struct MeshCounts {
+	long long tested = 0; // meshes checked against a frustum
+	long long culled = 0;
+	long long drawCalls = 0; // Draw only, what Queue adds is counted by the RenderQueue when it draws
+	long long triangles = 0;
+	void Report() const; // adds them to culling.tested/culled and draw.calls/triangles
+};
+// Mesh Counts //
 
 class Model {
 private:
+	void CullMeshes(const Frustum* frustum, MeshCounts& counts); // fills meshVisible
 	
 public:
+	std::string name; // file the model was loaded from, also used as the owner name in the GPU resource registry
 	unsigned int numVertices;
 	unsigned int numFaces;
 	unsigned int numMeshes;
-	unsigned int* meshIndices; 
-	unsigned int* VAOs;
-	glm::mat4* transforms;
-	void Model::ProcessMesh(const aiScene* scene, unsigned int);
-	void Model::FindMeshTransform(aiString meshNode, aiNode* node, unsigned int mesh, bool&);
+	std::vector<unsigned int> meshIndices; 
+	std::vector<GLVertexArray> VAOs;
+	std::vector<GLBuffer> VBOs;
+	std::vector<GLBuffer> EBOs;
+	std::vector<glm::mat4> transforms;
+	std::vector<std::vector<glm::vec3>> cpuPositions; // a CPU side copy of each mesh's vertex positions and triangle indices,
+	std::vector<std::vector<unsigned int>> cpuIndices; // kept for things like software occlusion that can't read GPU buffers
+	AABB bounds; // around every mesh in the model
+	std::vector<AABB> meshBounds; // per mesh, already moved by transforms[mesh]
+	std::vector<BoundingSphere> meshSpheres;
+	BoundsList cullBounds; // the same bounds in the layout the culling kernel wants
+	std::vector<unsigned char> meshVisible; // filled by the culling pass each Draw
+	void ProcessMesh(const aiScene* scene, unsigned int);
+	void FindMeshTransform(aiString meshNode, aiNode* node, unsigned int mesh, bool&);
 	Model(const std::string& file);
-	void Draw(Shader shader);
+	void Unload(); // frees all GPU memory, the destructor does this too
+	// objectMatrix places the whole model in the world, meshes outside the frustum (given in the model's own space) are skipped.
+	// for shaders with a plain "model" uniform (depth.vert and the passes drawn with it), shaders that read ObjectData
+	// like default.vert have to go through Queue and a RenderQueue instead
+	void Draw(const Shader& shader, MeshCounts& counts, const glm::mat4& objectMatrix = glm::mat4(1.0f), const Frustum* frustum = nullptr);
+	// same as Draw but adds the meshes to a render queue instead, viewProjection is only used for their depth
+	void Queue(RenderQueue& queue, const Shader& shader, MeshCounts& counts, const glm::mat4& objectMatrix, const glm::mat4& viewProjection, const Frustum* frustum = nullptr, bool translucent = false);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,75 @@
+#ifndef OCCLUSION_H
+#define OCCLUSION_H
+#include <glad\gl.h>
+#include <glm/glm.hpp> // openGL Mathematics
+#include <bounds.h>
+#include <gpuresource.h>
+#include <shader.h>
+#include <vector>
+
+class Scene;
+
+// Occlusion Culler //
+// anything that can tell the scene an object is hidden behind something else, the scene calls Prepare once a frame
+// (after frustum culling) and then asks about each object that survived
+class OcclusionCuller {
+public:
+	virtual ~OcclusionCuller() {}
+	virtual void Prepare(const Scene& scene, const glm::mat4& viewProjection) = 0;
+	virtual bool IsOccluded(const AABB& box) const = 0;
+};
+// Occlusion Culler //
+
+// Hierarchical Z Occlusion //
+// draws the scene's occluders (RENDER_OCCLUDER objects) into a small depth buffer, then builds a mip chain where each texel
+// holds the furthest depth of the four below it. one of the small levels is copied back to the CPU through a pixel buffer
+// and objects are tested against the newest copy that has finished, so the CPU never waits on the GPU (at the cost of the
+// result being a frame or two old)
+class HiZOcclusion : public OcclusionCuller {
+public:
+	HiZOcclusion(unsigned int width = 512, unsigned int height = 256); // should be powers of two
+	void Prepare(const Scene& scene, const glm::mat4& viewProjection) override;
+	bool IsOccluded(const AABB& box) const override;
+	void Unload();
+	// draws the occluders and builds the pyramid without reading anything back, for when only the GPU tests against it
+	void Render(const Scene& scene, const glm::mat4& viewProjection);
+
+	unsigned int DepthPyramid() const { return depthTexture.ID(); } // the latest pyramid, for GPU side tests
+	const glm::mat4& PyramidViewProjection() const { return pyramidViewProjection; } // the camera it was drawn with
+	unsigned int Levels() const { return levels; }
+	unsigned int Width() const { return width; }
+	unsigned int Height() const { return height; }
+
+private:
+	void RenderOccluders(const Scene& scene, const glm::mat4& viewProjection);
+	void BuildPyramid();
+	void StartReadback(const glm::mat4& viewProjection);
+	void FinishReadback(); // picks up whichever readback has finished, never waits
+
+	static const unsigned int numReadbacks = 3; // how many copies can be in flight at once
+
+	Shader depthShader;
+	Shader downsampleShader;
+	GLTexture depthTexture; // level 0 is the occluder depth, the rest is the pyramid
+	GLFramebuffer framebuffer;
+	GLVertexArray emptyVAO; // core profile needs a VAO bound even for the fullscreen triangle
+	GLBuffer readbackBuffers[numReadbacks];
+	GLsync readbackFences[numReadbacks];
+	glm::mat4 readbackViewProjection[numReadbacks];
+	unsigned int nextReadback;
+
+	unsigned int width;
+	unsigned int height;
+	unsigned int levels;
+	unsigned int readbackLevel; // first level that is 64 texels wide or less
+	unsigned int readbackWidth;
+	unsigned int readbackHeight;
+
+	glm::mat4 pyramidViewProjection;
+	std::vector<float> hizDepth; // the latest level that made it back to the CPU
+	glm::mat4 hizViewProjection; // the camera it was drawn with
+	bool hizValid;
+};
+// Hierarchical Z Occlusion //
+
+#endif
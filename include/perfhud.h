@@ -0,0 +1,31 @@
+#ifndef PERFHUD_H
+#define PERFHUD_H
+#include <glm/glm.hpp> // openGL Mathematics
+#include <ui.h>
+
+// Performance HUD //
+// what's behind a hitch, live: CPU and GPU frame time graphs over the last couple of seconds and the last frame's draw
+// calls, triangles, state changes, GPU memory, job system load and uploads. it's all read from the profiler and drawn
+// through the UI, so it adds a few hundred quads to the UI's one draw and nothing at all while it's hidden. numbers the
+// engine can't know (triangles the GPU culled for itself, a GPU time that hasn't come back yet) are said to be unknown
+// rather than shown as 0
+class PerfHUD {
+public:
+	static const int historyLength = 120; // frames in the graphs
+
+	PerfHUD();
+	void Record(); // once a frame, takes the profiler's last completed frame into the graphs whether or not it's shown
+	void Draw(UIContext& ui, const glm::vec2& screenSize); // top right corner
+
+	bool visible = false;
+
+private:
+	float cpuHistory[historyLength]; // milliseconds, oldest at historyNext
+	float gpuHistory[historyLength];
+	int historyNext = 0;
+	bool gpuKnown = false; // a GPU time has come back at least once
+	double jobUtilization = 0.0;
+};
+// Performance HUD //
+
+#endif
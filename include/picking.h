@@ -0,0 +1,84 @@
+#ifndef PICKING_H
+#define PICKING_H
+#include <glad\gl.h>
+#include <glm/glm.hpp> // openGL Mathematics
+#include <gameobject.h>
+#include <gpuresource.h>
+#include <shader.h>
+#include <memory>
+#include <mutex>
+
+class Scene;
+
+// Pick Request //
+// "what's under this point of the screen", made by the simulation and carried to the render thread in the command list
+struct PickRequest {
+	bool active = false;
+	unsigned int id = 0; // comes back with the result, so a late answer to an old click can be told apart
+	glm::vec3 origin; // the ray through the point, from the near plane
+	glm::vec3 direction; // unit length
+	float maxDistance; // to the far plane
+	glm::mat4 viewProjection; // the camera's, narrowed down to the one pixel (see ObjectPicker::Request)
+};
+
+struct PickResult {
+	unsigned int request;
+	GameObject object; // noObject if the point was empty
+	float distance; // along the request's ray
+	glm::vec3 position; // where it was hit
+};
+// Pick Request //
+
+// Object Picker //
+// finds the object under the cursor for the editor, on the render thread (which owns the scene) without ever holding up
+// a frame. the CPU backend casts the request's ray through the scene's BVH and then against the triangles of whatever
+// boxes it hits (Scene::RayCastMeshes), and has the answer straight away. the GPU backend draws the objects under that one
+// pixel into a 1x1 object ID target with a projection narrowed down to it, so only what the BVH says can cover the pixel
+// is drawn and only one fragment each is shaded. the ID and depth are copied into a pixel buffer and picked up a frame or
+// two later once a fence says they're there, like the hi-z readback. the simulation collects results with Poll
+class ObjectPicker {
+public:
+	enum Backend {
+		PICK_CPU, // ray cast against the triangles
+		PICK_GPU // object ID buffer, pixel exact against what was drawn
+	};
+
+	explicit ObjectPicker(Backend backend); // the GL context has to be current for the GPU backend
+	void Unload();
+
+	// builds a request for a point in a camera's view, ndc is -1..1 across the view and pixel is the size of one pixel
+	// in the same units (2 / the view's size in pixels)
+	static PickRequest Request(unsigned int id, const glm::mat4& viewProjection, const glm::vec2& ndc, const glm::vec2& pixel);
+
+	// render thread, every frame: starts the request if it's active and picks up readbacks that have finished
+	void Process(const Scene& scene, const PickRequest& request);
+	// any thread: true once for each new result, older unread results are replaced by newer ones
+	bool Poll(PickResult& result);
+
+private:
+	void RenderIDs(const Scene& scene, const PickRequest& request);
+	void FinishReadbacks(); // never waits
+	void Post(const PickResult& result);
+
+	static const unsigned int numReadbacks = 3;
+
+	Backend backend;
+
+	// GPU //
+	std::unique_ptr<Shader> idShader; // only compiled for the GPU backend
+	GLTexture idTexture; // 1x1 GL_R32UI, object + 1, 0 is nothing
+	GLTexture depthTexture;
+	GLFramebuffer framebuffer;
+	GLBuffer readbackBuffers[numReadbacks]; // the ID followed by the depth
+	GLsync readbackFences[numReadbacks];
+	PickRequest readbackRequests[numReadbacks];
+	unsigned int nextReadback = 0;
+	// GPU //
+
+	std::mutex mutex;
+	PickResult latest;
+	bool fresh = false;
+};
+// Object Picker //
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+
+// Profiler //
+// collects named counters (things culled, draw calls, ...) and timers for the current frame,
+// at the end of each frame they are moved into 'last frame' so anything can read a complete set of numbers
+class Profiler {
+public:
+	static Profiler& Get();
+
+	void BeginFrame();
+	void EndFrame(); // also prints a summary every reportInterval seconds when that is above zero
+
+	void AddCounter(const std::string& name, long long value); // accumulates over the frame
+	void SetCounter(const std::string& name, long long value); // overwrites, for things like memory totals
+	void AddTime(const std::string& name, double milliseconds);
+
+	long long Counter(const std::string& name) const; // values from the last completed frame
+	double Time(const std::string& name) const;
+	double FrameTime() const { return lastFrameTime; }
+	void Print() const;
+
+	double reportInterval; // seconds between console summaries, 0 turns them off
+
+private:
+	Profiler();
+
+	typedef std::chrono::high_resolution_clock Clock;
+	std::map<std::string, long long> counters; // std::map so the printed summary comes out sorted
+	std::map<std::string, double> times;
+	std::map<std::string, long long> lastCounters;
+	std::map<std::string, double> lastTimes;
+	Clock::time_point frameStart;
+	Clock::time_point lastReport;
+	double lastFrameTime; // milliseconds
+	mutable std::mutex mutex;
+};
+// Profiler //
+
+// times everything until the end of the current scope and adds it to the named timer
+class ScopedTimer {
+public:
+	ScopedTimer(const char* timerName) : name(timerName), start(std::chrono::high_resolution_clock::now()) {}
+	~ScopedTimer() {
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+		Profiler::Get().AddTime(name, elapsed.count());
+	}
+private:
+	const char* name;
+	std::chrono::high_resolution_clock::time_point start;
+};
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+#include <glad\gl.h>
+#include <glm/glm.hpp> // openGL Mathematics
+#include <cstdint>
+#include <uniformbuffers.h>
+#include <vector>
+
+enum RenderPass {
+	RENDER_PASS_MAIN = 0,
+	RENDER_PASS_OVERLAY = 1, // drawn after everything in the main pass
+};
+
+// one glDrawElements worth of state
+struct RenderCommand {
+	unsigned int shader;
+	unsigned int texture; // 0 leaves whatever is bound alone
+	unsigned int VAO;
+	unsigned int indexCount;
+	glm::mat4 transform; // goes in the draw's ObjectData slot
+};
+
+// Render Queue //
+// draws are collected for the whole frame, each with a 64 bit key, and radix sorted before anything is sent to GL.
+// from the top bit down the key holds the pass, translucency, then for opaque draws shader > texture > VAO > depth so
+// state only changes when it has to and draws sharing state go front to back (for early z). translucent draws put
+// depth right after the translucency bit instead, back to front, since blending needs that order more than it needs
+// fewer state changes. ids are truncated to fit their bits, a collision only costs an extra state change
+class RenderQueue {
+public:
+	void Clear();
+	// depth is the view space distance (clip w), anything behind the camera is treated as 0
+	void Add(const RenderCommand& command, float depth, bool translucent = false, RenderPass pass = RENDER_PASS_MAIN);
+	void Sort();
+	// issues every draw in key order (call Sort first) and skips redundant binds. the transforms are all written into
+	// ObjectData slots up front and each draw only binds its slot, so the shaders have to take their model matrix from
+	// the ObjectData block (like default.vert), a plain "model" uniform would never be set
+	void Execute(UniformBuffers& uniforms);
+	unsigned int Size() const { return (unsigned int)commands.size(); }
+
+	static uint64_t MakeKey(const RenderCommand& command, float depth, bool translucent, RenderPass pass);
+
+private:
+	static const int radixBits = 11;
+	static const int radixBuckets = 1 << radixBits;
+	static const int radixPasses = (64 + radixBits - 1) / radixBits;
+
+	std::vector<RenderCommand> commands;
+	std::vector<uint64_t> keys;
+	std::vector<unsigned int> order; // indices into commands, sorted by key
+	std::vector<uint64_t> keysScratch;
+	std::vector<unsigned int> orderScratch;
+};
+// Render Queue //
+
+#endif
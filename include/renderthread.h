@@ -0,0 +1,109 @@
+#ifndef RENDERTHREAD_H
+#define RENDERTHREAD_H
+#include <glad\gl.h>
+#include <GLFW\glfw3.h>
+#include <glm/glm.hpp> // openGL Mathematics
+#include <gameobject.h>
+#include <bounds.h>
+#include <uniformbuffers.h>
+#include <picking.h>
+#include <ui.h>
+#include <debugdraw.h>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// what to do with the level file this frame, handled on the render thread since it owns the scene (and the context
+// that loaded models go into)
+enum LevelRequest {
+	LEVEL_NONE,
+	LEVEL_SAVE,
+	LEVEL_LOAD
+};
+
+// Render Command List //
+// everything the render thread needs to draw one frame, filled in by the simulation. the render thread owns the scene
+// once it's running, so changes to it are recorded here and applied before drawing instead of being made directly
+struct RenderCommandList {
+	struct TransformChange {
+		GameObject object;
+		TransformComponent transform;
+	};
+
+	// one per camera drawing this frame, each into its own rectangle of the window
+	struct View {
+		FrameUniforms frame;
+		glm::mat4 viewProjection;
+		Frustum frustum; // the camera's, already worked out
+		int x; // viewport, in framebuffer pixels from the bottom left
+		int y;
+		int width;
+		int height;
+	};
+
+	std::vector<View> views;
+	glm::vec4 clearColor;
+	int width; // framebuffer size
+	int height;
+	int swapInterval = 1; // 0 off, 1 vsync, -1 adaptive (see FramePacer)
+	std::vector<TransformChange> transformChanges;
+	LevelRequest levelRequest = LEVEL_NONE;
+	PickRequest pick; // at most one a frame, the answer comes back through the ObjectPicker
+	UIDrawList ui; // drawn over every view
+	std::vector<UIAtlas::Upload> uiUploads; // new atlas contents, copied in before the UI is drawn
+	DebugDrawList debug; // the simulation's lines, the render thread adds its own before drawing them into every view
+
+	void Clear() {
+		views.clear();
+		transformChanges.clear();
+		levelRequest = LEVEL_NONE;
+		pick.active = false;
+		ui.Clear();
+		uiUploads.clear();
+		debug.Clear();
+	}
+};
+// Render Command List //
+
+// Render Thread //
+// owns the GL context and draws from one command list while the simulation fills in the other, so a frame's simulation
+// overlaps the previous frame's rendering. GLFW only allows window events on the main thread, so the main thread stays
+// the simulation and the context moves over here. with threaded set to false everything runs inline on the caller
+// instead (handy for debugging GL). buffers are swapped wherever the frame was drawn, so that's where vsync applies too
+class RenderThread {
+public:
+	typedef std::function<void(RenderCommandList& commands)> RenderFunction;
+
+	// the context has to be current on the calling thread, it's released and picked up by the render thread
+	void Start(GLFWwindow* window, const RenderFunction& render, bool threaded = true);
+	RenderCommandList& Commands() { return lists[writeList]; } // the list the simulation is writing this frame
+	// hands this frame's list over and clears the next one, only blocks while the render thread is still on the frame before
+	void Submit();
+	// blocks until the render thread has finished every submitted list, after that the scene can be read from the
+	// calling thread until the next Submit
+	void WaitIdle();
+	void Stop(); // finishes the last frame and makes the context current on the calling thread again (for cleanup)
+
+private:
+	void Loop();
+	void Present(const RenderCommandList& commands); // swaps, with the swap interval the list asks for
+
+	GLFWwindow* window = nullptr;
+	RenderFunction render;
+	bool threaded = false;
+	int swapInterval = 0x7fffffff; // what the context is set to, nothing valid until the first frame sets it
+	std::thread thread;
+
+	RenderCommandList lists[2];
+	unsigned int writeList = 0; // the simulation's list, the render thread reads the other one
+	bool submitted = false; // a list is waiting for the render thread or being drawn
+	bool quit = false;
+	std::mutex mutex;
+	std::condition_variable wake; // the render thread waits here for a list
+	std::condition_variable done; // the simulation waits here for the render thread to pick a list up
+};
+// Render Thread //
+
+#endif
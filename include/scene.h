@@ -0,0 +1,79 @@
+#ifndef SCENE_H
+#define SCENE_H
+#include <gameobject.h>
+#include <model.h>
+#include <bvh.h>
+#include <bounds.h>
+#include <renderqueue.h>
+#include <profiler.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+const GameObject noObject = 0xFFFFFFFF;
+
+class OcclusionCuller;
+class IndirectRenderer;
+class GPUCulling;
+
+// Scene //
+// owns every game object in the level (as one array per component type), the models they use and a BVH over their bounds
+class Scene {
+public:
+	unsigned int LoadModel(const std::string& file); // returns the model's index, files that are already loaded are reused
+	GameObject Create(unsigned int model, const TransformComponent& transform, unsigned int flags = RENDER_VISIBLE);
+	void Remove(GameObject object); // the last object is moved into the gap so the arrays stay packed
+	void SetTransform(GameObject object, const TransformComponent& transform);
+	// replaces every object at once (loading a level), models maps each render's model to an index into this scene's
+	// models. returns false, leaving the scene empty, if a render refers to a model past the end of the map
+	bool Assign(const TransformComponent* newTransforms, const RenderComponent* newRenders, unsigned int count, const std::vector<unsigned int>& modelMap);
+	unsigned int Size() const { return (unsigned int)transforms.size(); }
+	unsigned int Version() const { return version; } // changes whenever an object is created, removed or moved
+	unsigned int LayoutVersion() const { return layoutVersion; } // only changes when objects are created, removed or replaced
+	// every object SetTransform has moved since the layout last changed, oldest first and with repeats. readers remember
+	// how far they got instead of the list being cleared, and a changed LayoutVersion means start again from the top
+	const std::vector<GameObject>& MovedObjects() const { return movedObjects; }
+	void Unload(); // frees all objects and models, has to happen while the GL context is still alive
+
+	void Cull(const Frustum& frustum, std::vector<GameObject>& visible) const;
+	// culls several views (up to BVH::maxFrusta) in one pass over the tree, visible[i] gets what frusta[i] can see
+	void CullViews(const Frustum* frusta, unsigned int count, std::vector<std::vector<GameObject>>& visible);
+	void Draw(const Shader& shader, const glm::mat4& viewProjection); // culls and draws a single view
+	// draws objects that were already culled for this view, through the indirect renderer when there is one
+	void DrawObjects(const Shader& shader, const std::vector<GameObject>& objects, const glm::mat4& viewProjection);
+	// returns the first object whose bounds the ray hits (or noObject), distance is set to how far along the ray it was
+	GameObject RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance) const;
+	// same, but objects whose bounds the ray hits are only hits if one of their triangles is (Model::cpuPositions), so a
+	// ray through the gaps of an object finds whatever is behind it. for picking, where the box isn't good enough
+	GameObject RayCastMeshes(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance) const;
+
+	// Components //
+	// read these freely, but go through SetTransform to change a transform so the cached data and BVH stay in sync
+	std::vector<TransformComponent> transforms;
+	std::vector<RenderComponent> renders;
+	std::vector<glm::mat4> worldMatrices; // transforms[i].Matrix(), cached
+	std::vector<AABB> worldBounds; // model bounds moved into world space
+	// Components //
+
+	std::vector<std::unique_ptr<Model>> models;
+	BVH bvh;
+	OcclusionCuller* occlusion = nullptr; // optional, objects it reports as hidden are skipped by Draw
+	IndirectRenderer* indirect = nullptr; // optional, draws everything visible in one call when the driver supports it
+	GPUCulling* gpuCulling = nullptr; // optional, culls and draws entirely on the GPU (replaces both of the above)
+	UniformBuffers* uniforms = nullptr; // where per object transforms go, needed unless indirect or gpuCulling draws everything
+
+private:
+	void UpdateDerived(GameObject object); // recomputes the world matrix and bounds after a transform change
+	void LayoutChanged();
+
+	unsigned int version = 0;
+	unsigned int layoutVersion = 0;
+	std::vector<GameObject> movedObjects;
+	std::vector<int> proxies; // each object's leaf in the BVH
+	std::vector<GameObject> visibleObjects; // reused every frame to avoid allocating
+	std::vector<unsigned char> visibleMasks; // for CullViews, which views each of visibleObjects is in
+	RenderQueue queue;
+};
+// Scene //
+
+#endif
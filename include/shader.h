@@ -1,6 +1,7 @@
 #ifndef SHADER_H 
 #define SHADER_H
 #include <glad\gl.h>
+#include <gpuresource.h>
 #include <fstream>
 #include <iostream>
 #include <string>
@@ -9,14 +10,19 @@ class Shader {
 private:
 	unsigned int vertexShader;
 	unsigned int fragmentShader;
+	GLProgram program; // deleted automatically when the shader goes out of scope
 public:
-	unsigned int ID;
 	Shader(const std::string& vertexShaderPath, const std::string& fragmentShaderPath);
+	explicit Shader(const std::string& computeShaderPath); // compute only program (GL 4.3)
+	unsigned int ID() const { return program.ID(); }
+	void Unload() { program.Reset(); }
 
 private:
 	std::string ReadShaderFile(const std::string& file);
 	unsigned int CompileShader(const std::string& file);
 	unsigned int CreateShaderProgram(unsigned int vertexShader, unsigned int fragmentShader);
+	unsigned int CreateComputeProgram(unsigned int computeShader);
+	void FinishProgram(); // uniform block bindings and size tracking, once the program has linked
 	void CheckSuccess(unsigned int type, unsigned int subject);
 };
 
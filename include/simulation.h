@@ -0,0 +1,55 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+#include <glm/glm.hpp> // openGL Mathematics
+#include <gameobject.h>
+#include <renderthread.h>
+#include <chunkedarray.h>
+#include <vector>
+
+// Fixed Timestep //
+// the simulation always advances in steps of exactly 1 / tickRate seconds no matter how fast frames come, so it plays out
+// the same at 30 or 300 fps. frame time is banked in an accumulator and spent a step at a time, anything left over is
+// how far the renderer should blend towards the newest step
+class FixedTimestep {
+public:
+	FixedTimestep(double tickRate = 60.0, unsigned int maxCatchUp = 5);
+	void SetTickRate(double tickRate);
+	// adds the frame's time and returns how many steps to run. after a long stall only maxCatchUp steps are run and the
+	// rest is dropped, otherwise slow frames would queue up ever more steps and never recover
+	unsigned int Advance(double frameSeconds);
+	float Step() const { return (float)step; }
+	float Alpha() const { return (float)(accumulator / step); } // 0..1 between the previous and the newest step
+	unsigned long long Ticks() const { return ticks; }
+
+private:
+	double step;
+	double accumulator;
+	unsigned int maxCatchUp;
+	unsigned long long ticks; // steps run since the start
+};
+// Fixed Timestep //
+
+// Simulation State //
+// everything the fixed step simulation advances. the previous step is kept next to the current one so each frame
+// can be drawn part way between them. object data is in chunked arrays, so copying a state (every step, and whenever
+// play mode starts) only copies the chunks that end up being written
+struct SimulationState {
+	glm::vec3 cameraPosition;
+	float yaw; // degrees, camera look direction
+	float pitch;
+	glm::vec3 backgroundColor; // pulses between dark and light blue
+	bool backgroundRising;
+	ChunkedArray<TransformComponent> transforms; // one per scene object, same indices as Scene
+};
+
+// adds a transform change for every object that moved between the two states (blended by alpha). chunks the two states
+// share are skipped without looking inside, movingChunks remembers which chunks were sent last frame so objects that
+// just stopped still get their final transform
+void InterpolateTransforms(const SimulationState& previous, const SimulationState& current, float alpha,
+	std::vector<unsigned char>& movingChunks, std::vector<RenderCommandList::TransformChange>& changes);
+// adds every object in the chunks that differ between the two states, for when the simulation jumps to another state
+// (restoring a snapshot) instead of moving towards it
+void ResyncTransforms(const SimulationState& from, const SimulationState& to, std::vector<RenderCommandList::TransformChange>& changes);
+// Simulation State //
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef SOFTWAREOCCLUSION_H
+#define SOFTWAREOCCLUSION_H
+#include <glm/glm.hpp> // openGL Mathematics
+#include <occlusion.h>
+#include <gameobject.h>
+#include <vector>
+
+// Software Occlusion //
+// a small depth buffer drawn entirely on the CPU from the triangles of RENDER_OCCLUDER objects (kept in Model::cpuPositions),
+// it never touches the GPU so results are ready the same frame and come out identical on every driver
+//
+// triangles are transformed and sorted into 32x32 pixel tiles across the job system's threads, then each tile is
+// rasterized on its own (4 pixels at a time with SSE, 8 with AVX) so no two threads ever write the same pixel
+class SoftwareOcclusion : public OcclusionCuller {
+public:
+	SoftwareOcclusion(unsigned int width = 256, unsigned int height = 128); // both should be multiples of 32
+	void Prepare(const Scene& scene, const glm::mat4& viewProjection) override;
+	bool IsOccluded(const AABB& box) const override;
+
+	const std::vector<float>& Depth() const { return depth; } // row 0 is the bottom of the screen, like GL
+	unsigned int Width() const { return width; }
+	unsigned int Height() const { return height; }
+
+private:
+	struct ScreenTriangle {
+		glm::vec3 vertex[3]; // x and y in pixels, z as a 0..1 depth, always wound counter clockwise
+	};
+
+	void TransformAndBin(const Scene& scene, unsigned int firstOccluder, unsigned int endOccluder, unsigned int thread);
+	void RasterizeTile(unsigned int tile);
+	void RasterizeTriangle(const ScreenTriangle& triangle, int tileX, int tileY);
+
+	static const int tileSize = 32;
+	static const int coarseSize = 8; // each coarse texel keeps the furthest depth of an 8x8 block
+
+	unsigned int width;
+	unsigned int height;
+	unsigned int tilesX;
+	unsigned int tilesY;
+	std::vector<float> depth;
+	std::vector<float> coarseDepth; // what IsOccluded actually reads
+	unsigned int coarseWidth;
+	unsigned int coarseHeight;
+
+	std::vector<GameObject> occluders;
+	std::vector<std::vector<ScreenTriangle>> threadTriangles; // one list per job system thread so binning needs no locks
+	std::vector<std::vector<std::vector<unsigned int>>> threadBins; // [thread][tile] -> indices into threadTriangles[thread]
+	glm::mat4 viewProjection;
+};
+// Software Occlusion //
+
+#endif
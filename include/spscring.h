@@ -0,0 +1,49 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+#include <atomic>
+#include <cstddef>
+
+// SPSC Ring //
+// a fixed size queue for exactly one thread pushing and one thread popping, no locks. each side only ever writes its
+// own index, the release store publishes the slot it just filled (or emptied) to the other side. Capacity has to be a
+// power of two, the indices run freely and are masked on use so full and empty can be told apart without a spare slot
+template<typename T, size_t Capacity>
+class SPSCRing {
+	static_assert((Capacity & (Capacity - 1)) == 0, "SPSCRing capacity has to be a power of two");
+
+public:
+	// producer side, false when full (the item is dropped). reserve slots are left free for pushes that don't ask for any,
+	// so items that matter more can't be crowded out by ones that don't
+	bool Push(const T& item, size_t reserve = 0) {
+		size_t tail = writeIndex.load(std::memory_order_relaxed);
+		if (tail - readIndex.load(std::memory_order_acquire) + reserve >= Capacity) {
+			return false;
+		}
+		items[tail & (Capacity - 1)] = item;
+		writeIndex.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// consumer side, the oldest item or nullptr when empty. it stays valid until Pop
+	const T* Front() const {
+		size_t head = readIndex.load(std::memory_order_relaxed);
+		if (head == writeIndex.load(std::memory_order_acquire)) {
+			return nullptr;
+		}
+		return &items[head & (Capacity - 1)];
+	}
+
+	void Pop() {
+		readIndex.store(readIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	size_t Size() const { return writeIndex.load(std::memory_order_acquire) - readIndex.load(std::memory_order_acquire); }
+
+private:
+	T items[Capacity];
+	alignas(64) std::atomic<size_t> writeIndex{ 0 }; // on separate cache lines so the two threads don't fight over one
+	alignas(64) std::atomic<size_t> readIndex{ 0 };
+};
+// SPSC Ring //
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef STREAMBUFFER_H
+#define STREAMBUFFER_H
+#include <glad\gl.h>
+#include <gpuresource.h>
+#include <chrono>
+#include <deque>
+#include <string>
+
+// Stream Buffer //
+// a ring buffer for data that changes every frame (object constants, debug lines, UI vertices, ...). each frame's writes
+// go right after the last frame's and wrap around at the end, so the CPU is always writing where the GPU isn't reading.
+//
+// with GL 4.4 buffer storage the whole ring stays persistently mapped (coherent, so nothing needs flushing) and every
+// frame is fenced, writing only waits when it catches up with a frame the GPU still hasn't finished. on 3.3 each write
+// maps its range unsynchronized instead and the ring never wraps mid-frame, EndFrame orphans the buffer (the driver
+// hands over a fresh copy while the old one is still drawn from) when what's left couldn't hold twice the biggest frame.
+//
+// nothing is ever reused or orphaned in the middle of a frame, ranges handed out earlier in the frame may still be bound
+// for draws that haven't been issued. a write that doesn't fit fails instead (Map returns nullptr). if the frame would
+// have fit an empty ring EndFrame just starts the next one at zero, only a frame bigger than the whole ring grows it (to
+// twice that frame). new storage replaces the buffer, so ID() can change between frames
+class StreamBuffer {
+public:
+	struct Allocation {
+		unsigned char* data; // write only, nullptr if the request can never fit
+		size_t offset; // where the data starts in the buffer, for glBindBufferRange / attribute offsets
+	};
+
+	StreamBuffer(GLenum target, size_t capacity, const std::string& owner); // capacity should hold a couple of frames
+
+	// maps bytes at an offset that's a multiple of alignment, Unmap has to be called before anything draws from it
+	Allocation Map(size_t bytes, size_t alignment = 16);
+	void Unmap();
+	bool Write(const void* data, size_t bytes, size_t& offset, size_t alignment = 16); // Map, copy, Unmap in one, false if it didn't fit
+	void EndFrame(); // call once every frame after the last draw that reads this frame's data
+
+	unsigned int ID() const { return buffer.ID(); }
+	GLenum Target() const { return target; }
+	size_t Capacity() const { return capacity; }
+	void Unload();
+
+private:
+	struct FrameFence {
+		GLsync fence;
+		size_t bytes; // how much of the ring the frame used, freed once the fence passes
+	};
+
+	void Overflow(size_t bytes); // a write that didn't fit, EndFrame makes room for the next frame
+	void Create(); // new storage of capacity bytes, replacing the old buffer and everything in flight
+	void Retire(bool wait); // frees frames the GPU has finished with, waiting for the oldest one if asked
+
+	GLenum target;
+	size_t capacity;
+	std::string owner;
+	GLBuffer buffer;
+	bool persistent;
+	unsigned char* persistentMemory;
+	bool mapped; // an unsynchronized map is open (3.3 path only)
+
+	size_t head; // where the next write goes
+	size_t used; // bytes between the oldest unfinished frame and head, including padding
+	size_t frameBytes; // used by the current frame so far
+	size_t frameOverflow; // bytes asked for this frame that didn't fit
+	size_t peakFrameBytes; // the most any frame has used, decides when the 3.3 path orphans
+	std::deque<FrameFence> frames; // oldest first
+
+	// Stats //
+	size_t bytesWritten; // since the last throughput report
+	long long throughput; // kilobytes per second over the last second
+	std::chrono::steady_clock::time_point throughputStart;
+	// Stats //
+};
+// Stream Buffer //
+
+#endif
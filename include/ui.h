@@ -0,0 +1,182 @@
+#ifndef UI_H
+#define UI_H
+#include <glm/glm.hpp> // openGL Mathematics
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Font;
+
+// Colours //
+// packed RGBA8, red in the lowest byte, the way the vertex attribute reads it
+inline uint32_t UIColor(float r, float g, float b, float a = 1.0f) {
+	return (uint32_t)(r * 255.0f + 0.5f) | (uint32_t)(g * 255.0f + 0.5f) << 8 | (uint32_t)(b * 255.0f + 0.5f) << 16 | (uint32_t)(a * 255.0f + 0.5f) << 24;
+}
+// Colours //
+
+// UI Geometry //
+struct UIVertex {
+	glm::vec2 position; // window pixels from the top left
+	glm::vec2 uv; // into the atlas
+	uint32_t color; // UIColor, multiplies the atlas
+	float sdf; // 1 for text, whose atlas alpha is a distance field (see Font), 0 for everything else
+};
+
+// a frame's worth of UI, built by the simulation and drawn by the render thread. vertices come in fours, one quad each
+struct UIDrawList {
+	std::vector<UIVertex> vertices;
+	glm::vec2 screenSize; // the window size the positions are in, the framebuffer can be bigger
+
+	void Clear() { vertices.clear(); }
+};
+// UI Geometry //
+
+// UI Atlas //
+// the one texture every UI quad samples, so the whole UI can go out in one draw. images are packed into rows (shelves)
+// as they're added, a block of white in the corner is what solid quads use. packing happens on the simulation thread,
+// the pixels are queued as uploads for the render thread to copy into the texture before it draws
+class UIAtlas {
+public:
+	static const int size = 1024; // pixels square, RGBA8
+
+	struct Region {
+		glm::ivec2 position; // pixels
+		glm::ivec2 extent;
+		glm::vec2 uv0; // top left
+		glm::vec2 uv1; // bottom right
+	};
+	struct Upload {
+		glm::ivec2 position;
+		glm::ivec2 extent;
+		std::vector<unsigned char> pixels; // RGBA8, rows top to bottom
+	};
+
+	UIAtlas();
+	bool Allocate(int width, int height, Region& region); // false once the atlas is full
+	void Write(const Region& region, const unsigned char* rgba); // queues the region's pixels for upload
+	bool Add(int width, int height, const unsigned char* rgba, Region& region); // both of the above
+	glm::vec2 WhiteUV() const { return whiteUV; }
+	void TakeUploads(std::vector<Upload>& uploads); // appends everything queued since the last call
+
+private:
+	struct Shelf {
+		int y;
+		int height;
+		int used; // pixels from the left
+	};
+	std::vector<Shelf> shelves;
+	int shelvesEnd = 0; // y below the last shelf
+	std::vector<Upload> pending;
+	glm::vec2 whiteUV;
+};
+// UI Atlas //
+
+// UI Context //
+// an immediate mode UI: the widgets are plain function calls made every frame, a button is drawn and answers whether it
+// was clicked in the same call and there's no widget tree to keep in sync with the game. behind that, each widget keeps
+// the quads it made last frame along with a hash of everything they were made from (position, size, colours, state,
+// value), so a widget that looks the same as last frame is copied from its cache instead of being rebuilt. text comes
+// from the font's own cache of shaped strings instead. everything ends up in one UIDrawList, drawn with a single call by
+// UIRenderer
+class UIContext {
+public:
+	explicit UIContext(UIAtlas& atlas);
+
+	// the mouse: position in window pixels, whether the button is down and whether it went down or up since the last frame
+	void BeginFrame(UIDrawList& list, const glm::vec2& screenSize, const glm::vec2& cursor, bool down, bool pressed, bool released);
+	void EndFrame(); // forgets widgets that haven't been drawn for a while
+	// true while the cursor is over the UI (as of the last frame) or a widget is being dragged, clicks shouldn't go
+	// through to the level then
+	bool WantsMouse() const { return overUI || active != 0; }
+
+	// Panels //
+	// widgets inside a panel are stacked top to bottom, one row each
+	void BeginPanel(const std::string& name, const glm::vec2& position, float width);
+	void EndPanel();
+	// Panels //
+
+	// Widgets //
+	// labels double as the widget's identity within its panel, so they have to be unique there
+	bool Button(const std::string& label); // true on the frame it's clicked
+	bool Checkbox(const std::string& label, bool& value); // true when value changed
+	bool Slider(const std::string& label, float& value, float minimum, float maximum); // true while value is changing
+	void Separator();
+	void Label(const std::string& text); // a row of text
+	// Widgets //
+
+	// Drawing //
+	// without a font (none set, or it didn't load) text is left out and widgets are drawn without their labels
+	void SetFont(Font* textFont) { font = textFont; }
+	// text anywhere in the window, position is its top left and size its height in pixels (textSize if 0). returns the
+	// room it took up
+	glm::vec2 Text(const std::string& text, const glm::vec2& position, uint32_t color, float size = 0.0f);
+	// a solid rectangle anywhere in the window, for overlays that change every frame so caching them wouldn't help
+	void Rect(const glm::vec2& minimum, const glm::vec2& maximum, uint32_t color);
+	// Drawing //
+
+	// Style //
+	float rowHeight = 20.0f;
+	float padding = 4.0f;
+	uint32_t panelColor = UIColor(0.1f, 0.1f, 0.12f, 0.85f);
+	uint32_t widgetColor = UIColor(0.25f, 0.27f, 0.32f);
+	uint32_t hoverColor = UIColor(0.32f, 0.35f, 0.42f);
+	uint32_t activeColor = UIColor(0.2f, 0.45f, 0.75f);
+	uint32_t accentColor = UIColor(0.35f, 0.6f, 0.95f);
+	uint32_t textColor = UIColor(0.9f, 0.9f, 0.92f);
+	float textSize = 14.0f;
+	// Style //
+
+private:
+	// Cached Geometry //
+	// a widget's quads are only rebuilt when the hash of what they're built from changes. Emit either copies the cached
+	// quads into the draw list (returns false) or clears them and returns true, after which the widget adds its quads
+	// with Quad and they're cached for next time
+	struct CachedWidget {
+		uint32_t hash;
+		unsigned long long lastFrame;
+		std::vector<UIVertex> vertices;
+	};
+	bool Emit(uint32_t id, uint32_t hash);
+	void Quad(const glm::vec2& minimum, const glm::vec2& maximum, uint32_t color); // solid
+	void Quad(const glm::vec2& minimum, const glm::vec2& maximum, const glm::vec2& uv0, const glm::vec2& uv1, uint32_t color);
+	void EndEmit(); // copies the freshly built quads into the draw list
+	// Cached Geometry //
+
+	// Layout //
+	uint32_t WidgetID(const std::string& label) const;
+	void NextRow(glm::vec2& minimum, glm::vec2& maximum); // the next row's rectangle in the current panel
+	bool Hovered(const glm::vec2& minimum, const glm::vec2& maximum) const;
+	uint32_t Interact(uint32_t id, const glm::vec2& minimum, const glm::vec2& maximum); // hover/press handling, returns the colour to draw with
+	void RowText(const std::string& text, const glm::vec2& minimum, const glm::vec2& maximum, bool centered); // vertically centred in the rectangle
+	// Layout //
+
+	UIAtlas& atlas;
+	Font* font = nullptr;
+	UIDrawList* list = nullptr;
+	std::unordered_map<uint32_t, CachedWidget> cache;
+	CachedWidget* building = nullptr; // the widget between Emit and EndEmit
+	unsigned long long frame = 0;
+	unsigned int cacheHits = 0;
+
+	glm::vec2 cursor;
+	bool down = false;
+	bool pressed = false;
+	bool released = false;
+	uint32_t active = 0; // the widget the button went down on, 0 for none
+	bool overUI = false; // as of the last frame
+	bool overUINow = false;
+
+	// the open panel
+	uint32_t panelID = 0;
+	glm::vec2 panelPosition;
+	float panelWidth = 0.0f;
+	float panelY = 0.0f; // where the next row goes
+	size_t panelBackground = 0; // the panel's quad in the draw list, filled in once its height is known
+};
+// UI Context //
+
+// hashing for UI ids and cache keys (FNV-1a)
+uint32_t UIHash(const void* data, size_t bytes, uint32_t hash = 2166136261u);
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef UIRENDERER_H
+#define UIRENDERER_H
+#include <glad\gl.h>
+#include <gpuresource.h>
+#include <shader.h>
+#include <streambuffer.h>
+#include <ui.h>
+#include <vector>
+
+// UI Renderer //
+// draws a UIDrawList over the finished frame: the vertices are copied into a stream buffer in one go and every quad is
+// drawn with a single indexed call out of one atlas texture. the index buffer never changes (quad after quad) and the
+// stream offset is passed as the base vertex, so the vertex layout never has to be set up again either
+class UIRenderer {
+public:
+	UIRenderer(); // the GL context has to be current
+	void Upload(const std::vector<UIAtlas::Upload>& uploads); // atlas changes, before Draw
+	void Draw(const UIDrawList& list, int framebufferWidth, int framebufferHeight);
+	void EndFrame(); // after the last Draw of the frame
+	void Unload();
+
+private:
+	static const size_t maxQuads = 16384; // per draw call, a bigger list is split
+
+	void BindLayout(); // points the vertex array at the stream's buffer
+
+	Shader shader;
+	GLTexture atlasTexture;
+	GLVertexArray vertexArray;
+	GLBuffer indexBuffer;
+	StreamBuffer stream;
+	unsigned int layoutBuffer; // the buffer the vertex array points at
+	int screenSizeLoc;
+};
+// UI Renderer //
+
+#endif
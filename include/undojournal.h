@@ -0,0 +1,62 @@
+#ifndef UNDOJOURNAL_H
+#define UNDOJOURNAL_H
+#include <autosave.h> // TransformChunks
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// Undo Journal //
+// design mode's undo/redo history. an edit is recorded from a snapshot taken before it and the state after it, only the
+// chunks the two don't share are looked at and each is stored as a DeltaCodec diff, so moving a few objects costs a few
+// bytes per object and not a copy of them. the diffs are XORs, undoing an entry applies it and redoing applies it again.
+// the oldest entries are dropped once the journal is over its memory budget. continuous edits (dragging) pass the same
+// tag every step and get merged into one entry until they stop for longer than the coalesce window or EndCoalescing
+class UndoJournal {
+public:
+	UndoJournal(size_t budgetBytes, double coalesceSeconds) : budget(budgetBytes), coalesceWindow(coalesceSeconds) {}
+
+	// before is a copy of the transforms taken right before the edit (cheap, see ChunkedArray), after is the result.
+	// tag 0 never merges. drops anything that could be redone
+	void Record(const TransformChunks& before, const TransformChunks& after, uint32_t tag, double time);
+	void EndCoalescing(); // the next edit gets an entry of its own even with the same tag, e.g. when the mouse is released
+
+	// both return false when there's nothing to undo or redo
+	bool Undo(TransformChunks& transforms);
+	bool Redo(TransformChunks& transforms);
+	void Clear(); // for when the transforms are replaced (a level load), the diffs wouldn't fit them anymore
+
+	size_t UndoCount() const { return applied; }
+	size_t RedoCount() const { return entries.size() - applied; }
+	size_t Bytes() const { return bytes; }
+
+private:
+	struct Entry {
+		std::vector<uint32_t> chunks; // which chunks the edit touched
+		std::vector<uint32_t> ends; // where each chunk's diff ends in data
+		std::vector<unsigned char> data;
+		size_t Bytes() const { return sizeof(Entry) + chunks.capacity() * sizeof(uint32_t) * 2 + data.capacity(); }
+	};
+
+	static void Encode(const TransformChunks& before, const TransformChunks& after, Entry& entry);
+	static bool Apply(const Entry& entry, TransformChunks& transforms);
+	void Push(Entry& entry);
+	void Pop();
+	void DropRedo();
+	void Trim();
+
+	size_t budget;
+	double coalesceWindow;
+	std::deque<Entry> entries; // oldest first, the first applied ones can be undone and the rest redone
+	size_t applied = 0;
+	size_t bytes = 0;
+
+	// Coalescing //
+	TransformChunks coalesceBefore; // the state before the first edit of the open run, holds only the chunks it changed
+	uint32_t coalesceTag = 0; // 0 while no run is open
+	double coalesceTime = 0.0;
+	bool coalesceEntry = false; // the newest entry belongs to the open run (a run that's back where it started has none)
+	// Coalescing //
+};
+// Undo Journal //
+
+#endif
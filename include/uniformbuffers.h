@@ -0,0 +1,61 @@
+#ifndef UNIFORMBUFFERS_H
+#define UNIFORMBUFFERS_H
+#include <glad\gl.h>
+#include <glm/glm.hpp> // openGL Mathematics
+#include <gpuresource.h>
+#include <streambuffer.h>
+
+// binding points shared by every program, Shader hooks its blocks up to these after linking
+enum UniformBlockBinding {
+	FRAME_BLOCK_BINDING = 0, // "FrameData"
+	OBJECT_BLOCK_BINDING = 1, // "ObjectData"
+};
+
+// Uniform Blocks //
+// std140 mirrors of the blocks in the shaders, vec3s are padded out to vec4 so the layouts can't drift apart
+struct FrameUniforms {
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::vec4 cameraPosition; // w is unused
+	glm::vec4 time; // x is seconds since start, y is this frame's delta time
+};
+
+struct ObjectUniforms {
+	glm::mat4 model;
+};
+// Uniform Blocks //
+
+// Uniform Buffers //
+// FrameData is written once per frame. every object drawn in a frame gets its own slot in one big ObjectData range,
+// all slots are written in one go and each draw just points the block at its slot with glBindBufferRange, so there are
+// no per draw glUniform calls at all. both come out of a StreamBuffer, so the CPU never writes over data the GPU is
+// still reading
+class UniformBuffers {
+public:
+	UniformBuffers();
+	static void BindBlocks(unsigned int program); // blocks a program doesn't use are skipped
+
+	void SetFrame(const FrameUniforms& frame);
+
+	// Object Slots //
+	// makes room for this frame's objects and maps them. false when the stream is full for this frame (it grows at
+	// EndFrame), the slots can't be bound then and the objects shouldn't be drawn
+	bool BeginObjects(unsigned int count);
+	void WriteObject(unsigned int index, const ObjectUniforms& object);
+	void EndObjects(); // has to come before any draw that uses the slots
+	void BindObject(unsigned int index);
+	// Object Slots //
+
+	void EndFrame(); // after the last draw of the frame
+	void Unload();
+
+private:
+	StreamBuffer stream;
+	unsigned int alignment; // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+	unsigned int objectStride; // sizeof(ObjectUniforms) rounded up to the alignment
+	size_t objectsOffset; // where this batch's slots start in the stream
+	unsigned char* mappedObjects;
+};
+// Uniform Buffers //
+
+#endif
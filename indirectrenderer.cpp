@@ -0,0 +1,187 @@
+#include "indirectrenderer.h"
+#include "glcaps.h"
+#include "scene.h"
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+
+IndirectRenderer::IndirectRenderer() : shader("assets/shaders/indirect.vert", "assets/shaders/default.frag"), pooledModels(0), drawIDCapacity(0) {
+	VAO = GLVertexArray::Create("indirect renderer");
+	vertexBuffer = GLBuffer::Create("indirect renderer");
+	indexBuffer = GLBuffer::Create("indirect renderer");
+	drawIDBuffer = GLBuffer::Create("indirect renderer");
+	commandBuffer = GLBuffer::Create("indirect renderer");
+	transformBuffer = GLBuffer::Create("indirect renderer");
+}
+
+bool IndirectRenderer::Supported() {
+	return GLCaps::Get().multiDrawIndirect && GLCaps::Get().shaderStorage;
+}
+
+void IndirectRenderer::Unload() {
+	shader.Unload();
+	VAO.Reset();
+	vertexBuffer.Reset();
+	indexBuffer.Reset();
+	drawIDBuffer.Reset();
+	commandBuffer.Reset();
+	transformBuffer.Reset();
+	pooledMeshes.clear();
+	pooledModels = 0;
+}
+
+void IndirectRenderer::Build(const Scene& scene) {
+	ScopedTimer timer("indirect.build");
+	const size_t vertexSize = 8 * sizeof(float); // same layout as Model::ProcessMesh
+
+	// Measure //
+	size_t totalVertices = 0;
+	size_t totalIndices = 0;
+	for (const std::unique_ptr<Model>& model : scene.models) {
+		for (unsigned int mesh = 0; mesh < model->numMeshes; mesh++) {
+			totalVertices += model->cpuPositions[mesh].size();
+			totalIndices += model->meshIndices[mesh];
+		}
+	}
+	// Measure //
+
+	glBindVertexArray(VAO.ID());
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer.ID());
+	BufferData(GL_ARRAY_BUFFER, vertexBuffer, totalVertices * vertexSize, NULL, GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer.ID());
+	BufferData(GL_ELEMENT_ARRAY_BUFFER, indexBuffer, totalIndices * sizeof(unsigned int), NULL, GL_STATIC_DRAW);
+
+	// Pack //
+	// the models already have their data on the GPU, so copy buffer to buffer without going through the CPU
+	pooledMeshes.assign(scene.models.size(), std::vector<PooledMesh>());
+	size_t vertexOffset = 0;
+	size_t indexOffset = 0;
+	for (size_t model = 0; model < scene.models.size(); model++) {
+		const Model& source = *scene.models[model];
+		for (unsigned int mesh = 0; mesh < source.numMeshes; mesh++) {
+			size_t numVertices = source.cpuPositions[mesh].size();
+			size_t numIndices = source.meshIndices[mesh];
+
+			glBindBuffer(GL_COPY_READ_BUFFER, source.VBOs[mesh].ID());
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_ARRAY_BUFFER, 0, vertexOffset * vertexSize, numVertices * vertexSize);
+			glBindBuffer(GL_COPY_READ_BUFFER, source.EBOs[mesh].ID());
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_ELEMENT_ARRAY_BUFFER, 0, indexOffset * sizeof(unsigned int), numIndices * sizeof(unsigned int));
+
+			// indices stay relative to their own mesh, baseVertex shifts them to where the mesh landed
+			pooledMeshes[model].push_back({ (unsigned int)indexOffset, (int)vertexOffset, (unsigned int)numIndices });
+			vertexOffset += numVertices;
+			indexOffset += numIndices;
+		}
+	}
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	pooledModels = (unsigned int)scene.models.size();
+	// Pack //
+
+	// Attributes //
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, vertexSize, (void*)0); // position
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, vertexSize, (void*)(3 * sizeof(float))); // normal
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, vertexSize, (void*)(6 * sizeof(float))); // texture coord
+	glEnableVertexAttribArray(2);
+
+	glBindBuffer(GL_ARRAY_BUFFER, drawIDBuffer.ID());
+	glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, sizeof(unsigned int), (void*)0); // draw id, the I variant keeps it an integer
+	glVertexAttribDivisor(3, 1); // advances per instance, starting from the command's baseInstance
+	glEnableVertexAttribArray(3);
+	// Attributes //
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void IndirectRenderer::Update(const Scene& scene) {
+	if (pooledModels != scene.models.size()) { // a model was loaded since the last build
+		Build(scene);
+	}
+}
+
+void IndirectRenderer::ReserveDrawIDs(unsigned int count) {
+	if (drawIDCapacity >= count) { // the draw id buffer never changes otherwise
+		return;
+	}
+	drawIDCapacity = std::max(count, drawIDCapacity * 2);
+	std::vector<unsigned int> drawIDs(drawIDCapacity);
+	for (unsigned int draw = 0; draw < drawIDCapacity; draw++) {
+		drawIDs[draw] = draw;
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, drawIDBuffer.ID());
+	BufferData(GL_ARRAY_BUFFER, drawIDBuffer, drawIDs.size() * sizeof(unsigned int), drawIDs.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void IndirectRenderer::Submit(unsigned int maxDraws, unsigned int countBuffer) {
+	ReserveDrawIDs(maxDraws);
+
+	glUseProgram(shader.ID());
+	glBindVertexArray(VAO.ID());
+	if (countBuffer) {
+		glBindBuffer(GL_PARAMETER_BUFFER_ARB, countBuffer);
+		glMultiDrawElementsIndirectCountARB(GL_TRIANGLES, GL_UNSIGNED_INT, 0, 0, (GLsizei)maxDraws, 0);
+		glBindBuffer(GL_PARAMETER_BUFFER_ARB, 0);
+	}
+	else {
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, 0, (GLsizei)maxDraws, 0);
+	}
+	glBindVertexArray(0);
+
+	Profiler::Get().AddCounter("draw.calls", 1);
+}
+
+void IndirectRenderer::Draw(const Scene& scene, const std::vector<GameObject>& visible, const glm::mat4& viewProjection) {
+	Update(scene);
+
+	// Build Commands //
+	commands.clear();
+	drawTransforms.clear();
+	long long triangles = 0;
+	long long tested = 0;
+	long long culled = 0;
+	for (GameObject object : visible) {
+		if (!(scene.renders[object].flags & RENDER_VISIBLE)) {
+			continue;
+		}
+		unsigned int model = scene.renders[object].model;
+		const Model& source = *scene.models[model];
+
+		// same per mesh test as Model::Draw, in the model's own space
+		meshVisible.resize(source.cullBounds.Size());
+		unsigned int numVisible = source.cullBounds.Cull(Frustum(viewProjection * scene.worldMatrices[object]), meshVisible.data());
+		tested += source.numMeshes;
+		culled += source.numMeshes - numVisible;
+
+		for (unsigned int mesh = 0; mesh < source.numMeshes; mesh++) {
+			if (!meshVisible[mesh]) {
+				continue;
+			}
+			const PooledMesh& pooled = pooledMeshes[model][mesh];
+			unsigned int draw = (unsigned int)commands.size();
+			commands.push_back({ pooled.indexCount, 1, pooled.firstIndex, pooled.baseVertex, draw });
+			triangles += pooled.indexCount / 3;
+			drawTransforms.push_back(scene.worldMatrices[object] * source.transforms[mesh]);
+		}
+	}
+	Profiler::Get().AddCounter("culling.tested", tested); // once for the pass, not per object
+	Profiler::Get().AddCounter("culling.culled", culled);
+	if (commands.empty()) {
+		return;
+	}
+	// Build Commands //
+
+	// Upload //
+	// passing the data straight to glBufferData orphans last frame's copy, so the GPU can keep reading it while we write
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer.ID());
+	BufferData(GL_DRAW_INDIRECT_BUFFER, commandBuffer, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, transformBuffer.ID());
+	BufferData(GL_SHADER_STORAGE_BUFFER, transformBuffer, drawTransforms.size() * sizeof(glm::mat4), drawTransforms.data(), GL_STREAM_DRAW);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, transformBuffer.ID());
+	// Upload //
+
+	Submit((unsigned int)commands.size());
+	Profiler::Get().AddCounter("draw.commands", commands.size());
+	Profiler::Get().AddCounter("draw.triangles", triangles);
+}
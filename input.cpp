@@ -0,0 +1,127 @@
+#include "input.h"
+#include "profiler.h"
+#include <algorithm>
+
+Input& Input::Get() {
+	static Input input;
+	return input;
+}
+
+Input::Input() : dropped(0), mouseDelta(0.0f), scroll(0.0f), cursor(0.0f), firstCursor(true) {
+	std::fill(std::begin(keys), std::end(keys), false);
+	std::fill(std::begin(buttons), std::end(buttons), false);
+	std::fill(std::begin(pressed), std::end(pressed), false);
+	std::fill(std::begin(released), std::end(released), false);
+}
+
+void Input::Attach(GLFWwindow* window) {
+	glfwSetKeyCallback(window, KeyCallback);
+	glfwSetMouseButtonCallback(window, MouseButtonCallback);
+	glfwSetCursorPosCallback(window, CursorCallback);
+	glfwSetScrollCallback(window, ScrollCallback);
+}
+
+void Input::Bind(InputAction action, Device device, int code) {
+	bindings.push_back({ action, device, code });
+}
+
+void Input::Unbind(InputAction action) {
+	bindings.erase(std::remove_if(bindings.begin(), bindings.end(), [action](const Binding& binding) { return binding.action == action; }), bindings.end());
+}
+
+// Producer //
+// these run inside glfwPollEvents
+void Input::KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+	if (key < 0 || key > GLFW_KEY_LAST) {
+		return; // GLFW_KEY_UNKNOWN, media keys and the like
+	}
+	Get().Push({ INPUT_KEY, key, action, mods, 0.0, 0.0, glfwGetTime() });
+}
+
+void Input::MouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
+	Get().Push({ INPUT_MOUSE_BUTTON, button, action, mods, 0.0, 0.0, glfwGetTime() });
+}
+
+void Input::CursorCallback(GLFWwindow* window, double x, double y) {
+	Get().Push({ INPUT_CURSOR, 0, 0, 0, x, y, glfwGetTime() });
+}
+
+void Input::ScrollCallback(GLFWwindow* window, double x, double y) {
+	Get().Push({ INPUT_SCROLL, 0, 0, 0, x, y, glfwGetTime() });
+}
+
+void Input::Push(const InputEvent& event) {
+	// a dropped cursor event costs nothing in the end since positions are absolute, the next one covers its motion. a
+	// dropped release would leave the key held for good, so motion and scroll can't fill the last of the ring
+	bool motion = event.type == INPUT_CURSOR || event.type == INPUT_SCROLL;
+	if (!events.Push(event, motion ? reservedForKeys : 0)) {
+		dropped.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+// Producer //
+
+// Consumer //
+void Input::Update(double time) {
+	std::fill(std::begin(pressed), std::end(pressed), false);
+	std::fill(std::begin(released), std::end(released), false);
+	mouseDelta = glm::vec2(0.0f);
+	scroll = glm::vec2(0.0f);
+
+	long long applied = 0;
+	while (const InputEvent* event = events.Front()) {
+		if (event->time > time) {
+			break; // belongs to a later step
+		}
+		Apply(*event);
+		events.Pop();
+		applied++;
+	}
+	Profiler::Get().AddCounter("input.events", applied);
+}
+
+void Input::Apply(const InputEvent& event) {
+	switch (event.type) {
+	case INPUT_KEY:
+	case INPUT_MOUSE_BUTTON: {
+		if (event.action == GLFW_REPEAT) {
+			return; // the key was already down
+		}
+		bool down = event.action == GLFW_PRESS;
+		Device device = event.type == INPUT_KEY ? DEVICE_KEYBOARD : DEVICE_MOUSE;
+		bool& state = device == DEVICE_KEYBOARD ? keys[event.code] : buttons[event.code];
+		if (state == down) {
+			return;
+		}
+		state = down;
+		for (const Binding& binding : bindings) {
+			if (binding.device == device && binding.code == event.code) {
+				(down ? pressed : released)[binding.action] = true;
+			}
+		}
+		break;
+	}
+	case INPUT_CURSOR: {
+		glm::vec2 position((float)event.x, (float)event.y);
+		if (firstCursor) { // initially set to true
+			cursor = position;
+			firstCursor = false;
+		}
+		mouseDelta += glm::vec2(position.x - cursor.x, cursor.y - position.y); // y reversed since y-coordinates range from bottom to top
+		cursor = position;
+		break;
+	}
+	case INPUT_SCROLL:
+		scroll += glm::vec2((float)event.x, (float)event.y);
+		break;
+	}
+}
+
+bool Input::Held(InputAction action) const {
+	for (const Binding& binding : bindings) {
+		if (binding.action == action && (binding.device == DEVICE_KEYBOARD ? keys[binding.code] : buttons[binding.code])) {
+			return true;
+		}
+	}
+	return false;
+}
+// Consumer //
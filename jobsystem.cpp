@@ -0,0 +1,118 @@
+#include "jobsystem.h"
+#include <algorithm>
+
+JobSystem& JobSystem::Get() {
+	static JobSystem jobSystem;
+	return jobSystem;
+}
+
+JobSystem::JobSystem() : job(nullptr), count(0), chunkSize(1), nextChunk(0), chunksLeft(0), generation(0), activeWorkers(0), quit(false), busyMicroseconds(0) {
+	unsigned int cores = std::thread::hardware_concurrency();
+	unsigned int numWorkers = cores > 1 ? cores - 1 : 0; // the main thread is the last core
+	for (unsigned int worker = 0; worker < numWorkers; worker++) {
+		workers.emplace_back(&JobSystem::WorkerLoop, this, worker + 1);
+	}
+	lastUtilization = std::chrono::steady_clock::now();
+}
+
+JobSystem::~JobSystem() {
+	Shutdown();
+}
+
+void JobSystem::Shutdown() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	wake.notify_all();
+	for (std::thread& worker : workers) {
+		if (worker.joinable()) {
+			worker.join();
+		}
+	}
+	workers.clear();
+}
+
+void JobSystem::ParallelFor(unsigned int numItems, unsigned int itemsPerChunk, const Job& loopJob) {
+	if (numItems == 0) {
+		return;
+	}
+	itemsPerChunk = std::max(1u, itemsPerChunk);
+	unsigned int numChunks = (numItems + itemsPerChunk - 1) / itemsPerChunk;
+	if (workers.empty() || numChunks == 1) { // not worth waking anyone
+		loopJob(0, numItems, 0);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		job = &loopJob;
+		count = numItems;
+		chunkSize = itemsPerChunk;
+		nextChunk = 0;
+		chunksLeft = numChunks;
+		generation++;
+	}
+	wake.notify_all();
+
+	RunChunks(0);
+
+	// wait for the last chunk and for every worker to leave RunChunks, otherwise a slow worker could grab a chunk of the next loop
+	std::unique_lock<std::mutex> lock(mutex);
+	done.wait(lock, [this] { return chunksLeft == 0 && activeWorkers == 0; });
+	job = nullptr;
+}
+
+void JobSystem::RunChunks(unsigned int thread) {
+	while (true) {
+		unsigned int chunk = nextChunk++;
+		unsigned int begin = chunk * chunkSize;
+		if (begin >= count) {
+			return;
+		}
+		unsigned int end = std::min(count, begin + chunkSize);
+
+		auto start = std::chrono::steady_clock::now();
+		(*job)(begin, end, thread);
+		if (thread != 0) { // only worker time counts towards utilization
+			busyMicroseconds += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		if (--chunksLeft == 0) {
+			std::lock_guard<std::mutex> lock(mutex); // taking the lock makes sure the caller is either waiting or hasn't checked yet
+			done.notify_one();
+		}
+	}
+}
+
+void JobSystem::WorkerLoop(unsigned int thread) {
+	unsigned int seenGeneration = 0;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [&] { return quit || (generation != seenGeneration && job != nullptr); });
+			if (quit) {
+				return;
+			}
+			seenGeneration = generation;
+			activeWorkers++;
+		}
+		RunChunks(thread);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			activeWorkers--;
+		}
+		done.notify_one();
+	}
+}
+
+double JobSystem::Utilization() {
+	auto now = std::chrono::steady_clock::now();
+	double elapsed = (double)std::chrono::duration_cast<std::chrono::microseconds>(now - lastUtilization).count();
+	lastUtilization = now;
+	long long busy = busyMicroseconds.exchange(0);
+	if (workers.empty() || elapsed <= 0.0) {
+		return 0.0;
+	}
+	return busy / (elapsed * workers.size());
+}
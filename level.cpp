@@ -0,0 +1,158 @@
+#include "level.h"
+#include "scene.h"
+#include "profiler.h"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+static uint64_t AlignOffset(uint64_t offset) {
+	return (offset + 15) & ~(uint64_t)15; // every section starts 16 byte aligned so the mapped arrays can be used in place
+}
+
+bool LevelFile::Open(const std::string& path) {
+	Close();
+	if (!file.Open(path)) {
+		return false;
+	}
+
+	// Validate //
+	// a truncated or foreign file must not send the pointers below off the end of the mapping
+	const unsigned char* base = file.Data();
+	size_t size = file.Size();
+	const LevelHeader* candidate = (const LevelHeader*)base;
+	auto fits = [size](uint64_t offset, uint64_t bytes) { return offset <= size && bytes <= size - offset; };
+	if (size < sizeof(LevelHeader) || std::memcmp(candidate->magic, "LVL", 4) != 0) {
+		std::cout << "Error: " << path << " isn't a level file" << std::endl;
+		Close();
+		return false;
+	}
+	if (candidate->version != version || candidate->transformSize != sizeof(TransformComponent) || candidate->renderSize != sizeof(RenderComponent)) {
+		std::cout << "Error: " << path << " was saved by a different version (" << candidate->version << ")" << std::endl;
+		Close();
+		return false;
+	}
+	if (candidate->fileSize != size
+		|| !fits(candidate->transformsOffset, (uint64_t)candidate->objectCount * sizeof(TransformComponent))
+		|| !fits(candidate->rendersOffset, (uint64_t)candidate->objectCount * sizeof(RenderComponent))
+		|| !fits(candidate->modelsOffset, (uint64_t)candidate->modelCount * sizeof(uint32_t))) {
+		std::cout << "Error: " << path << " is truncated or corrupt" << std::endl;
+		Close();
+		return false;
+	}
+	const uint32_t* names = (const uint32_t*)(base + candidate->modelsOffset);
+	for (uint32_t model = 0; model < candidate->modelCount; model++) {
+		if (names[model] >= size || !std::memchr(base + names[model], 0, size - names[model])) {
+			std::cout << "Error: " << path << " has a broken model table" << std::endl;
+			Close();
+			return false;
+		}
+	}
+	// Validate //
+
+	// Fix Up //
+	header = candidate;
+	transforms = (const TransformComponent*)(base + header->transformsOffset);
+	renders = (const RenderComponent*)(base + header->rendersOffset);
+	modelNames = names;
+	// Fix Up //
+	return true;
+}
+
+void LevelFile::Close() {
+	file.Close();
+	header = nullptr;
+	transforms = nullptr;
+	renders = nullptr;
+	modelNames = nullptr;
+}
+
+bool LevelFile::Save(const Scene& scene, const std::string& path) {
+	ScopedTimer timer("level.save");
+
+	// Layout //
+	LevelHeader header;
+	std::memset(&header, 0, sizeof(header)); // padding included, so saving the same level twice gives the same bytes
+	std::memcpy(header.magic, "LVL", 4);
+	header.version = version;
+	header.transformSize = sizeof(TransformComponent);
+	header.renderSize = sizeof(RenderComponent);
+	header.objectCount = scene.Size();
+	header.modelCount = (uint32_t)scene.models.size();
+	header.transformsOffset = AlignOffset(sizeof(LevelHeader));
+	header.rendersOffset = AlignOffset(header.transformsOffset + (uint64_t)header.objectCount * sizeof(TransformComponent));
+	header.modelsOffset = AlignOffset(header.rendersOffset + (uint64_t)header.objectCount * sizeof(RenderComponent));
+
+	std::vector<uint32_t> names(header.modelCount);
+	uint64_t nameOffset = header.modelsOffset + (uint64_t)header.modelCount * sizeof(uint32_t);
+	for (uint32_t model = 0; model < header.modelCount; model++) {
+		names[model] = (uint32_t)nameOffset;
+		nameOffset += scene.models[model]->name.size() + 1;
+	}
+	header.fileSize = nameOffset;
+	// Layout //
+
+	// Write //
+	// built in memory and written in one go, so a crash or a full disk never leaves a half written level behind
+	std::vector<unsigned char> bytes((size_t)header.fileSize, 0); // zeros are the padding between sections
+	std::memcpy(bytes.data(), &header, sizeof(header));
+	std::memcpy(bytes.data() + header.transformsOffset, scene.transforms.data(), header.objectCount * sizeof(TransformComponent));
+	std::memcpy(bytes.data() + header.rendersOffset, scene.renders.data(), header.objectCount * sizeof(RenderComponent));
+	std::memcpy(bytes.data() + header.modelsOffset, names.data(), names.size() * sizeof(uint32_t));
+	for (uint32_t model = 0; model < header.modelCount; model++) {
+		const std::string& name = scene.models[model]->name;
+		std::memcpy(bytes.data() + names[model], name.c_str(), name.size() + 1);
+	}
+	if (!WriteFileAtomic(path, bytes)) {
+		std::cout << "Error: couldn't write " << path << std::endl;
+		return false;
+	}
+	// Write //
+	return true;
+}
+
+bool LevelFile::Load(Scene& scene, const std::string& path) {
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	LevelFile level;
+	if (!level.Open(path)) {
+		return false;
+	}
+
+	// the file's model table becomes indices into the scene's models, already loaded files aren't loaded again
+	std::vector<unsigned int> models(level.ModelCount());
+	for (unsigned int model = 0; model < level.ModelCount(); model++) {
+		models[model] = scene.LoadModel(level.ModelName(model));
+	}
+	if (!scene.Assign(level.Transforms(), level.Renders(), level.ObjectCount(), models)) {
+		std::cout << "Error: " << path << " uses a model it doesn't list" << std::endl;
+		return false;
+	}
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	std::cout << "Loaded " << level.ObjectCount() << " objects from " << path << " in " << elapsed.count() << " ms" << std::endl;
+	return true;
+}
+
+bool LevelFile::ExportText(const Scene& scene, const std::string& path) {
+	std::ostringstream out;
+	out.precision(9); // enough digits that every float reads back exactly
+	out << "# level: " << scene.models.size() << " models, " << scene.Size() << " objects\n";
+	for (unsigned int model = 0; model < scene.models.size(); model++) {
+		out << "model " << model << " " << scene.models[model]->name << "\n";
+	}
+	for (GameObject object = 0; object < scene.Size(); object++) {
+		const TransformComponent& transform = scene.transforms[object];
+		const RenderComponent& render = scene.renders[object];
+		out << "object " << object << " model " << render.model << " flags " << render.flags
+			<< " position " << transform.position.x << " " << transform.position.y << " " << transform.position.z
+			<< " rotation " << transform.rotation.x << " " << transform.rotation.y << " " << transform.rotation.z
+			<< " scale " << transform.scale.x << " " << transform.scale.y << " " << transform.scale.z << "\n";
+	}
+	std::string text = out.str();
+	if (!WriteFileAtomic(path, std::vector<unsigned char>(text.begin(), text.end()))) {
+		std::cout << "Error: couldn't write " << path << std::endl;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,157 @@
+#include "mappedfile.h"
+#include <cstdio>
+#include <iostream>
+#include <utility>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+	*this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+	if (this != &other) {
+		Close();
+		std::swap(data, other.data);
+		std::swap(size, other.size);
+#ifdef _WIN32
+		std::swap(file, other.file);
+		std::swap(mapping, other.mapping);
+#endif
+	}
+	return *this;
+}
+
+#ifdef _WIN32
+bool MappedFile::Open(const std::string& path) {
+	Close();
+	file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		file = nullptr;
+		std::cout << "Error: couldn't open " << path << std::endl;
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+		std::cout << "Error: " << path << " is empty" << std::endl;
+		Close();
+		return false;
+	}
+	mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (!view) {
+		std::cout << "Error: couldn't map " << path << std::endl;
+		Close();
+		return false;
+	}
+	data = (const unsigned char*)view;
+	size = (size_t)fileSize.QuadPart;
+	return true;
+}
+
+void MappedFile::Close() {
+	if (data) {
+		UnmapViewOfFile(data);
+	}
+	if (mapping) {
+		CloseHandle(mapping);
+	}
+	if (file) {
+		CloseHandle(file);
+	}
+	data = nullptr;
+	size = 0;
+	mapping = nullptr;
+	file = nullptr;
+}
+#else
+bool MappedFile::Open(const std::string& path) {
+	Close();
+	int descriptor = open(path.c_str(), O_RDONLY);
+	if (descriptor < 0) {
+		std::cout << "Error: couldn't open " << path << std::endl;
+		return false;
+	}
+	struct stat info;
+	if (fstat(descriptor, &info) != 0 || info.st_size == 0) {
+		std::cout << "Error: " << path << " is empty" << std::endl;
+		close(descriptor);
+		return false;
+	}
+	void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+	close(descriptor); // the mapping keeps the file alive by itself
+	if (view == MAP_FAILED) {
+		std::cout << "Error: couldn't map " << path << std::endl;
+		return false;
+	}
+	data = (const unsigned char*)view;
+	size = (size_t)info.st_size;
+	return true;
+}
+
+void MappedFile::Close() {
+	if (data) {
+		munmap((void*)data, size);
+	}
+	data = nullptr;
+	size = 0;
+}
+#endif
+
+// Atomic Write //
+#ifdef _WIN32
+bool WriteFileAtomic(const std::string& path, const std::vector<unsigned char>& bytes) {
+	std::string temporary = path + ".tmp";
+	HANDLE file = CreateFileA(temporary.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	DWORD written = 0;
+	bool ok = WriteFile(file, bytes.data(), (DWORD)bytes.size(), &written, NULL) && written == bytes.size();
+	ok = ok && FlushFileBuffers(file);
+	CloseHandle(file);
+	if (!ok || !MoveFileExA(temporary.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+		std::remove(temporary.c_str()); // the old file is untouched, don't leave half of the new one lying around
+		return false;
+	}
+	return true;
+}
+#else
+bool WriteFileAtomic(const std::string& path, const std::vector<unsigned char>& bytes) {
+	std::string temporary = path + ".tmp";
+	int file = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (file < 0) {
+		return false;
+	}
+	bool ok = true;
+	size_t done = 0;
+	while (ok && done < bytes.size()) {
+		ssize_t written = write(file, bytes.data() + done, bytes.size() - done);
+		ok = written > 0;
+		done += ok ? (size_t)written : 0;
+	}
+	ok = ok && fsync(file) == 0;
+	close(file);
+	if (!ok || rename(temporary.c_str(), path.c_str()) != 0) {
+		std::remove(temporary.c_str()); // the old file is untouched, don't leave half of the new one lying around
+		return false;
+	}
+	// the rename itself lives in the directory, flush that too so it can't be lost after we've reported success
+	size_t slash = path.find_last_of('/');
+	int directory = open(slash == std::string::npos ? "." : path.substr(0, slash).c_str(), O_RDONLY);
+	if (directory >= 0) {
+		fsync(directory);
+		close(directory);
+	}
+	return true;
+}
+#endif
+// Atomic Write //
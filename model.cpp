@@ -1,40 +1,47 @@
 #include "model.h"
 
-Model::Model(const std::string& file) {
+Model::Model(const std::string& file) : name(file), numVertices(0), numFaces(0), numMeshes(0) {
 	Assimp::Importer importer;
 	const aiScene* scene = importer.ReadFile(file,
 		aiProcess_Triangulate | // post-processing
 		aiProcess_FlipUVs     );
 
-	numMeshes = scene->mNumMeshes;
-	meshIndices = new unsigned int[numMeshes]; // MEMORY LEAK :D
-	VAOs = new unsigned int[numMeshes];
-	transforms = new glm::mat4[numMeshes];
-
 	// ProcessNodes(scene->mRootNode); // error: doesn't return
 
 	if (!scene) {
 		std::cout << importer.GetErrorString();
+		return;
 	}
 
+	numMeshes = scene->mNumMeshes;
+	meshIndices.resize(numMeshes); // vectors of handles free everything on their own when the model goes away
+	VAOs.resize(numMeshes);
+	VBOs.resize(numMeshes);
+	EBOs.resize(numMeshes);
+	transforms.resize(numMeshes, glm::mat4(1.0f)); // meshes with no node of their own stay where they are
+	cpuPositions.resize(numMeshes);
+	cpuIndices.resize(numMeshes);
+	meshBounds.resize(numMeshes);
+	meshSpheres.resize(numMeshes);
+	meshVisible.resize(numMeshes, 1);
+
 	for (unsigned int mesh = 0; mesh < (scene->mNumMeshes); mesh++) {
 		ProcessMesh(scene, mesh);
+		cullBounds.Add(meshBounds[mesh], meshSpheres[mesh]);
+		bounds.Expand(meshBounds[mesh]);
 	}
 }
 
 void Model::ProcessMesh(const aiScene* scene, unsigned int meshNum) { // returns the code to a VAO
 	// generate and bind the vertex array
-	unsigned int VAO;
-	glGenVertexArrays(1, &VAO);
-	glBindVertexArray(VAO);
+	GLVertexArray VAO = GLVertexArray::Create(name);
+	glBindVertexArray(VAO.ID());
 	// generate and bind the vertex buffer
-	unsigned int VBO;
-	glGenBuffers(1, &VBO);
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	GLBuffer VBO = GLBuffer::Create(name);
+	glBindBuffer(GL_ARRAY_BUFFER, VBO.ID());
 	// generate and bind the element buffer
-	unsigned int EBO;
-	glGenBuffers(1, &EBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	GLBuffer EBO = GLBuffer::Create(name);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO.ID());
 
 	// |position          | |normal            | |texCoords|
     // -0.5f, -0.5f, -0.5f, -0.5f, -0.5f, -0.5f, 0.0f, 0.0f,
@@ -64,6 +71,25 @@ void Model::ProcessMesh(const aiScene* scene, unsigned int meshNum) { // returns
 		vertices[vertex * vertexSize + textureOffset + 1] = (scene->mMeshes[meshNum]->mTextureCoords[0][vertex].y);
 	}
 
+	// CPU Copy //
+	cpuPositions[meshNum].resize(numVertices);
+	for (unsigned int vertex = 0; vertex < numVertices; vertex++) {
+		cpuPositions[meshNum][vertex] = glm::vec3(vertices[vertex * vertexSize + positionOffset], vertices[vertex * vertexSize + positionOffset + 1], vertices[vertex * vertexSize + positionOffset + 2]);
+	}
+	// CPU Copy //
+
+	// Bounds //
+	// box around the raw vertices, and a sphere around the box's center that reaches the furthest vertex
+	AABB localBounds;
+	for (const glm::vec3& position : cpuPositions[meshNum]) {
+		localBounds.Expand(position);
+	}
+	BoundingSphere localSphere(localBounds.Center(), 0.0f);
+	for (const glm::vec3& position : cpuPositions[meshNum]) {
+		localSphere.radius = std::max(localSphere.radius, glm::length(position - localSphere.center));
+	}
+	// Bounds //
+
 	// Initializing Indices // 
 	for (unsigned int face = 0; face < scene->mMeshes[meshNum]->mNumFaces; face++) {
 		indices[face * 3 + 0] = (scene->mMeshes[meshNum]->mFaces[face].mIndices[0]);
@@ -71,6 +97,7 @@ void Model::ProcessMesh(const aiScene* scene, unsigned int meshNum) { // returns
 		indices[face * 3 + 2] = (scene->mMeshes[meshNum]->mFaces[face].mIndices[2]);
 	}
 	// Initializing Indices // 
+	cpuIndices[meshNum].assign(indices, indices + numIndices);
 
 	std::cout << std::endl;
 
@@ -87,16 +114,21 @@ void Model::ProcessMesh(const aiScene* scene, unsigned int meshNum) { // returns
 	glEnableVertexAttribArray(2);
 
 	// load vertex and index data
-	glBufferData(GL_ARRAY_BUFFER, verticesSize*sizeof(float), vertices, GL_STATIC_DRAW);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, numIndices*sizeof(unsigned int), indices, GL_STATIC_DRAW);
+	BufferData(GL_ARRAY_BUFFER, VBO, verticesSize*sizeof(float), vertices, GL_STATIC_DRAW);
+	BufferData(GL_ELEMENT_ARRAY_BUFFER, EBO, numIndices*sizeof(unsigned int), indices, GL_STATIC_DRAW);
+	glBindVertexArray(0); // unbind so nothing else accidentally records into this VAO
 	std::cout << std::endl; 
 
-	// store mesh indices, VAO
+	// store mesh indices, VAO and the buffers it reads from (the VAO doesn't keep them alive on its own)
 	meshIndices[meshNum] = numIndices;
-	VAOs[meshNum] = VAO;
+	VAOs[meshNum] = std::move(VAO);
+	VBOs[meshNum] = std::move(VBO);
+	EBOs[meshNum] = std::move(EBO);
 	// store transform associated with this mesh
 	bool found = false;
 	FindMeshTransform(scene->mMeshes[meshNum]->mName, scene->mRootNode, meshNum, found);
+	meshBounds[meshNum] = localBounds.Transformed(transforms[meshNum]);
+	meshSpheres[meshNum] = localSphere.Transformed(transforms[meshNum]);
 
 	delete[] vertices; // free memory after use
 	delete[] indices;
@@ -131,11 +163,66 @@ void Model::FindMeshTransform(aiString meshNode, aiNode* node, unsigned int mesh
 	}
 }
 
-void Model::Draw(Shader shader) {
+void Model::Unload() {
+	meshIndices.clear();
+	VAOs.clear(); // destroying the handles deletes the GL objects
+	VBOs.clear();
+	EBOs.clear();
+	transforms.clear();
+	cpuPositions.clear();
+	cpuIndices.clear();
+	meshBounds.clear();
+	meshSpheres.clear();
+	cullBounds.Clear();
+	meshVisible.clear();
+	bounds = AABB();
+	numMeshes = 0;
+}
+
+void MeshCounts::Report() const {
+	Profiler::Get().AddCounter("culling.tested", tested);
+	Profiler::Get().AddCounter("culling.culled", culled);
+	Profiler::Get().AddCounter("draw.calls", drawCalls);
+	Profiler::Get().AddCounter("draw.triangles", triangles);
+}
+
+void Model::CullMeshes(const Frustum* frustum, MeshCounts& counts) {
+	if (frustum) {
+		unsigned int numVisible = cullBounds.Cull(*frustum, meshVisible.data());
+		counts.tested += numMeshes;
+		counts.culled += numMeshes - numVisible;
+	}
+	else {
+		std::fill(meshVisible.begin(), meshVisible.end(), 1);
+	}
+}
+
+void Model::Draw(const Shader& shader, MeshCounts& counts, const glm::mat4& objectMatrix, const Frustum* frustum) {
+	CullMeshes(frustum, counts);
+
+	int modelLoc = glGetUniformLocation(shader.ID(), "model");
 	for (unsigned int mesh = 0; mesh < numMeshes; mesh++) {
-		glBindVertexArray(VAOs[mesh]);
-		int modelLoc = glGetUniformLocation(shader.ID, "model");
-		glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(transforms[mesh]));
+		if (!meshVisible[mesh]) {
+			continue;
+		}
+		glBindVertexArray(VAOs[mesh].ID());
+		glm::mat4 meshMatrix = objectMatrix * transforms[mesh];
+		glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(meshMatrix));
 		glDrawElements(GL_TRIANGLES, meshIndices[mesh], GL_UNSIGNED_INT, 0);
+		counts.drawCalls++;
+		counts.triangles += meshIndices[mesh] / 3;
+	}
+}
+
+void Model::Queue(RenderQueue& queue, const Shader& shader, MeshCounts& counts, const glm::mat4& objectMatrix, const glm::mat4& viewProjection, const Frustum* frustum, bool translucent) {
+	CullMeshes(frustum, counts);
+
+	glm::mat4 objectViewProjection = viewProjection * objectMatrix;
+	for (unsigned int mesh = 0; mesh < numMeshes; mesh++) {
+		if (!meshVisible[mesh]) {
+			continue;
+		}
+		float depth = (objectViewProjection * glm::vec4(meshBounds[mesh].Center(), 1.0f)).w; // clip w is the distance along the view direction
+		queue.Add({ shader.ID(), 0, VAOs[mesh].ID(), meshIndices[mesh], objectMatrix * transforms[mesh] }, depth, translucent);
 	}
 }
\ No newline at end of file
@@ -0,0 +1,225 @@
+#include "occlusion.h"
+#include "scene.h"
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cmath>
+
+HiZOcclusion::HiZOcclusion(unsigned int w, unsigned int h) :
+	depthShader("assets/shaders/depth.vert", "assets/shaders/depth.frag"),
+	downsampleShader("assets/shaders/fullscreen.vert", "assets/shaders/hiz.frag"),
+	nextReadback(0), width(w), height(h), levels(0), readbackLevel(0), readbackWidth(w), readbackHeight(h), hizValid(false) {
+
+	// Depth Pyramid //
+	depthTexture = GLTexture::Create("hi-z occlusion");
+	glBindTexture(GL_TEXTURE_2D, depthTexture.ID());
+	size_t bytes = 0;
+	unsigned int levelWidth = width;
+	unsigned int levelHeight = height;
+	while (true) {
+		glTexImage2D(GL_TEXTURE_2D, levels, GL_DEPTH_COMPONENT32F, levelWidth, levelHeight, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+		bytes += levelWidth * levelHeight * sizeof(float);
+		if (levelWidth > 64 && readbackLevel == levels) { // keep stepping the readback level down until it is small
+			readbackLevel = levels + 1;
+			readbackWidth = std::max(1u, levelWidth / 2);
+			readbackHeight = std::max(1u, levelHeight / 2);
+		}
+		levels++;
+		if (levelWidth == 1 && levelHeight == 1) {
+			break;
+		}
+		levelWidth = std::max(1u, levelWidth / 2);
+		levelHeight = std::max(1u, levelHeight / 2);
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST); // max reduction has to be done by hand, never filter
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	GPUResourceRegistry::Get().SetBytes(GPUResourceType::Texture, depthTexture.ID(), bytes);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	// Depth Pyramid //
+
+	framebuffer = GLFramebuffer::Create("hi-z occlusion");
+	emptyVAO = GLVertexArray::Create("hi-z occlusion");
+
+	// Readback Buffers //
+	for (unsigned int readback = 0; readback < numReadbacks; readback++) {
+		readbackBuffers[readback] = GLBuffer::Create("hi-z occlusion");
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, readbackBuffers[readback].ID());
+		BufferData(GL_PIXEL_PACK_BUFFER, readbackBuffers[readback], readbackWidth * readbackHeight * sizeof(float), NULL, GL_STREAM_READ);
+		readbackFences[readback] = 0;
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	hizDepth.resize(readbackWidth * readbackHeight);
+	// Readback Buffers //
+}
+
+void HiZOcclusion::Unload() {
+	for (unsigned int readback = 0; readback < numReadbacks; readback++) {
+		if (readbackFences[readback]) {
+			glDeleteSync(readbackFences[readback]);
+			readbackFences[readback] = 0;
+		}
+		readbackBuffers[readback].Reset();
+	}
+	depthTexture.Reset();
+	framebuffer.Reset();
+	emptyVAO.Reset();
+	depthShader.Unload();
+	downsampleShader.Unload();
+	hizValid = false;
+}
+
+void HiZOcclusion::Prepare(const Scene& scene, const glm::mat4& viewProjection) {
+	FinishReadback();
+	Render(scene, viewProjection);
+	StartReadback(viewProjection);
+}
+
+void HiZOcclusion::Render(const Scene& scene, const glm::mat4& viewProjection) {
+	// everything here draws into our own framebuffer, so put the caller's viewport back afterwards
+	int viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+
+	RenderOccluders(scene, viewProjection);
+	BuildPyramid();
+	pyramidViewProjection = viewProjection;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+void HiZOcclusion::RenderOccluders(const Scene& scene, const glm::mat4& viewProjection) {
+	ScopedTimer timer("occlusion.prepass");
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.ID());
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture.ID(), 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	glViewport(0, 0, width, height);
+	glEnable(GL_DEPTH_TEST); // depth is only written while the test is on, which the pyramid build relies on too
+	glDepthMask(GL_TRUE);
+	glClear(GL_DEPTH_BUFFER_BIT);
+
+	glUseProgram(depthShader.ID());
+	glUniformMatrix4fv(glGetUniformLocation(depthShader.ID(), "viewProjection"), 1, GL_FALSE, glm::value_ptr(viewProjection));
+	unsigned int numOccluders = 0;
+	MeshCounts counts;
+	for (GameObject object = 0; object < scene.Size(); object++) {
+		if (scene.renders[object].flags & RENDER_OCCLUDER) {
+			scene.models[scene.renders[object].model]->Draw(depthShader, counts, scene.worldMatrices[object]);
+			numOccluders++;
+		}
+	}
+	counts.Report();
+	Profiler::Get().AddCounter("occlusion.occluders", numOccluders);
+}
+
+void HiZOcclusion::BuildPyramid() {
+	ScopedTimer timer("occlusion.pyramid");
+	glUseProgram(downsampleShader.ID());
+	glUniform1i(glGetUniformLocation(downsampleShader.ID(), "previousLevel"), 0);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, depthTexture.ID());
+	glBindVertexArray(emptyVAO.ID());
+	glDepthFunc(GL_ALWAYS); // every texel gets overwritten
+
+	unsigned int levelWidth = width;
+	unsigned int levelHeight = height;
+	for (unsigned int level = 1; level < levels; level++) {
+		levelWidth = std::max(1u, levelWidth / 2);
+		levelHeight = std::max(1u, levelHeight / 2);
+		// only the level being read is visible to the shader, which keeps the level being written out of any feedback loop.
+		// texelFetch counts its lod from the base level, so the shader always reads lod 0
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level - 1);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level - 1);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture.ID(), level);
+		glViewport(0, 0, levelWidth, levelHeight);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+	}
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glDepthFunc(GL_LESS);
+}
+
+void HiZOcclusion::StartReadback(const glm::mat4& viewProjection) {
+	if (readbackFences[nextReadback]) {
+		return; // all copies are still in flight, skip this frame rather than wait
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.ID());
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture.ID(), readbackLevel);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readbackBuffers[nextReadback].ID());
+	glReadPixels(0, 0, readbackWidth, readbackHeight, GL_DEPTH_COMPONENT, GL_FLOAT, 0); // goes into the buffer, returns straight away
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	readbackFences[nextReadback] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	readbackViewProjection[nextReadback] = viewProjection;
+	nextReadback = (nextReadback + 1) % numReadbacks;
+}
+
+void HiZOcclusion::FinishReadback() {
+	// readbacks finish in the order they were started, so walk forward from the oldest and keep the newest that's done
+	for (unsigned int i = 0; i < numReadbacks; i++) {
+		unsigned int readback = (nextReadback + i) % numReadbacks;
+		if (!readbackFences[readback]) {
+			continue;
+		}
+		if (glClientWaitSync(readbackFences[readback], 0, 0) == GL_TIMEOUT_EXPIRED) { // timeout of 0 only polls
+			break;
+		}
+		glDeleteSync(readbackFences[readback]);
+		readbackFences[readback] = 0;
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, readbackBuffers[readback].ID());
+		void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, hizDepth.size() * sizeof(float), GL_MAP_READ_BIT);
+		if (data) {
+			std::copy((const float*)data, (const float*)data + hizDepth.size(), hizDepth.begin());
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+			hizViewProjection = readbackViewProjection[readback];
+			hizValid = true;
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	}
+}
+
+bool HiZOcclusion::IsOccluded(const AABB& box) const {
+	if (!hizValid) {
+		return false;
+	}
+
+	// Project Box //
+	// screen rectangle and nearest depth of the box as seen by the camera the pyramid was drawn with
+	glm::vec3 minimum(FLT_MAX);
+	glm::vec3 maximum(-FLT_MAX);
+	for (int corner = 0; corner < 8; corner++) {
+		glm::vec4 position((corner & 1) ? box.max.x : box.min.x, (corner & 2) ? box.max.y : box.min.y, (corner & 4) ? box.max.z : box.min.z, 1.0f);
+		glm::vec4 clip = hizViewProjection * position;
+		if (clip.w <= 1e-5f) {
+			return false; // reaches behind the camera, can't say anything useful
+		}
+		glm::vec3 ndc = glm::vec3(clip) / clip.w;
+		minimum = glm::min(minimum, ndc);
+		maximum = glm::max(maximum, ndc);
+	}
+	if (maximum.x < -1.0f || minimum.x > 1.0f || maximum.y < -1.0f || minimum.y > 1.0f) {
+		return false; // off screen for that old camera, the frustum test already decided it's on screen now
+	}
+	// Project Box //
+
+	int x0 = std::max(0, (int)std::floor((minimum.x * 0.5f + 0.5f) * readbackWidth));
+	int x1 = std::min((int)readbackWidth - 1, (int)std::floor((maximum.x * 0.5f + 0.5f) * readbackWidth));
+	int y0 = std::max(0, (int)std::floor((minimum.y * 0.5f + 0.5f) * readbackHeight));
+	int y1 = std::min((int)readbackHeight - 1, (int)std::floor((maximum.y * 0.5f + 0.5f) * readbackHeight));
+	float nearestDepth = minimum.z * 0.5f + 0.5f; // ndc to the 0..1 range stored in the depth buffer
+
+	for (int y = y0; y <= y1; y++) {
+		for (int x = x0; x <= x1; x++) {
+			if (nearestDepth <= hizDepth[y * readbackWidth + x]) {
+				return false; // some part of the box could be in front of whatever is drawn here
+			}
+		}
+	}
+	return true;
+}
@@ -0,0 +1,150 @@
+#include "perfhud.h"
+#include "glstats.h"
+#include "gpuresource.h"
+#include "jobsystem.h"
+#include "profiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+	const float budgetMs = 1000.0f / 60.0f; // the line across each graph
+	const float graphTopMs = 1000.0f / 30.0f; // anything slower reaches the top
+
+	// 1234567 -> "1.23M", counts are easier to compare at a glance when they're this short
+	std::string Short(long long value) {
+		char text[32];
+		if (value >= 1000000) {
+			std::snprintf(text, sizeof(text), "%.2fM", value / 1000000.0);
+		}
+		else if (value >= 10000) {
+			std::snprintf(text, sizeof(text), "%.1fK", value / 1000.0);
+		}
+		else {
+			std::snprintf(text, sizeof(text), "%lld", value);
+		}
+		return text;
+	}
+}
+
+PerfHUD::PerfHUD() {
+	std::fill(cpuHistory, cpuHistory + historyLength, 0.0f);
+	std::fill(gpuHistory, gpuHistory + historyLength, 0.0f);
+}
+
+void PerfHUD::Record() {
+	Profiler& profiler = Profiler::Get();
+	cpuHistory[historyNext] = (float)profiler.FrameTime();
+	// GPU times arrive a few frames late and not always one per frame, a frame without one repeats the last
+	double gpu = profiler.Time("gpu.frame");
+	if (gpu > 0.0) {
+		gpuKnown = true;
+	}
+	int previous = (historyNext + historyLength - 1) % historyLength;
+	gpuHistory[historyNext] = gpu > 0.0 ? (float)gpu : gpuHistory[previous];
+	historyNext = (historyNext + 1) % historyLength;
+	jobUtilization = JobSystem::Get().Utilization();
+}
+
+void PerfHUD::Draw(UIContext& ui, const glm::vec2& screenSize) {
+	if (!visible) {
+		return;
+	}
+	Profiler& profiler = Profiler::Get();
+	char text[160];
+
+	// Lines //
+	// worked out before anything is drawn, the background goes under them and has to know how tall they are
+	auto summary = [&](const char* name, const float* history) {
+		float total = 0.0f;
+		float worst = 0.0f;
+		for (int frame = 0; frame < historyLength; frame++) {
+			total += history[frame];
+			worst = std::max(worst, history[frame]);
+		}
+		float latest = history[(historyNext + historyLength - 1) % historyLength];
+		std::snprintf(text, sizeof(text), "%s %.2f ms   avg %.2f   max %.2f", name, latest, total / historyLength, worst);
+		return std::string(text);
+	};
+	std::string cpuLine = summary("CPU", cpuHistory);
+	std::string gpuLine = gpuKnown ? summary("GPU", gpuHistory) : "GPU  no timings back yet";
+
+	std::vector<std::string> lines;
+	std::snprintf(text, sizeof(text), "render thread %.2f ms   swap %.2f ms   waited %.2f ms",
+		profiler.Time("render.thread"), profiler.Time("render.swap"), profiler.Time("render.wait"));
+	lines.push_back(text);
+	long long gpuDriven = profiler.Counter("draw.gpuDriven");
+	std::snprintf(text, sizeof(text), "draws %lld   triangles %s%s", profiler.Counter("draw.calls"), Short(profiler.Counter("draw.triangles")).c_str(),
+		gpuDriven > 0 ? " + unknown (GPU culled)" : "");
+	lines.push_back(text);
+	if (GLStats::Available()) {
+		std::snprintf(text, sizeof(text), "GL calls %s   in the driver %.2f ms", Short(profiler.Counter("gl.calls")).c_str(), profiler.Time("gl.driver"));
+		lines.push_back(text);
+	}
+	std::snprintf(text, sizeof(text), "state changes   programs %lld   textures %lld   vaos %lld",
+		profiler.Counter("state.programs"), profiler.Counter("state.textures"), profiler.Counter("state.vaos"));
+	lines.push_back(text);
+	const double megabyte = 1024.0 * 1024.0;
+	GPUResourceRegistry& registry = GPUResourceRegistry::Get();
+	std::snprintf(text, sizeof(text), "GPU memory %.1f MB (buffers %.1f, textures %.1f), ours only",
+		registry.TotalBytes() / megabyte, registry.TotalBytes(GPUResourceType::Buffer) / megabyte, registry.TotalBytes(GPUResourceType::Texture) / megabyte);
+	lines.push_back(text);
+	std::snprintf(text, sizeof(text), "jobs %.0f%% busy over %u workers", jobUtilization * 100.0, JobSystem::Get().NumThreads() - 1);
+	lines.push_back(text);
+	std::snprintf(text, sizeof(text), "uploads %lld KB/s   streaming: none, assets load at startup", profiler.Counter("stream.kbPerSecond"));
+	lines.push_back(text);
+	std::snprintf(text, sizeof(text), "sim %lld ticks, %lld dropped   input %lld events", profiler.Counter("sim.ticks"),
+		profiler.Counter("sim.droppedTicks"), profiler.Counter("input.events"));
+	lines.push_back(text);
+	// Lines //
+
+	// Layout //
+	const float width = 380.0f;
+	const float margin = 10.0f;
+	const float padding = 6.0f;
+	const float lineHeight = 16.0f;
+	const float textSize = 13.0f;
+	const float graphHeight = 40.0f;
+	glm::vec2 origin(screenSize.x - width - margin, margin);
+	float height = padding * 2.0f + (lineHeight + graphHeight + padding) * 2.0f + lineHeight * lines.size();
+	ui.Rect(origin, origin + glm::vec2(width, height), UIColor(0.05f, 0.05f, 0.07f, 0.8f));
+	// Layout //
+
+	// Graphs //
+	// a bar per frame, oldest on the left, coloured by whether it made 60 / 30 frames a second
+	const uint32_t fast = UIColor(0.3f, 0.8f, 0.4f);
+	const uint32_t slow = UIColor(0.95f, 0.8f, 0.25f);
+	const uint32_t late = UIColor(0.95f, 0.3f, 0.25f);
+	const uint32_t textColor = UIColor(0.9f, 0.9f, 0.92f);
+	float y = origin.y + padding;
+	auto graph = [&](const std::string& title, const float* history) {
+		ui.Text(title, glm::vec2(origin.x + padding, y), textColor, textSize);
+		y += lineHeight;
+		glm::vec2 minimum(origin.x + padding, y);
+		float graphWidth = width - padding * 2.0f;
+		float barWidth = graphWidth / historyLength;
+		ui.Rect(minimum, minimum + glm::vec2(graphWidth, graphHeight), UIColor(0.15f, 0.15f, 0.18f, 0.8f));
+		for (int bar = 0; bar < historyLength; bar++) {
+			float milliseconds = history[(historyNext + bar) % historyLength];
+			if (milliseconds <= 0.0f) {
+				continue;
+			}
+			float barHeight = std::min(milliseconds / graphTopMs, 1.0f) * graphHeight;
+			float x = minimum.x + bar * barWidth;
+			ui.Rect(glm::vec2(x, minimum.y + graphHeight - barHeight), glm::vec2(x + barWidth, minimum.y + graphHeight),
+				milliseconds <= budgetMs ? fast : milliseconds <= graphTopMs ? slow : late);
+		}
+		float budgetY = minimum.y + graphHeight - budgetMs / graphTopMs * graphHeight;
+		ui.Rect(glm::vec2(minimum.x, budgetY), glm::vec2(minimum.x + graphWidth, budgetY + 1.0f), UIColor(1.0f, 1.0f, 1.0f, 0.4f));
+		y += graphHeight + padding;
+	};
+	graph(cpuLine, cpuHistory);
+	graph(gpuLine, gpuHistory);
+	// Graphs //
+
+	for (const std::string& line : lines) {
+		ui.Text(line, glm::vec2(origin.x + padding, y), textColor, textSize);
+		y += lineHeight;
+	}
+}
@@ -0,0 +1,220 @@
+#include "picking.h"
+#include "scene.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <vector>
+
+ObjectPicker::ObjectPicker(Backend pickBackend) : backend(pickBackend) {
+	for (unsigned int readback = 0; readback < numReadbacks; readback++) {
+		readbackFences[readback] = 0;
+	}
+	if (backend != PICK_GPU) {
+		return;
+	}
+	idShader.reset(new Shader("assets/shaders/depth.vert", "assets/shaders/id.frag"));
+
+	// ID Target //
+	// one pixel is all a pick ever looks at, the projection does the zooming in
+	idTexture = GLTexture::Create("object picking");
+	glBindTexture(GL_TEXTURE_2D, idTexture.ID());
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, 1, 1, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST); // integer textures can't be filtered
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	GPUResourceRegistry::Get().SetBytes(GPUResourceType::Texture, idTexture.ID(), sizeof(unsigned int));
+	depthTexture = GLTexture::Create("object picking");
+	glBindTexture(GL_TEXTURE_2D, depthTexture.ID());
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, 1, 1, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	GPUResourceRegistry::Get().SetBytes(GPUResourceType::Texture, depthTexture.ID(), sizeof(float));
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	framebuffer = GLFramebuffer::Create("object picking");
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.ID());
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, idTexture.ID(), 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture.ID(), 0);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		std::cout << "Error: object picking framebuffer is incomplete, falling back to ray casts" << std::endl;
+		backend = PICK_CPU;
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	// ID Target //
+
+	// Readback Buffers //
+	for (unsigned int readback = 0; readback < numReadbacks; readback++) {
+		readbackBuffers[readback] = GLBuffer::Create("object picking");
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, readbackBuffers[readback].ID());
+		BufferData(GL_PIXEL_PACK_BUFFER, readbackBuffers[readback], sizeof(unsigned int) + sizeof(float), NULL, GL_STREAM_READ);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	// Readback Buffers //
+}
+
+void ObjectPicker::Unload() {
+	for (unsigned int readback = 0; readback < numReadbacks; readback++) {
+		if (readbackFences[readback]) {
+			glDeleteSync(readbackFences[readback]);
+			readbackFences[readback] = 0;
+		}
+		readbackBuffers[readback].Reset();
+	}
+	idTexture.Reset();
+	depthTexture.Reset();
+	framebuffer.Reset();
+	idShader.reset();
+}
+
+PickRequest ObjectPicker::Request(unsigned int id, const glm::mat4& viewProjection, const glm::vec2& ndc, const glm::vec2& pixel) {
+	PickRequest request;
+	request.active = true;
+	request.id = id;
+
+	glm::mat4 inverseViewProjection = glm::inverse(viewProjection);
+	glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndc.x, ndc.y, -1.0f, 1.0f);
+	glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndc.x, ndc.y, 1.0f, 1.0f);
+	request.origin = glm::vec3(nearPoint) / nearPoint.w;
+	glm::vec3 end = glm::vec3(farPoint) / farPoint.w;
+	request.maxDistance = glm::length(end - request.origin);
+	request.direction = (end - request.origin) / request.maxDistance;
+
+	// Pick Matrix //
+	// stretches the pixel at ndc over the whole of clip space (what gluPickMatrix did), so the frustum built from it
+	// only holds what can cover that pixel and a 1x1 target sees exactly what the pixel would have
+	glm::vec2 halfPixel = pixel * 0.5f;
+	glm::mat4 pick = glm::scale(glm::mat4(1.0f), glm::vec3(1.0f / halfPixel.x, 1.0f / halfPixel.y, 1.0f));
+	pick = glm::translate(pick, glm::vec3(-ndc.x, -ndc.y, 0.0f));
+	request.viewProjection = pick * viewProjection;
+	// Pick Matrix //
+	return request;
+}
+
+void ObjectPicker::Process(const Scene& scene, const PickRequest& request) {
+	if (backend == PICK_GPU) {
+		FinishReadbacks();
+	}
+	if (!request.active) {
+		return;
+	}
+	if (backend == PICK_GPU) {
+		RenderIDs(scene, request);
+		return;
+	}
+
+	ScopedTimer timer("pick.rayCast");
+	PickResult result;
+	result.request = request.id;
+	result.object = scene.RayCastMeshes(request.origin, request.direction, request.maxDistance, result.distance);
+	result.position = request.origin + request.direction * result.distance;
+	Post(result);
+}
+
+void ObjectPicker::RenderIDs(const Scene& scene, const PickRequest& request) {
+	if (readbackFences[nextReadback]) {
+		std::cout << "Error: too many picks in flight, click dropped" << std::endl; // takes clicking faster than the GPU finishes frames
+		return;
+	}
+	ScopedTimer timer("pick.render");
+	int viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.ID());
+	glViewport(0, 0, 1, 1);
+	glEnable(GL_DEPTH_TEST);
+	glDepthMask(GL_TRUE);
+	const unsigned int nothing = 0;
+	const float farthest = 1.0f;
+	glClearBufferuiv(GL_COLOR, 0, &nothing);
+	glClearBufferfv(GL_DEPTH, 0, &farthest);
+
+	// Draw IDs //
+	// only what the narrowed frustum holds, everything else can't touch the pixel
+	std::vector<GameObject> candidates;
+	scene.bvh.QueryFrustum(Frustum(request.viewProjection), candidates);
+	glUseProgram(idShader->ID());
+	glUniformMatrix4fv(glGetUniformLocation(idShader->ID(), "viewProjection"), 1, GL_FALSE, glm::value_ptr(request.viewProjection));
+	int idLoc = glGetUniformLocation(idShader->ID(), "objectID");
+	MeshCounts counts;
+	for (GameObject object : candidates) {
+		if (!(scene.renders[object].flags & RENDER_VISIBLE)) {
+			continue;
+		}
+		glUniform1ui(idLoc, object + 1);
+		Frustum localFrustum(request.viewProjection * scene.worldMatrices[object]); // lets the model skip meshes too
+		scene.models[scene.renders[object].model]->Draw(*idShader, counts, scene.worldMatrices[object], &localFrustum);
+	}
+	counts.Report();
+	Profiler::Get().AddCounter("pick.candidates", candidates.size());
+	// Draw IDs //
+
+	// Readback //
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readbackBuffers[nextReadback].ID());
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glReadPixels(0, 0, 1, 1, GL_RED_INTEGER, GL_UNSIGNED_INT, 0); // into the buffer, returns straight away
+	glReadPixels(0, 0, 1, 1, GL_DEPTH_COMPONENT, GL_FLOAT, (void*)sizeof(unsigned int));
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	readbackFences[nextReadback] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	readbackRequests[nextReadback] = request;
+	nextReadback = (nextReadback + 1) % numReadbacks;
+	// Readback //
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+void ObjectPicker::FinishReadbacks() {
+	// oldest first, stops at the first one that isn't done since the ones after it can't be either
+	for (unsigned int i = 0; i < numReadbacks; i++) {
+		unsigned int readback = (nextReadback + i) % numReadbacks;
+		if (!readbackFences[readback]) {
+			continue;
+		}
+		if (glClientWaitSync(readbackFences[readback], 0, 0) == GL_TIMEOUT_EXPIRED) { // timeout of 0 only polls
+			break;
+		}
+		glDeleteSync(readbackFences[readback]);
+		readbackFences[readback] = 0;
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, readbackBuffers[readback].ID());
+		const void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, sizeof(unsigned int) + sizeof(float), GL_MAP_READ_BIT);
+		if (data) {
+			unsigned int id = *(const unsigned int*)data;
+			float depth = *(const float*)((const unsigned char*)data + sizeof(unsigned int));
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+
+			// the pixel's centre is the middle of clip space for the narrowed projection, so unprojecting its depth
+			// there gives the point that was hit
+			const PickRequest& request = readbackRequests[readback];
+			PickResult result;
+			result.request = request.id;
+			if (id == 0) {
+				result.object = noObject;
+				result.distance = request.maxDistance;
+				result.position = request.origin + request.direction * request.maxDistance;
+			}
+			else {
+				glm::vec4 hit = glm::inverse(request.viewProjection) * glm::vec4(0.0f, 0.0f, depth * 2.0f - 1.0f, 1.0f);
+				result.object = id - 1;
+				result.position = glm::vec3(hit) / hit.w;
+				result.distance = glm::length(result.position - request.origin);
+			}
+			Post(result);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	}
+}
+
+void ObjectPicker::Post(const PickResult& result) {
+	std::lock_guard<std::mutex> lock(mutex);
+	latest = result;
+	fresh = true;
+}
+
+bool ObjectPicker::Poll(PickResult& result) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!fresh) {
+		return false;
+	}
+	result = latest;
+	fresh = false;
+	return true;
+}
@@ -0,0 +1,80 @@
+#include "profiler.h"
+
+Profiler& Profiler::Get() {
+	static Profiler profiler;
+	return profiler;
+}
+
+Profiler::Profiler() : reportInterval(0.0), lastFrameTime(0.0) {
+	frameStart = Clock::now();
+	lastReport = frameStart;
+}
+
+void Profiler::BeginFrame() {
+	std::lock_guard<std::mutex> lock(mutex);
+	frameStart = Clock::now();
+}
+
+void Profiler::EndFrame() {
+	Clock::time_point now = Clock::now();
+	bool report = false;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		lastFrameTime = std::chrono::duration<double, std::milli>(now - frameStart).count();
+		lastCounters.swap(counters);
+		lastTimes.swap(times);
+		// keep the names around but zero them, that way counters nobody touched this frame still show up as 0
+		for (auto& counter : counters) {
+			counter.second = 0;
+		}
+		for (auto& time : times) {
+			time.second = 0.0;
+		}
+
+		if (reportInterval > 0.0 && std::chrono::duration<double>(now - lastReport).count() >= reportInterval) {
+			lastReport = now;
+			report = true;
+		}
+	}
+	if (report) {
+		Print();
+	}
+}
+
+void Profiler::AddCounter(const std::string& name, long long value) {
+	std::lock_guard<std::mutex> lock(mutex);
+	counters[name] += value;
+}
+
+void Profiler::SetCounter(const std::string& name, long long value) {
+	std::lock_guard<std::mutex> lock(mutex);
+	counters[name] = value;
+}
+
+void Profiler::AddTime(const std::string& name, double milliseconds) {
+	std::lock_guard<std::mutex> lock(mutex);
+	times[name] += milliseconds;
+}
+
+long long Profiler::Counter(const std::string& name) const {
+	std::lock_guard<std::mutex> lock(mutex);
+	auto found = lastCounters.find(name);
+	return found == lastCounters.end() ? 0 : found->second;
+}
+
+double Profiler::Time(const std::string& name) const {
+	std::lock_guard<std::mutex> lock(mutex);
+	auto found = lastTimes.find(name);
+	return found == lastTimes.end() ? 0.0 : found->second;
+}
+
+void Profiler::Print() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	std::cout << "Frame: " << lastFrameTime << " ms\n";
+	for (const auto& time : lastTimes) {
+		std::cout << "  " << time.first << ": " << time.second << " ms\n";
+	}
+	for (const auto& counter : lastCounters) {
+		std::cout << "  " << counter.first << ": " << counter.second << "\n";
+	}
+}
@@ -0,0 +1,147 @@
+#include "renderqueue.h"
+#include "profiler.h"
+#include <cstring>
+#include <utility>
+
+void RenderQueue::Clear() {
+	commands.clear();
+	keys.clear();
+}
+
+void RenderQueue::Add(const RenderCommand& command, float depth, bool translucent, RenderPass pass) {
+	keys.push_back(MakeKey(command, depth, translucent, pass));
+	commands.push_back(command);
+}
+
+uint64_t RenderQueue::MakeKey(const RenderCommand& command, float depth, bool translucent, RenderPass pass) {
+	// the bits of a positive float sort the same way as its value, so the top 24 (below the sign) are a cheap depth
+	depth = depth > 0.0f ? depth : 0.0f;
+	uint32_t depthBits;
+	std::memcpy(&depthBits, &depth, sizeof(float));
+	uint64_t quantizedDepth = (depthBits >> 7) & 0xFFFFFF;
+
+	uint64_t shader = command.shader & 0x3FF; // 10 bits
+	uint64_t texture = command.texture & 0xFFF; // 12 bits
+	uint64_t vao = command.VAO & 0x7FFF; // 15 bits
+
+	uint64_t key = ((uint64_t)pass & 0x3) << 62;
+	if (translucent) {
+		key |= (uint64_t)1 << 61;
+		key |= (0xFFFFFF - quantizedDepth) << 37; // far to near
+		key |= shader << 27;
+		key |= texture << 15;
+		key |= vao;
+	}
+	else {
+		key |= shader << 51;
+		key |= texture << 39;
+		key |= vao << 24;
+		key |= quantizedDepth; // near to far
+	}
+	return key;
+}
+
+void RenderQueue::Sort() {
+	ScopedTimer timer("renderqueue.sort");
+	size_t count = keys.size();
+	order.resize(count);
+	for (size_t i = 0; i < count; i++) {
+		order[i] = (unsigned int)i;
+	}
+	keysScratch.resize(count);
+	orderScratch.resize(count);
+
+	// Histograms //
+	// least significant digit first, 11 bit digits take six passes instead of eight and a histogram still fits in L1.
+	// all six histograms come out of a single pass over the keys
+	unsigned int histograms[radixPasses][radixBuckets] = {};
+	for (size_t i = 0; i < count; i++) {
+		uint64_t key = keys[i];
+		for (int pass = 0; pass < radixPasses; pass++) {
+			histograms[pass][(key >> (pass * radixBits)) & (radixBuckets - 1)]++;
+		}
+	}
+	// Histograms //
+
+	uint64_t* sourceKeys = keys.data();
+	unsigned int* sourceOrder = order.data();
+	uint64_t* destKeys = keysScratch.data();
+	unsigned int* destOrder = orderScratch.data();
+	for (int pass = 0; pass < radixPasses; pass++) {
+		unsigned int* histogram = histograms[pass];
+		int shift = pass * radixBits;
+		if (count == 0 || histogram[(sourceKeys[0] >> shift) & (radixBuckets - 1)] == count) {
+			continue; // every key has the same value in this digit (common for the pass and shader bits), nothing would move
+		}
+
+		unsigned int offset = 0;
+		for (int bucket = 0; bucket < radixBuckets; bucket++) { // counts to starting positions
+			unsigned int bucketCount = histogram[bucket];
+			histogram[bucket] = offset;
+			offset += bucketCount;
+		}
+		for (size_t i = 0; i < count; i++) {
+			unsigned int position = histogram[(sourceKeys[i] >> shift) & (radixBuckets - 1)]++;
+			destKeys[position] = sourceKeys[i];
+			destOrder[position] = sourceOrder[i];
+		}
+		std::swap(sourceKeys, destKeys);
+		std::swap(sourceOrder, destOrder);
+	}
+
+	if (sourceKeys != keys.data()) { // an odd number of passes ran, the result is sitting in the scratch buffers
+		keys.swap(keysScratch);
+		order.swap(orderScratch);
+	}
+	Profiler::Get().AddCounter("renderqueue.draws", count);
+}
+
+void RenderQueue::Execute(UniformBuffers& uniforms) {
+	ScopedTimer timer("renderqueue.execute");
+	bool slots = uniforms.BeginObjects((unsigned int)order.size());
+	for (unsigned int draw = 0; slots && draw < order.size(); draw++) {
+		uniforms.WriteObject(draw, { commands[order[draw]].transform });
+	}
+	uniforms.EndObjects();
+	if (!slots) {
+		Profiler::Get().AddCounter("renderqueue.skipped", order.size()); // drawing them with another slot's transform would be worse
+		return;
+	}
+
+	unsigned int currentShader = 0;
+	unsigned int currentTexture = 0;
+	unsigned int currentVAO = 0;
+	unsigned int programChanges = 0;
+	unsigned int textureChanges = 0;
+	unsigned int vaoChanges = 0;
+	long long triangles = 0;
+
+	for (unsigned int draw = 0; draw < order.size(); draw++) {
+		const RenderCommand& command = commands[order[draw]];
+		if (command.shader != currentShader) {
+			glUseProgram(command.shader);
+			currentShader = command.shader;
+			programChanges++;
+		}
+		if (command.texture && command.texture != currentTexture) {
+			glBindTexture(GL_TEXTURE_2D, command.texture);
+			currentTexture = command.texture;
+			textureChanges++;
+		}
+		if (command.VAO != currentVAO) {
+			glBindVertexArray(command.VAO);
+			currentVAO = command.VAO;
+			vaoChanges++;
+		}
+		uniforms.BindObject(draw);
+		glDrawElements(GL_TRIANGLES, command.indexCount, GL_UNSIGNED_INT, 0);
+		triangles += command.indexCount / 3;
+	}
+	glBindVertexArray(0);
+
+	Profiler::Get().AddCounter("draw.calls", order.size());
+	Profiler::Get().AddCounter("draw.triangles", triangles);
+	Profiler::Get().AddCounter("state.programs", programChanges);
+	Profiler::Get().AddCounter("state.textures", textureChanges);
+	Profiler::Get().AddCounter("state.vaos", vaoChanges);
+}
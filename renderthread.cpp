@@ -0,0 +1,91 @@
+#include "renderthread.h"
+#include "profiler.h"
+
+void RenderThread::Start(GLFWwindow* renderWindow, const RenderFunction& renderFunction, bool runThreaded) {
+	window = renderWindow;
+	render = renderFunction;
+	threaded = runThreaded;
+	if (threaded) {
+		glfwMakeContextCurrent(NULL); // a context can only be current on one thread at a time
+		thread = std::thread(&RenderThread::Loop, this);
+	}
+}
+
+void RenderThread::Submit() {
+	if (!threaded) {
+		render(lists[writeList]);
+		Present(lists[writeList]);
+		lists[writeList].Clear();
+		return;
+	}
+
+	{
+		ScopedTimer timer("render.wait"); // time the simulation spent waiting for the render thread to catch up
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [this] { return !submitted; });
+		writeList ^= 1;
+		submitted = true;
+	}
+	wake.notify_one();
+	lists[writeList].Clear(); // the render thread finished with this one before it let go of submitted
+}
+
+void RenderThread::WaitIdle() {
+	if (!threaded) {
+		return;
+	}
+	ScopedTimer timer("render.wait");
+	std::unique_lock<std::mutex> lock(mutex);
+	done.wait(lock, [this] { return !submitted; });
+}
+
+void RenderThread::Stop() {
+	if (!threaded || !thread.joinable()) {
+		return;
+	}
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [this] { return !submitted; });
+		quit = true;
+	}
+	wake.notify_one();
+	thread.join();
+	glfwMakeContextCurrent(window);
+}
+
+void RenderThread::Loop() {
+	glfwMakeContextCurrent(window);
+	while (true) {
+		unsigned int readList;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [this] { return submitted || quit; });
+			if (!submitted) {
+				break; // quit, and nothing left to draw
+			}
+			readList = writeList ^ 1;
+		}
+
+		{
+			ScopedTimer timer("render.thread");
+			render(lists[readList]);
+		}
+		Present(lists[readList]);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			submitted = false;
+		}
+		done.notify_one();
+	}
+	glfwMakeContextCurrent(NULL);
+}
+
+void RenderThread::Present(const RenderCommandList& commands) {
+	if (commands.swapInterval != swapInterval) {
+		swapInterval = commands.swapInterval;
+		glfwSwapInterval(swapInterval); // applies to the current context, which is why the main thread can't do it
+	}
+	ScopedTimer timer("render.swap"); // mostly waiting for the display with vsync on
+	glfwSwapBuffers(window);
+}
@@ -0,0 +1,312 @@
+#include "scene.h"
+#include "occlusion.h"
+#include "indirectrenderer.h"
+#include "gpuculling.h"
+#include "jobsystem.h"
+
+unsigned int Scene::LoadModel(const std::string& file) {
+	for (unsigned int model = 0; model < models.size(); model++) {
+		if (models[model]->name == file) {
+			return model;
+		}
+	}
+	models.push_back(std::unique_ptr<Model>(new Model(file)));
+	return (unsigned int)models.size() - 1;
+}
+
+GameObject Scene::Create(unsigned int model, const TransformComponent& transform, unsigned int flags) {
+	GameObject object = Size();
+	transforms.push_back(transform);
+	renders.push_back({ model, flags });
+	worldMatrices.push_back(glm::mat4(1.0f));
+	worldBounds.push_back(AABB());
+	UpdateDerived(object);
+	proxies.push_back(bvh.Insert(worldBounds[object], object));
+	version++;
+	LayoutChanged();
+	return object;
+}
+
+void Scene::Remove(GameObject object) {
+	bvh.Remove(proxies[object]);
+
+	GameObject last = Size() - 1;
+	if (object != last) { // fill the gap with the last object
+		transforms[object] = transforms[last];
+		renders[object] = renders[last];
+		worldMatrices[object] = worldMatrices[last];
+		worldBounds[object] = worldBounds[last];
+		proxies[object] = proxies[last];
+		bvh.SetUserData(proxies[object], object);
+	}
+	transforms.pop_back();
+	renders.pop_back();
+	worldMatrices.pop_back();
+	worldBounds.pop_back();
+	proxies.pop_back();
+	version++;
+	LayoutChanged();
+}
+
+void Scene::SetTransform(GameObject object, const TransformComponent& transform) {
+	transforms[object] = transform;
+	UpdateDerived(object);
+	bvh.Move(proxies[object], worldBounds[object]);
+	version++;
+	movedObjects.push_back(object);
+	if (movedObjects.size() > std::max<size_t>(transforms.size(), 4096)) {
+		LayoutChanged(); // more moves than objects, starting again from the whole scene is cheaper than replaying them
+	}
+}
+
+bool Scene::Assign(const TransformComponent* newTransforms, const RenderComponent* newRenders, unsigned int count, const std::vector<unsigned int>& modelMap) {
+	ScopedTimer timer("scene.assign");
+	transforms.assign(newTransforms, newTransforms + count);
+	renders.assign(newRenders, newRenders + count);
+	worldMatrices.resize(count);
+	worldBounds.resize(count);
+	proxies.resize(count);
+	bvh.Clear();
+	version++;
+	LayoutChanged();
+
+	bool valid = true;
+	for (GameObject object = 0; object < count; object++) {
+		if (renders[object].model >= modelMap.size()) {
+			valid = false;
+			break;
+		}
+		renders[object].model = modelMap[renders[object].model];
+	}
+	if (!valid) {
+		transforms.clear();
+		renders.clear();
+		worldMatrices.clear();
+		worldBounds.clear();
+		proxies.clear();
+		return false;
+	}
+
+	// the matrices and bounds are independent per object, so they're split across the job system
+	JobSystem::Get().ParallelFor(count, 1024, [this](unsigned int begin, unsigned int end, unsigned int thread) {
+		for (GameObject object = begin; object < end; object++) {
+			UpdateDerived(object);
+		}
+	});
+	// one top down build instead of inserting (and rebalancing) leaf by leaf
+	for (GameObject object = 0; object < count; object++) {
+		proxies[object] = bvh.Add(worldBounds[object], object);
+	}
+	bvh.Build();
+	return true;
+}
+
+void Scene::UpdateDerived(GameObject object) {
+	worldMatrices[object] = transforms[object].Matrix();
+	worldBounds[object] = models[renders[object].model]->bounds.Transformed(worldMatrices[object]);
+}
+
+void Scene::Unload() {
+	transforms.clear();
+	renders.clear();
+	worldMatrices.clear();
+	worldBounds.clear();
+	proxies.clear();
+	bvh.Clear();
+	models.clear(); // deleting the models frees their GPU memory
+	version++;
+	LayoutChanged();
+}
+
+void Scene::LayoutChanged() {
+	layoutVersion++;
+	movedObjects.clear();
+}
+
+void Scene::Cull(const Frustum& frustum, std::vector<GameObject>& visible) const {
+	ScopedTimer timer("scene.cull");
+	visible.clear();
+	bvh.QueryFrustum(frustum, visible);
+	Profiler::Get().AddCounter("scene.objects", Size());
+	Profiler::Get().AddCounter("scene.visible", visible.size());
+}
+
+void Scene::CullViews(const Frustum* frusta, unsigned int count, std::vector<std::vector<GameObject>>& visible) {
+	ScopedTimer timer("scene.cull");
+	count = std::min(count, BVH::maxFrusta);
+	visibleObjects.clear();
+	visibleMasks.clear();
+	bvh.QueryFrusta(frusta, count, visibleObjects, visibleMasks);
+
+	visible.resize(count);
+	for (unsigned int view = 0; view < count; view++) {
+		visible[view].clear();
+	}
+	for (size_t result = 0; result < visibleObjects.size(); result++) {
+		for (unsigned int view = 0; view < count; view++) {
+			if (visibleMasks[result] & (1u << view)) {
+				visible[view].push_back(visibleObjects[result]);
+			}
+		}
+	}
+	Profiler::Get().AddCounter("scene.objects", Size());
+	Profiler::Get().AddCounter("scene.visible", visibleObjects.size()); // in at least one view
+	Profiler::Get().AddCounter("scene.views", count);
+}
+
+void Scene::Draw(const Shader& shader, const glm::mat4& viewProjection) {
+	if (gpuCulling) {
+		gpuCulling->Draw(*this, viewProjection);
+		glUseProgram(shader.ID());
+		return;
+	}
+
+	Cull(Frustum(viewProjection), visibleObjects);
+
+	// Occlusion Culling //
+	if (occlusion) {
+		occlusion->Prepare(*this, viewProjection);
+		glUseProgram(shader.ID()); // the culler draws with its own shaders
+
+		ScopedTimer timer("occlusion.test");
+		unsigned int kept = 0;
+		for (GameObject object : visibleObjects) {
+			// occluders are always drawn, they are what everything else is tested against
+			if ((renders[object].flags & RENDER_OCCLUDER) || !occlusion->IsOccluded(worldBounds[object])) {
+				visibleObjects[kept++] = object;
+			}
+		}
+		Profiler::Get().AddCounter("occlusion.tested", visibleObjects.size());
+		Profiler::Get().AddCounter("occlusion.culled", visibleObjects.size() - kept);
+		visibleObjects.resize(kept);
+	}
+	// Occlusion Culling //
+
+	DrawObjects(shader, visibleObjects, viewProjection);
+}
+
+void Scene::DrawObjects(const Shader& shader, const std::vector<GameObject>& objects, const glm::mat4& viewProjection) {
+	if (indirect) {
+		indirect->Draw(*this, objects, viewProjection);
+		glUseProgram(shader.ID());
+		return;
+	}
+
+	if (!uniforms) {
+		static bool warned = false;
+		if (!warned) {
+			std::cout << "Error: Scene::uniforms isn't set, nothing can be drawn without an ObjectData block to put transforms in.\n";
+			warned = true;
+		}
+		return;
+	}
+	queue.Clear();
+	MeshCounts counts;
+	for (GameObject object : objects) {
+		if (!(renders[object].flags & RENDER_VISIBLE)) {
+			continue;
+		}
+		// the frustum built from viewProjection * world is the camera frustum in the model's own space,
+		// so the per mesh bounds can be tested without moving them into world space first
+		Frustum localFrustum(viewProjection * worldMatrices[object]);
+		bool translucent = (renders[object].flags & RENDER_TRANSLUCENT) != 0;
+		models[renders[object].model]->Queue(queue, shader, counts, worldMatrices[object], viewProjection, &localFrustum, translucent);
+	}
+	counts.Report();
+	queue.Sort();
+	queue.Execute(*uniforms);
+	glUseProgram(shader.ID());
+}
+
+// Ray Casts //
+// how far along the ray it enters the box, -1 if it misses or only gets there after maxDistance
+static float RayBoxDistance(const glm::vec3& origin, const glm::vec3& inverseDirection, const AABB& box, float maxDistance) {
+	float tMin = 0.0f;
+	float tMax = maxDistance;
+	for (int axis = 0; axis < 3; axis++) {
+		float t1 = (box.min[axis] - origin[axis]) * inverseDirection[axis];
+		float t2 = (box.max[axis] - origin[axis]) * inverseDirection[axis];
+		tMin = std::max(tMin, std::min(t1, t2));
+		tMax = std::min(tMax, std::max(t1, t2));
+	}
+	return tMin <= tMax ? tMin : -1.0f;
+}
+
+// Moller-Trumbore, both sides count since the renderer doesn't cull back faces. -1 on a miss
+static float RayTriangleDistance(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2) {
+	glm::vec3 edge1 = v1 - v0;
+	glm::vec3 edge2 = v2 - v0;
+	glm::vec3 p = glm::cross(direction, edge2);
+	float determinant = glm::dot(edge1, p);
+	if (std::abs(determinant) < 1e-12f) {
+		return -1.0f; // parallel to the triangle (or it's degenerate)
+	}
+	float inverseDeterminant = 1.0f / determinant;
+	glm::vec3 toOrigin = origin - v0;
+	float u = glm::dot(toOrigin, p) * inverseDeterminant;
+	if (u < 0.0f || u > 1.0f) {
+		return -1.0f;
+	}
+	glm::vec3 q = glm::cross(toOrigin, edge1);
+	float v = glm::dot(direction, q) * inverseDeterminant;
+	if (v < 0.0f || u + v > 1.0f) {
+		return -1.0f;
+	}
+	return glm::dot(edge2, q) * inverseDeterminant;
+}
+
+GameObject Scene::RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance) const {
+	GameObject hit = noObject;
+	glm::vec3 inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+	distance = bvh.RayCast(origin, direction, maxDistance, [&](unsigned int object, float closest) {
+		// the tree only stores fattened boxes, so test the object's real bounds before accepting the hit
+		float boxDistance = RayBoxDistance(origin, inverseDirection, worldBounds[object], closest);
+		if (boxDistance >= 0.0f) {
+			hit = object;
+			return boxDistance;
+		}
+		return closest;
+	});
+	return hit;
+}
+
+GameObject Scene::RayCastMeshes(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance) const {
+	ScopedTimer timer("scene.rayCastMeshes");
+	GameObject hit = noObject;
+	glm::vec3 inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+	unsigned int trianglesTested = 0;
+	distance = bvh.RayCast(origin, direction, maxDistance, [&](unsigned int object, float closest) {
+		if (RayBoxDistance(origin, inverseDirection, worldBounds[object], closest) < 0.0f) {
+			return closest;
+		}
+		// the ray is moved into the model's space (where the mesh bounds are) and then each mesh's, instead of moving
+		// every vertex out of it. the direction isn't renormalized, so distances along it stay world distances
+		const Model& model = *models[renders[object].model];
+		glm::mat4 worldToModel = glm::inverse(worldMatrices[object]);
+		glm::vec3 modelOrigin = glm::vec3(worldToModel * glm::vec4(origin, 1.0f));
+		glm::vec3 modelDirection = glm::vec3(worldToModel * glm::vec4(direction, 0.0f));
+		glm::vec3 modelInverseDirection(1.0f / modelDirection.x, 1.0f / modelDirection.y, 1.0f / modelDirection.z);
+		for (unsigned int mesh = 0; mesh < model.numMeshes; mesh++) {
+			if (RayBoxDistance(modelOrigin, modelInverseDirection, model.meshBounds[mesh], closest) < 0.0f) {
+				continue;
+			}
+			glm::mat4 modelToMesh = glm::inverse(model.transforms[mesh]);
+			glm::vec3 meshOrigin = glm::vec3(modelToMesh * glm::vec4(modelOrigin, 1.0f));
+			glm::vec3 meshDirection = glm::vec3(modelToMesh * glm::vec4(modelDirection, 0.0f));
+			const std::vector<glm::vec3>& positions = model.cpuPositions[mesh];
+			const std::vector<unsigned int>& indices = model.cpuIndices[mesh];
+			for (size_t index = 0; index + 2 < indices.size(); index += 3) {
+				float triangleDistance = RayTriangleDistance(meshOrigin, meshDirection, positions[indices[index]], positions[indices[index + 1]], positions[indices[index + 2]]);
+				if (triangleDistance >= 0.0f && triangleDistance < closest) {
+					closest = triangleDistance;
+					hit = object;
+				}
+			}
+			trianglesTested += (unsigned int)(indices.size() / 3);
+		}
+		return closest;
+	});
+	Profiler::Get().AddCounter("scene.rayTriangles", trianglesTested);
+	return hit;
+}
+// Ray Casts //
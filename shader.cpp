@@ -1,10 +1,29 @@
 #include "shader.h"
+#include "uniformbuffers.h"
 
 Shader::Shader(const std::string& vertexShaderPath, const std::string& fragmentShaderPath) {
 	unsigned int vertexShader = CompileShader(vertexShaderPath);
 	unsigned int fragmentShader = CompileShader(fragmentShaderPath);
-	ID = CreateShaderProgram(vertexShader, fragmentShader);
+	program = GLProgram::Adopt(CreateShaderProgram(vertexShader, fragmentShader), vertexShaderPath);
+	FinishProgram();
 }
+
+Shader::Shader(const std::string& computeShaderPath) {
+	unsigned int computeShader = CompileShader(computeShaderPath);
+	program = GLProgram::Adopt(CreateComputeProgram(computeShader), computeShaderPath);
+	FinishProgram();
+}
+
+void Shader::FinishProgram() {
+	UniformBuffers::BindBlocks(program.ID()); // every program gets the shared uniform blocks at the same binding points
+
+	if (GLAD_GL_ARB_get_program_binary) { // the closest thing GL gives us to the size of a linked program
+		int binaryLength = 0;
+		glGetProgramiv(program.ID(), GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+		GPUResourceRegistry::Get().SetBytes(GPUResourceType::Program, program.ID(), binaryLength);
+	}
+}
+
 unsigned int Shader::CompileShader(const std::string& file) {
 	// determine shader type from file extension, all file extensions are four characters long so we grab the first letter
 	const char extensionType = file[file.size() - 4];
@@ -16,6 +35,9 @@ unsigned int Shader::CompileShader(const std::string& file) {
 	else if (extensionType == 'f') {
 		shader = glCreateShader(GL_FRAGMENT_SHADER);
 	}
+	else if (extensionType == 'c') {
+		shader = glCreateShader(GL_COMPUTE_SHADER);
+	}
 	else {
 		std::cout << "Error: Shader extension type for " << file << " is unreadable.\n";
 	}
@@ -45,6 +67,18 @@ unsigned int Shader::CreateShaderProgram(unsigned int vertexShader, unsigned int
 	return shaderProgram;
 }
 
+unsigned int Shader::CreateComputeProgram(unsigned int computeShader) {
+	unsigned int shaderProgram;
+	shaderProgram = glCreateProgram();
+	glAttachShader(shaderProgram, computeShader);
+	glLinkProgram(shaderProgram);
+	CheckSuccess(1, shaderProgram);
+
+	glDeleteShader(computeShader);
+
+	return shaderProgram;
+}
+
 std::string Shader::ReadShaderFile(const std::string& file) {
 	std::ifstream readFile(file);
 	std::string inputString = "";
@@ -0,0 +1,67 @@
+#include "simulation.h"
+#include "profiler.h"
+#include <cmath>
+
+FixedTimestep::FixedTimestep(double tickRate, unsigned int catchUp) : step(1.0 / tickRate), accumulator(0.0), maxCatchUp(catchUp), ticks(0) {}
+
+void FixedTimestep::SetTickRate(double tickRate) {
+	double alpha = accumulator / step;
+	step = 1.0 / tickRate;
+	accumulator = alpha * step; // keep the blend where it was
+}
+
+unsigned int FixedTimestep::Advance(double frameSeconds) {
+	accumulator += frameSeconds;
+	unsigned int steps = (unsigned int)std::floor(accumulator / step);
+	if (steps > maxCatchUp) {
+		Profiler::Get().AddCounter("sim.droppedTicks", steps - maxCatchUp);
+		steps = maxCatchUp;
+		accumulator = std::fmod(accumulator, step); // the dropped time is gone for good, the world just runs slow for a moment
+	}
+	else {
+		accumulator -= steps * step;
+	}
+	ticks += steps;
+	Profiler::Get().AddCounter("sim.ticks", steps);
+	return steps;
+}
+
+void InterpolateTransforms(const SimulationState& previous, const SimulationState& current, float alpha,
+	std::vector<unsigned char>& movingChunks, std::vector<RenderCommandList::TransformChange>& changes) {
+	const ChunkedArray<TransformComponent>& from = previous.transforms;
+	const ChunkedArray<TransformComponent>& to = current.transforms;
+	movingChunks.resize(to.ChunkCount(), 0);
+	for (size_t chunk = 0; chunk < to.ChunkCount(); chunk++) {
+		bool shared = to.SharesChunk(from, chunk);
+		if (shared && !movingChunks[chunk]) {
+			continue; // nothing in here moved this step or the one before
+		}
+
+		GameObject first = (GameObject)(chunk * to.chunkSize);
+		GameObject last = first + (GameObject)to.ChunkLength(chunk);
+		bool moved = false;
+		for (GameObject object = first; object < last; object++) {
+			if (!shared && object < from.Size() && from[object] != to[object]) {
+				changes.push_back({ object, TransformComponent::Interpolate(from[object], to[object], alpha) });
+				moved = true;
+			}
+			else if (movingChunks[chunk]) { // may have come to rest since last frame, make sure it ends up exactly where the simulation left it
+				changes.push_back({ object, to[object] });
+			}
+		}
+		movingChunks[chunk] = moved;
+	}
+}
+
+void ResyncTransforms(const SimulationState& from, const SimulationState& to, std::vector<RenderCommandList::TransformChange>& changes) {
+	for (size_t chunk = 0; chunk < to.transforms.ChunkCount(); chunk++) {
+		if (to.transforms.SharesChunk(from.transforms, chunk)) {
+			continue;
+		}
+		GameObject first = (GameObject)(chunk * to.transforms.chunkSize);
+		GameObject last = first + (GameObject)to.transforms.ChunkLength(chunk);
+		for (GameObject object = first; object < last; object++) {
+			changes.push_back({ object, to.transforms[object] });
+		}
+	}
+}
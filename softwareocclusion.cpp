@@ -0,0 +1,291 @@
+#include "softwareocclusion.h"
+#include "scene.h"
+#include "jobsystem.h"
+#include <immintrin.h> // SSE/AVX intrinsics
+#include <algorithm>
+#include <cmath>
+
+// Lanes //
+// the rasterizer is written once against these, they map to 8 wide AVX when the compiler allows it and 4 wide SSE otherwise
+#if defined(__AVX__)
+typedef __m256 Lanes;
+static const int laneCount = 8;
+static inline Lanes Set1(float value) { return _mm256_set1_ps(value); }
+static inline Lanes Ramp() { return _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f); }
+static inline Lanes Add(Lanes a, Lanes b) { return _mm256_add_ps(a, b); }
+static inline Lanes Mul(Lanes a, Lanes b) { return _mm256_mul_ps(a, b); }
+static inline Lanes Min(Lanes a, Lanes b) { return _mm256_min_ps(a, b); }
+static inline Lanes And(Lanes a, Lanes b) { return _mm256_and_ps(a, b); }
+static inline Lanes GreaterEqualZero(Lanes a) { return _mm256_cmp_ps(a, _mm256_setzero_ps(), _CMP_GE_OQ); }
+static inline Lanes Select(Lanes mask, Lanes a, Lanes b) { return _mm256_blendv_ps(b, a, mask); } // a where mask is set
+static inline int AnySet(Lanes mask) { return _mm256_movemask_ps(mask); }
+static inline Lanes Load(const float* memory) { return _mm256_loadu_ps(memory); }
+static inline void Store(float* memory, Lanes value) { _mm256_storeu_ps(memory, value); }
+#else
+typedef __m128 Lanes;
+static const int laneCount = 4;
+static inline Lanes Set1(float value) { return _mm_set1_ps(value); }
+static inline Lanes Ramp() { return _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f); }
+static inline Lanes Add(Lanes a, Lanes b) { return _mm_add_ps(a, b); }
+static inline Lanes Mul(Lanes a, Lanes b) { return _mm_mul_ps(a, b); }
+static inline Lanes Min(Lanes a, Lanes b) { return _mm_min_ps(a, b); }
+static inline Lanes And(Lanes a, Lanes b) { return _mm_and_ps(a, b); }
+static inline Lanes GreaterEqualZero(Lanes a) { return _mm_cmpge_ps(a, _mm_setzero_ps()); }
+static inline Lanes Select(Lanes mask, Lanes a, Lanes b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); } // SSE2 has no blend
+static inline int AnySet(Lanes mask) { return _mm_movemask_ps(mask); }
+static inline Lanes Load(const float* memory) { return _mm_loadu_ps(memory); }
+static inline void Store(float* memory, Lanes value) { _mm_storeu_ps(memory, value); }
+#endif
+// Lanes //
+
+SoftwareOcclusion::SoftwareOcclusion(unsigned int w, unsigned int h) : width(w), height(h), viewProjection(1.0f) {
+	tilesX = (width + tileSize - 1) / tileSize;
+	tilesY = (height + tileSize - 1) / tileSize;
+	width = tilesX * tileSize; // round up so every tile is whole
+	height = tilesY * tileSize;
+	depth.assign(width * height, 1.0f);
+	coarseWidth = width / coarseSize;
+	coarseHeight = height / coarseSize;
+	coarseDepth.assign(coarseWidth * coarseHeight, 1.0f);
+}
+
+void SoftwareOcclusion::Prepare(const Scene& scene, const glm::mat4& frameViewProjection) {
+	viewProjection = frameViewProjection;
+	JobSystem& jobs = JobSystem::Get();
+
+	// Transform And Bin //
+	{
+		ScopedTimer timer("softocclusion.bin");
+		occluders.clear();
+		for (GameObject object = 0; object < scene.Size(); object++) {
+			if (scene.renders[object].flags & RENDER_OCCLUDER) {
+				occluders.push_back(object);
+			}
+		}
+
+		unsigned int numThreads = jobs.NumThreads();
+		threadTriangles.resize(numThreads);
+		threadBins.resize(numThreads);
+		for (unsigned int thread = 0; thread < numThreads; thread++) {
+			threadTriangles[thread].clear();
+			threadBins[thread].resize(tilesX * tilesY);
+			for (std::vector<unsigned int>& bin : threadBins[thread]) {
+				bin.clear();
+			}
+		}
+
+		jobs.ParallelFor((unsigned int)occluders.size(), 4, [&](unsigned int begin, unsigned int end, unsigned int thread) {
+			TransformAndBin(scene, begin, end, thread);
+		});
+
+		size_t numTriangles = 0;
+		for (const std::vector<ScreenTriangle>& triangles : threadTriangles) {
+			numTriangles += triangles.size();
+		}
+		Profiler::Get().AddCounter("softocclusion.triangles", numTriangles);
+	}
+	// Transform And Bin //
+
+	// Rasterize //
+	{
+		ScopedTimer timer("softocclusion.raster");
+		jobs.ParallelFor(tilesX * tilesY, 1, [&](unsigned int begin, unsigned int end, unsigned int thread) {
+			for (unsigned int tile = begin; tile < end; tile++) {
+				RasterizeTile(tile);
+			}
+		});
+	}
+	// Rasterize //
+}
+
+void SoftwareOcclusion::TransformAndBin(const Scene& scene, unsigned int firstOccluder, unsigned int endOccluder, unsigned int thread) {
+	std::vector<ScreenTriangle>& triangles = threadTriangles[thread];
+	std::vector<std::vector<unsigned int>>& bins = threadBins[thread];
+	std::vector<glm::vec4> clip; // reused between meshes
+
+	for (unsigned int occluder = firstOccluder; occluder < endOccluder; occluder++) {
+		GameObject object = occluders[occluder];
+		const Model& model = *scene.models[scene.renders[object].model];
+
+		for (unsigned int mesh = 0; mesh < model.numMeshes; mesh++) {
+			glm::mat4 meshViewProjection = viewProjection * scene.worldMatrices[object] * model.transforms[mesh];
+			const std::vector<glm::vec3>& positions = model.cpuPositions[mesh];
+			const std::vector<unsigned int>& indices = model.cpuIndices[mesh];
+
+			clip.resize(positions.size());
+			for (size_t vertex = 0; vertex < positions.size(); vertex++) {
+				clip[vertex] = meshViewProjection * glm::vec4(positions[vertex], 1.0f);
+			}
+
+			for (size_t index = 0; index + 2 < indices.size(); index += 3) {
+				const glm::vec4& clip0 = clip[indices[index]];
+				const glm::vec4& clip1 = clip[indices[index + 1]];
+				const glm::vec4& clip2 = clip[indices[index + 2]];
+				// there's no near plane clipping, triangles crossing it are just dropped (an occluder missing only means less gets culled)
+				if (clip0.w <= 1e-5f || clip1.w <= 1e-5f || clip2.w <= 1e-5f) {
+					continue;
+				}
+
+				ScreenTriangle triangle;
+				const glm::vec4* corners[3] = { &clip0, &clip1, &clip2 };
+				for (int corner = 0; corner < 3; corner++) {
+					glm::vec3 ndc = glm::vec3(*corners[corner]) / corners[corner]->w;
+					triangle.vertex[corner] = glm::vec3((ndc.x * 0.5f + 0.5f) * width, (ndc.y * 0.5f + 0.5f) * height, ndc.z * 0.5f + 0.5f);
+				}
+
+				// the renderer doesn't cull back faces, so neither do we, clockwise triangles are just flipped round
+				glm::vec3 edge1 = triangle.vertex[1] - triangle.vertex[0];
+				glm::vec3 edge2 = triangle.vertex[2] - triangle.vertex[0];
+				float area = edge1.x * edge2.y - edge1.y * edge2.x;
+				if (area == 0.0f) {
+					continue;
+				}
+				if (area < 0.0f) {
+					std::swap(triangle.vertex[1], triangle.vertex[2]);
+				}
+
+				float minX = std::min(triangle.vertex[0].x, std::min(triangle.vertex[1].x, triangle.vertex[2].x));
+				float maxX = std::max(triangle.vertex[0].x, std::max(triangle.vertex[1].x, triangle.vertex[2].x));
+				float minY = std::min(triangle.vertex[0].y, std::min(triangle.vertex[1].y, triangle.vertex[2].y));
+				float maxY = std::max(triangle.vertex[0].y, std::max(triangle.vertex[1].y, triangle.vertex[2].y));
+				if (maxX < 0.0f || maxY < 0.0f || minX >= width || minY >= height) {
+					continue; // off screen
+				}
+
+				// Binning //
+				int tileX0 = std::max(0, (int)minX / tileSize);
+				int tileX1 = std::min((int)tilesX - 1, (int)maxX / tileSize);
+				int tileY0 = std::max(0, (int)minY / tileSize);
+				int tileY1 = std::min((int)tilesY - 1, (int)maxY / tileSize);
+				unsigned int triangleIndex = (unsigned int)triangles.size();
+				triangles.push_back(triangle);
+				for (int tileY = tileY0; tileY <= tileY1; tileY++) {
+					for (int tileX = tileX0; tileX <= tileX1; tileX++) {
+						bins[tileY * tilesX + tileX].push_back(triangleIndex);
+					}
+				}
+				// Binning //
+			}
+		}
+	}
+}
+
+void SoftwareOcclusion::RasterizeTile(unsigned int tile) {
+	int tileX = (tile % tilesX) * tileSize;
+	int tileY = (tile / tilesX) * tileSize;
+	for (int y = tileY; y < tileY + tileSize; y++) {
+		std::fill(depth.begin() + y * width + tileX, depth.begin() + y * width + tileX + tileSize, 1.0f);
+	}
+
+	// the depth test keeps the nearest value, so the order triangles arrive in doesn't change the result
+	for (size_t thread = 0; thread < threadBins.size(); thread++) {
+		for (unsigned int triangle : threadBins[thread][tile]) {
+			RasterizeTriangle(threadTriangles[thread][triangle], tileX, tileY);
+		}
+	}
+
+	// Coarse Depth //
+	for (int blockY = tileY; blockY < tileY + tileSize; blockY += coarseSize) {
+		for (int blockX = tileX; blockX < tileX + tileSize; blockX += coarseSize) {
+			float furthest = 0.0f;
+			for (int y = blockY; y < blockY + coarseSize; y++) {
+				for (int x = blockX; x < blockX + coarseSize; x++) {
+					furthest = std::max(furthest, depth[y * width + x]);
+				}
+			}
+			coarseDepth[(blockY / coarseSize) * coarseWidth + blockX / coarseSize] = furthest;
+		}
+	}
+	// Coarse Depth //
+}
+
+void SoftwareOcclusion::RasterizeTriangle(const ScreenTriangle& triangle, int tileX, int tileY) {
+	const glm::vec3& v0 = triangle.vertex[0];
+	const glm::vec3& v1 = triangle.vertex[1];
+	const glm::vec3& v2 = triangle.vertex[2];
+
+	// Setup //
+	// each edge function is a*x + b*y + c, positive on the inside of a counter clockwise triangle
+	// the edge opposite a vertex, divided by the area, is that vertex's barycentric weight
+	float a12 = v1.y - v2.y, b12 = v2.x - v1.x, c12 = v1.x * v2.y - v1.y * v2.x;
+	float a20 = v2.y - v0.y, b20 = v0.x - v2.x, c20 = v2.x * v0.y - v2.y * v0.x;
+	float a01 = v0.y - v1.y, b01 = v1.x - v0.x, c01 = v0.x * v1.y - v0.y * v1.x;
+	float area = c12 + c20 + c01;
+	if (area <= 0.0f) {
+		return;
+	}
+	// depth is linear in screen space, so it's just another plane built from the same edge functions
+	float inverseArea = 1.0f / area;
+	float depthA = ((v1.z - v0.z) * a20 + (v2.z - v0.z) * a01) * inverseArea;
+	float depthB = ((v1.z - v0.z) * b20 + (v2.z - v0.z) * b01) * inverseArea;
+	float depthC = v0.z + ((v1.z - v0.z) * c20 + (v2.z - v0.z) * c01) * inverseArea;
+
+	// pixels of this tile that the triangle's bounding box covers, x snapped down to a whole group of lanes
+	int minX = std::max(tileX, (int)std::floor(std::min(v0.x, std::min(v1.x, v2.x))));
+	int maxX = std::min(tileX + tileSize - 1, (int)std::ceil(std::max(v0.x, std::max(v1.x, v2.x))));
+	int minY = std::max(tileY, (int)std::floor(std::min(v0.y, std::min(v1.y, v2.y))));
+	int maxY = std::min(tileY + tileSize - 1, (int)std::ceil(std::max(v0.y, std::max(v1.y, v2.y))));
+	if (minX > maxX || minY > maxY) {
+		return;
+	}
+	minX = tileX + ((minX - tileX) & ~(laneCount - 1));
+	// Setup //
+
+	const Lanes ramp = Ramp();
+	const Lanes stepA12 = Set1(a12), stepA20 = Set1(a20), stepA01 = Set1(a01), stepDepthA = Set1(depthA);
+
+	for (int y = minY; y <= maxY; y++) {
+		float centerY = y + 0.5f;
+		Lanes rowE12 = Set1(b12 * centerY + c12);
+		Lanes rowE20 = Set1(b20 * centerY + c20);
+		Lanes rowE01 = Set1(b01 * centerY + c01);
+		Lanes rowDepth = Set1(depthB * centerY + depthC);
+		float* row = &depth[y * width];
+
+		for (int x = minX; x <= maxX; x += laneCount) {
+			Lanes centerX = Add(Set1(x + 0.5f), ramp);
+			Lanes e12 = Add(Mul(stepA12, centerX), rowE12);
+			Lanes e20 = Add(Mul(stepA20, centerX), rowE20);
+			Lanes e01 = Add(Mul(stepA01, centerX), rowE01);
+			Lanes inside = And(And(GreaterEqualZero(e12), GreaterEqualZero(e20)), GreaterEqualZero(e01));
+			if (!AnySet(inside)) {
+				continue;
+			}
+			Lanes pixelDepth = Add(Mul(stepDepthA, centerX), rowDepth);
+			Lanes current = Load(row + x);
+			Store(row + x, Select(inside, Min(current, pixelDepth), current));
+		}
+	}
+}
+
+bool SoftwareOcclusion::IsOccluded(const AABB& box) const {
+	// Project Box //
+	glm::vec3 minimum(FLT_MAX);
+	glm::vec3 maximum(-FLT_MAX);
+	for (int corner = 0; corner < 8; corner++) {
+		glm::vec4 position((corner & 1) ? box.max.x : box.min.x, (corner & 2) ? box.max.y : box.min.y, (corner & 4) ? box.max.z : box.min.z, 1.0f);
+		glm::vec4 clip = viewProjection * position;
+		if (clip.w <= 1e-5f) {
+			return false; // reaches behind the camera
+		}
+		glm::vec3 ndc = glm::vec3(clip) / clip.w;
+		minimum = glm::min(minimum, ndc);
+		maximum = glm::max(maximum, ndc);
+	}
+	// Project Box //
+
+	int x0 = std::max(0, (int)std::floor((minimum.x * 0.5f + 0.5f) * coarseWidth));
+	int x1 = std::min((int)coarseWidth - 1, (int)std::floor((maximum.x * 0.5f + 0.5f) * coarseWidth));
+	int y0 = std::max(0, (int)std::floor((minimum.y * 0.5f + 0.5f) * coarseHeight));
+	int y1 = std::min((int)coarseHeight - 1, (int)std::floor((maximum.y * 0.5f + 0.5f) * coarseHeight));
+	float nearestDepth = minimum.z * 0.5f + 0.5f;
+
+	for (int y = y0; y <= y1; y++) {
+		for (int x = x0; x <= x1; x++) {
+			if (nearestDepth <= coarseDepth[y * coarseWidth + x]) {
+				return false;
+			}
+		}
+	}
+	return x0 <= x1 && y0 <= y1; // a box with no pixels on screen is the frustum test's business
+}
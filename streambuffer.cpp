@@ -0,0 +1,196 @@
+#include "streambuffer.h"
+#include "glcaps.h"
+#include "profiler.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+StreamBuffer::StreamBuffer(GLenum bufferTarget, size_t bufferCapacity, const std::string& bufferOwner) :
+	target(bufferTarget), capacity(bufferCapacity), owner(bufferOwner), persistent(GLCaps::Get().bufferStorage), persistentMemory(nullptr), mapped(false),
+	head(0), used(0), frameBytes(0), frameOverflow(0), peakFrameBytes(0), bytesWritten(0), throughput(0), throughputStart(std::chrono::steady_clock::now()) {
+	Create();
+}
+
+void StreamBuffer::Create() {
+	// made before the old buffer is let go, so the new one never gets the old one's name and ID() really changes
+	GLBuffer created = GLBuffer::Create(owner);
+	persistentMemory = nullptr;
+	glBindBuffer(target, created.ID());
+	if (persistent) {
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(target, capacity, NULL, flags);
+		GPUResourceRegistry::Get().SetBytes(GPUResourceType::Buffer, created.ID(), capacity);
+		persistentMemory = (unsigned char*)glMapBufferRange(target, 0, capacity, flags);
+		if (!persistentMemory) {
+			std::cout << "Error: Failed to persistently map stream buffer for " << owner << ", falling back to orphaning.\n";
+			persistent = false;
+			created = GLBuffer::Create(owner); // immutable storage can't be respecified, start over with a normal buffer
+			glBindBuffer(target, created.ID());
+		}
+	}
+	if (!persistent) {
+		BufferData(target, created, capacity, NULL, GL_STREAM_DRAW);
+	}
+	glBindBuffer(target, 0);
+	buffer = std::move(created); // deleting the old one is fine while the GPU still reads it, GL holds on until it's done
+
+	// the fences were for the old storage, nothing in the new one is in flight
+	for (FrameFence& frame : frames) {
+		glDeleteSync(frame.fence);
+	}
+	frames.clear();
+	head = used = frameBytes = 0;
+}
+
+void StreamBuffer::Unload() {
+	Unmap();
+	for (FrameFence& frame : frames) {
+		glDeleteSync(frame.fence);
+	}
+	frames.clear();
+	buffer.Reset(); // deleting a buffer unmaps it too
+	persistentMemory = nullptr;
+	head = used = frameBytes = frameOverflow = 0;
+}
+
+void StreamBuffer::Retire(bool wait) {
+	while (!frames.empty()) {
+		GLenum result = glClientWaitSync(frames.front().fence, 0, 0);
+		if (result == GL_TIMEOUT_EXPIRED && wait) {
+			ScopedTimer timer("stream.wait");
+			result = glClientWaitSync(frames.front().fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000); // a second at most
+			wait = false; // only ever wait for one frame per call
+		}
+		if (result == GL_TIMEOUT_EXPIRED || result == GL_WAIT_FAILED) {
+			return;
+		}
+		glDeleteSync(frames.front().fence);
+		used -= frames.front().bytes;
+		frames.pop_front();
+	}
+}
+
+StreamBuffer::Allocation StreamBuffer::Map(size_t bytes, size_t alignment) {
+	Allocation allocation = { nullptr, 0 };
+	if (bytes == 0) {
+		return allocation;
+	}
+	Unmap();
+	if (bytes > capacity) {
+		Overflow(bytes);
+		return allocation;
+	}
+
+	// Find Space //
+	size_t offset = (head + alignment - 1) / alignment * alignment;
+	bool wrap = offset + bytes > capacity;
+	if (wrap) {
+		offset = 0;
+	}
+	size_t needed = (wrap ? capacity - head : offset - head) + bytes; // the skipped tail of the ring counts as used until the frame retires
+
+	if (persistent) {
+		Retire(false);
+		while (used + needed > capacity && !frames.empty()) {
+			Retire(true); // caught up with the GPU, this is the only place the CPU can stall
+		}
+		if (used + needed > capacity) {
+			// everything else in the ring is this frame's, and some of its draws may not even be issued yet
+			Overflow(bytes);
+			return allocation;
+		}
+		allocation.data = persistentMemory + offset;
+	}
+	else {
+		if (wrap) {
+			// orphaning now would swap the storage out from under ranges this frame has already bound, EndFrame does it
+			Overflow(bytes);
+			return allocation;
+		}
+		// nothing after head has been written since the last orphan, so the GPU can't be reading this range
+		glBindBuffer(target, buffer.ID());
+		allocation.data = (unsigned char*)glMapBufferRange(target, offset, bytes, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+		glBindBuffer(target, 0);
+		mapped = allocation.data != nullptr;
+	}
+	// Find Space //
+
+	allocation.offset = offset;
+	head = offset + bytes;
+	used += needed;
+	frameBytes += needed;
+	bytesWritten += bytes;
+	Profiler::Get().AddCounter("stream.bytes", bytes);
+	return allocation;
+}
+
+void StreamBuffer::Overflow(size_t bytes) {
+	frameOverflow += bytes;
+	Profiler::Get().AddCounter("stream.overflows", 1);
+}
+
+void StreamBuffer::Unmap() {
+	if (mapped) {
+		glBindBuffer(target, buffer.ID());
+		glUnmapBuffer(target);
+		glBindBuffer(target, 0);
+		mapped = false;
+	}
+}
+
+bool StreamBuffer::Write(const void* data, size_t bytes, size_t& offset, size_t alignment) {
+	Allocation allocation = Map(bytes, alignment);
+	if (allocation.data) {
+		std::memcpy(allocation.data, data, bytes);
+	}
+	Unmap();
+	offset = allocation.offset;
+	return allocation.data != nullptr;
+}
+
+void StreamBuffer::EndFrame() {
+	Unmap();
+	size_t demand = frameBytes + frameOverflow;
+	peakFrameBytes = std::max(peakFrameBytes, demand);
+	if (demand > capacity) {
+		// Grow //
+		// only when a single frame can't fit in the whole ring, sized from what it asked for
+		size_t grown = demand * 2;
+		std::cout << "Warning: Stream buffer for " << owner << " couldn't fit a " << demand << " byte frame in " << capacity << " bytes, growing it to " << grown << ".\n";
+		capacity = grown;
+		Create();
+		// Grow //
+	}
+	else if (frameOverflow > 0 && persistent) {
+		// the frame fits the ring but not where it started, new storage starts the next one at zero (the GPU keeps the
+		// old storage until it's done with it)
+		Create();
+	}
+	else if (persistent) {
+		if (frameBytes > 0) {
+			frames.push_back({ glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), frameBytes });
+		}
+	}
+	else if (frameOverflow > 0 || capacity - head < peakFrameBytes * 2) {
+		// between frames is the only time orphaning is safe, every range handed out so far has been drawn from. twice the
+		// biggest frame so far is left free so a frame a little bigger than any before it doesn't lose its draws
+		glBindBuffer(target, buffer.ID());
+		glBufferData(target, capacity, NULL, GL_STREAM_DRAW);
+		glBindBuffer(target, 0);
+		head = 0;
+		used = 0;
+	}
+	frameBytes = 0;
+	frameOverflow = 0;
+
+	// Throughput //
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration<double>(now - throughputStart).count();
+	if (seconds >= 1.0) { // averaged over a second so it doesn't jump around with every frame
+		throughput = (long long)(bytesWritten / 1024.0 / seconds);
+		bytesWritten = 0;
+		throughputStart = now;
+	}
+	Profiler::Get().AddCounter("stream.kbPerSecond", throughput); // summed over every stream buffer
+	// Throughput //
+}
@@ -0,0 +1,324 @@
+#include "ui.h"
+#include "font.h"
+#include "profiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+uint32_t UIHash(const void* data, size_t bytes, uint32_t hash) {
+	const unsigned char* read = (const unsigned char*)data;
+	for (size_t index = 0; index < bytes; index++) {
+		hash = (hash ^ read[index]) * 16777619u;
+	}
+	return hash;
+}
+
+// UI Atlas //
+UIAtlas::UIAtlas() {
+	// a few pixels of white, sampled from the middle so filtering never reaches past them
+	const int white = 4;
+	std::vector<unsigned char> pixels(white * white * 4, 255);
+	Region region;
+	Add(white, white, pixels.data(), region);
+	whiteUV = (region.uv0 + region.uv1) * 0.5f;
+}
+
+bool UIAtlas::Allocate(int width, int height, Region& region) {
+	const int gutter = 1; // keeps neighbours from bleeding into each other under linear filtering
+	int paddedWidth = width + gutter;
+	int paddedHeight = height + gutter;
+	if (paddedWidth > size) {
+		return false;
+	}
+	// the first shelf that's tall enough without wasting more than half of it, otherwise a new one
+	Shelf* shelf = nullptr;
+	for (Shelf& candidate : shelves) {
+		if (candidate.height >= paddedHeight && candidate.height <= paddedHeight * 2 && candidate.used + paddedWidth <= size) {
+			shelf = &candidate;
+			break;
+		}
+	}
+	if (!shelf) {
+		if (shelvesEnd + paddedHeight > size) {
+			std::cout << "Error: UI atlas is full, " << width << "x" << height << " image left out" << std::endl;
+			return false;
+		}
+		shelves.push_back({ shelvesEnd, paddedHeight, 0 });
+		shelvesEnd += paddedHeight;
+		shelf = &shelves.back();
+	}
+
+	region.position = glm::ivec2(shelf->used, shelf->y);
+	region.extent = glm::ivec2(width, height);
+	region.uv0 = glm::vec2((float)region.position.x / size, (float)region.position.y / size);
+	region.uv1 = glm::vec2((float)(region.position.x + width) / size, (float)(region.position.y + height) / size);
+	shelf->used += paddedWidth;
+	return true;
+}
+
+void UIAtlas::Write(const Region& region, const unsigned char* rgba) {
+	Upload upload;
+	upload.position = region.position;
+	upload.extent = region.extent;
+	upload.pixels.assign(rgba, rgba + (size_t)region.extent.x * region.extent.y * 4);
+	pending.push_back(std::move(upload));
+}
+
+bool UIAtlas::Add(int width, int height, const unsigned char* rgba, Region& region) {
+	if (!Allocate(width, height, region)) {
+		return false;
+	}
+	Write(region, rgba);
+	return true;
+}
+
+void UIAtlas::TakeUploads(std::vector<Upload>& uploads) {
+	for (Upload& upload : pending) {
+		uploads.push_back(std::move(upload));
+	}
+	pending.clear();
+}
+// UI Atlas //
+
+// UI Context //
+UIContext::UIContext(UIAtlas& uiAtlas) : atlas(uiAtlas), cursor(0.0f), panelPosition(0.0f) {}
+
+void UIContext::BeginFrame(UIDrawList& drawList, const glm::vec2& screenSize, const glm::vec2& mouse, bool mouseDown, bool mousePressed, bool mouseReleased) {
+	list = &drawList;
+	list->screenSize = screenSize;
+	cursor = mouse;
+	down = mouseDown;
+	pressed = mousePressed;
+	released = mouseReleased;
+	overUI = overUINow;
+	overUINow = false;
+	cacheHits = 0;
+	frame++;
+	if (font) {
+		font->BeginFrame();
+	}
+}
+
+void UIContext::EndFrame() {
+	if (released || !down) {
+		active = 0;
+	}
+	// widgets that weren't drawn for a second or so are probably gone for good (a closed panel, a deselected object)
+	const unsigned long long keepFrames = 120;
+	for (auto entry = cache.begin(); entry != cache.end();) {
+		if (frame - entry->second.lastFrame > keepFrames) {
+			entry = cache.erase(entry);
+		}
+		else {
+			++entry;
+		}
+	}
+	Profiler::Get().AddCounter("ui.quads", list->vertices.size() / 4);
+	Profiler::Get().AddCounter("ui.cachedWidgets", cacheHits);
+	list = nullptr;
+}
+
+// Cached Geometry //
+bool UIContext::Emit(uint32_t id, uint32_t hash) {
+	CachedWidget& widget = cache[id];
+	widget.lastFrame = frame;
+	if (widget.hash == hash && !widget.vertices.empty()) {
+		list->vertices.insert(list->vertices.end(), widget.vertices.begin(), widget.vertices.end());
+		cacheHits++;
+		return false;
+	}
+	widget.hash = hash;
+	widget.vertices.clear();
+	building = &widget;
+	return true;
+}
+
+void UIContext::Quad(const glm::vec2& minimum, const glm::vec2& maximum, uint32_t color) {
+	glm::vec2 white = atlas.WhiteUV();
+	Quad(minimum, maximum, white, white, color);
+}
+
+void UIContext::Quad(const glm::vec2& minimum, const glm::vec2& maximum, const glm::vec2& uv0, const glm::vec2& uv1, uint32_t color) {
+	std::vector<UIVertex>& vertices = building->vertices;
+	vertices.push_back({ minimum, uv0, color });
+	vertices.push_back({ glm::vec2(maximum.x, minimum.y), glm::vec2(uv1.x, uv0.y), color });
+	vertices.push_back({ maximum, uv1, color });
+	vertices.push_back({ glm::vec2(minimum.x, maximum.y), glm::vec2(uv0.x, uv1.y), color });
+}
+
+void UIContext::EndEmit() {
+	list->vertices.insert(list->vertices.end(), building->vertices.begin(), building->vertices.end());
+	building = nullptr;
+}
+// Cached Geometry //
+
+// Layout //
+uint32_t UIContext::WidgetID(const std::string& label) const {
+	return UIHash(label.data(), label.size(), panelID);
+}
+
+void UIContext::NextRow(glm::vec2& minimum, glm::vec2& maximum) {
+	minimum = glm::vec2(panelPosition.x + padding, panelY);
+	maximum = glm::vec2(panelPosition.x + panelWidth - padding, panelY + rowHeight);
+	panelY += rowHeight + padding;
+}
+
+bool UIContext::Hovered(const glm::vec2& minimum, const glm::vec2& maximum) const {
+	return cursor.x >= minimum.x && cursor.x < maximum.x && cursor.y >= minimum.y && cursor.y < maximum.y;
+}
+
+uint32_t UIContext::Interact(uint32_t id, const glm::vec2& minimum, const glm::vec2& maximum) {
+	bool hovered = Hovered(minimum, maximum);
+	if (hovered && pressed && active == 0) {
+		active = id;
+	}
+	if (active == id) {
+		return activeColor;
+	}
+	return hovered && active == 0 ? hoverColor : widgetColor;
+}
+
+void UIContext::RowText(const std::string& text, const glm::vec2& minimum, const glm::vec2& maximum, bool centered) {
+	if (!font || !font->Loaded()) {
+		return;
+	}
+	const Font::Run& run = font->Shape(text, textSize);
+	float x = centered ? (minimum.x + maximum.x - run.extent.x) * 0.5f : minimum.x + padding;
+	float y = (minimum.y + maximum.y - font->LineHeight(textSize)) * 0.5f;
+	font->Draw(run, glm::vec2(x, y), textColor, list->vertices);
+}
+// Layout //
+
+// Panels //
+void UIContext::BeginPanel(const std::string& name, const glm::vec2& position, float width) {
+	panelID = UIHash(name.data(), name.size());
+	panelPosition = position;
+	panelWidth = width;
+	panelY = position.y + padding;
+	// the background goes first so it's drawn under the widgets, but how tall it is isn't known until EndPanel
+	panelBackground = list->vertices.size();
+	list->vertices.resize(list->vertices.size() + 4);
+	if (font && font->Loaded()) {
+		Label(name); // the title
+	}
+}
+
+void UIContext::EndPanel() {
+	glm::vec2 minimum = panelPosition;
+	glm::vec2 maximum(panelPosition.x + panelWidth, panelY);
+	glm::vec2 white = atlas.WhiteUV();
+	UIVertex* background = &list->vertices[panelBackground];
+	background[0] = { minimum, white, panelColor };
+	background[1] = { glm::vec2(maximum.x, minimum.y), white, panelColor };
+	background[2] = { maximum, white, panelColor };
+	background[3] = { glm::vec2(minimum.x, maximum.y), white, panelColor };
+	overUINow = overUINow || Hovered(minimum, maximum);
+	panelID = 0;
+}
+// Panels //
+
+// Widgets //
+bool UIContext::Button(const std::string& label) {
+	uint32_t id = WidgetID(label);
+	glm::vec2 minimum, maximum;
+	NextRow(minimum, maximum);
+	uint32_t color = Interact(id, minimum, maximum);
+	bool clicked = active == id && released && Hovered(minimum, maximum);
+
+	float key[] = { minimum.x, minimum.y, maximum.x, maximum.y };
+	if (Emit(id, UIHash(&color, sizeof(color), UIHash(key, sizeof(key))))) {
+		Quad(minimum, maximum, color);
+		EndEmit();
+	}
+	RowText(label, minimum, maximum, true);
+	return clicked;
+}
+
+bool UIContext::Checkbox(const std::string& label, bool& value) {
+	uint32_t id = WidgetID(label);
+	glm::vec2 minimum, maximum;
+	NextRow(minimum, maximum);
+	glm::vec2 boxMaximum(minimum.x + rowHeight, maximum.y); // the box is square, the rest of the row is the label
+	uint32_t color = Interact(id, minimum, maximum);
+	bool changed = active == id && released && Hovered(minimum, maximum);
+	if (changed) {
+		value = !value;
+	}
+
+	float key[] = { minimum.x, minimum.y, maximum.x, maximum.y, value ? 1.0f : 0.0f };
+	if (Emit(id, UIHash(&color, sizeof(color), UIHash(key, sizeof(key))))) {
+		Quad(minimum, boxMaximum, color);
+		if (value) {
+			glm::vec2 inset(rowHeight * 0.25f);
+			Quad(minimum + inset, boxMaximum - inset, accentColor);
+		}
+		EndEmit();
+	}
+	RowText(label, glm::vec2(boxMaximum.x, minimum.y), maximum, false);
+	return changed;
+}
+
+bool UIContext::Slider(const std::string& label, float& value, float minimum, float maximum) {
+	uint32_t id = WidgetID(label);
+	glm::vec2 rowMinimum, rowMaximum;
+	NextRow(rowMinimum, rowMaximum);
+	uint32_t color = Interact(id, rowMinimum, rowMaximum);
+	bool changed = false;
+	if (active == id && down && maximum > minimum) {
+		float fraction = glm::clamp((cursor.x - rowMinimum.x) / (rowMaximum.x - rowMinimum.x), 0.0f, 1.0f);
+		float newValue = minimum + fraction * (maximum - minimum);
+		changed = newValue != value;
+		value = newValue;
+	}
+
+	float fraction = maximum > minimum ? glm::clamp((value - minimum) / (maximum - minimum), 0.0f, 1.0f) : 0.0f;
+	float fillX = rowMinimum.x + fraction * (rowMaximum.x - rowMinimum.x);
+	float key[] = { rowMinimum.x, rowMinimum.y, rowMaximum.x, rowMaximum.y, fillX };
+	if (Emit(id, UIHash(&color, sizeof(color), UIHash(key, sizeof(key))))) {
+		Quad(rowMinimum, rowMaximum, color);
+		Quad(rowMinimum, glm::vec2(fillX, rowMaximum.y), accentColor);
+		EndEmit();
+	}
+	char text[128];
+	std::snprintf(text, sizeof(text), "%s  %.2f", label.c_str(), value);
+	RowText(text, rowMinimum, rowMaximum, false);
+	return changed;
+}
+
+void UIContext::Separator() {
+	glm::vec2 minimum(panelPosition.x + padding, panelY);
+	glm::vec2 maximum(panelPosition.x + panelWidth - padding, panelY + 1.0f);
+	panelY += 1.0f + padding;
+	float key[] = { minimum.x, minimum.y, maximum.x };
+	if (Emit(UIHash(key, sizeof(key), panelID), 0)) {
+		Quad(minimum, maximum, widgetColor);
+		EndEmit();
+	}
+}
+
+void UIContext::Label(const std::string& text) {
+	glm::vec2 minimum, maximum;
+	NextRow(minimum, maximum);
+	RowText(text, glm::vec2(minimum.x - padding, minimum.y), maximum, false); // lined up with the widgets, not their text
+}
+// Widgets //
+
+// Drawing //
+glm::vec2 UIContext::Text(const std::string& text, const glm::vec2& position, uint32_t color, float size) {
+	if (!font || !font->Loaded()) {
+		return glm::vec2(0.0f);
+	}
+	const Font::Run& run = font->Shape(text, size > 0.0f ? size : textSize);
+	font->Draw(run, position, color, list->vertices);
+	return run.extent;
+}
+
+void UIContext::Rect(const glm::vec2& minimum, const glm::vec2& maximum, uint32_t color) {
+	glm::vec2 white = atlas.WhiteUV();
+	list->vertices.push_back({ minimum, white, color });
+	list->vertices.push_back({ glm::vec2(maximum.x, minimum.y), white, color });
+	list->vertices.push_back({ maximum, white, color });
+	list->vertices.push_back({ glm::vec2(minimum.x, maximum.y), white, color });
+}
+// Drawing //
+// UI Context //
@@ -0,0 +1,128 @@
+#include "uirenderer.h"
+#include "profiler.h"
+#include <cstddef>
+#include <cstring>
+
+UIRenderer::UIRenderer() :
+	shader("assets/shaders/ui.vert", "assets/shaders/ui.frag"),
+	stream(GL_ARRAY_BUFFER, 4 * 1024 * 1024, "ui"), layoutBuffer(0) {
+
+	// Atlas //
+	atlasTexture = GLTexture::Create("ui");
+	glBindTexture(GL_TEXTURE_2D, atlasTexture.ID());
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, UIAtlas::size, UIAtlas::size, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR); // no mipmaps, the UI is drawn at its own size
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	GPUResourceRegistry::Get().SetBytes(GPUResourceType::Texture, atlasTexture.ID(), (size_t)UIAtlas::size * UIAtlas::size * 4);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	// Atlas //
+
+	// Quad Indices //
+	// 0 1 2, 0 2 3 for every quad, shared by every draw
+	std::vector<unsigned int> indices(maxQuads * 6);
+	for (unsigned int quad = 0; quad < maxQuads; quad++) {
+		unsigned int first = quad * 4;
+		unsigned int* index = &indices[quad * 6];
+		index[0] = first;
+		index[1] = first + 1;
+		index[2] = first + 2;
+		index[3] = first;
+		index[4] = first + 2;
+		index[5] = first + 3;
+	}
+	vertexArray = GLVertexArray::Create("ui");
+	glBindVertexArray(vertexArray.ID());
+	indexBuffer = GLBuffer::Create("ui");
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer.ID());
+	BufferData(GL_ELEMENT_ARRAY_BUFFER, indexBuffer, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+	glBindVertexArray(0);
+	// Quad Indices //
+
+	BindLayout();
+
+	glUseProgram(shader.ID());
+	glUniform1i(glGetUniformLocation(shader.ID(), "atlas"), 0);
+	screenSizeLoc = glGetUniformLocation(shader.ID(), "screenSize");
+}
+
+void UIRenderer::BindLayout() {
+	// points at the start of the stream, each draw's base vertex moves it to where that frame's vertices are
+	glBindVertexArray(vertexArray.ID());
+	glBindBuffer(GL_ARRAY_BUFFER, stream.ID());
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(UIVertex), (void*)offsetof(UIVertex, position));
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(UIVertex), (void*)offsetof(UIVertex, uv));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(UIVertex), (void*)offsetof(UIVertex, color));
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(UIVertex), (void*)offsetof(UIVertex, sdf));
+	glEnableVertexAttribArray(3);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	layoutBuffer = stream.ID();
+}
+
+void UIRenderer::Unload() {
+	stream.Unload();
+	indexBuffer.Reset();
+	vertexArray.Reset();
+	atlasTexture.Reset();
+	shader.Unload();
+}
+
+void UIRenderer::Upload(const std::vector<UIAtlas::Upload>& uploads) {
+	if (uploads.empty()) {
+		return;
+	}
+	glBindTexture(GL_TEXTURE_2D, atlasTexture.ID());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4); // RGBA8 rows are always whole words
+	for (const UIAtlas::Upload& upload : uploads) {
+		glTexSubImage2D(GL_TEXTURE_2D, 0, upload.position.x, upload.position.y, upload.extent.x, upload.extent.y, GL_RGBA, GL_UNSIGNED_BYTE, upload.pixels.data());
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void UIRenderer::Draw(const UIDrawList& list, int framebufferWidth, int framebufferHeight) {
+	if (list.vertices.empty() || list.screenSize.x <= 0.0f || list.screenSize.y <= 0.0f) {
+		return;
+	}
+	ScopedTimer timer("ui.draw");
+	StreamBuffer::Allocation allocation = stream.Map(list.vertices.size() * sizeof(UIVertex), sizeof(UIVertex)); // a whole number of vertices in, so it works as a base vertex
+	if (!allocation.data) {
+		stream.Unmap();
+		return;
+	}
+	std::memcpy(allocation.data, list.vertices.data(), list.vertices.size() * sizeof(UIVertex));
+	stream.Unmap();
+	if (stream.ID() != layoutBuffer) {
+		BindLayout(); // the stream grew into a new buffer
+	}
+
+	glViewport(0, 0, framebufferWidth, framebufferHeight);
+	glDisable(GL_DEPTH_TEST); // drawn in order over everything
+	glEnable(GL_BLEND);
+	glUseProgram(shader.ID());
+	glUniform2f(screenSizeLoc, list.screenSize.x, list.screenSize.y);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, atlasTexture.ID());
+	glBindVertexArray(vertexArray.ID());
+
+	size_t quads = list.vertices.size() / 4;
+	int baseVertex = (int)(allocation.offset / sizeof(UIVertex));
+	for (size_t first = 0; first < quads; first += maxQuads) {
+		size_t count = quads - first < maxQuads ? quads - first : maxQuads; // not std::min, that would need maxQuads defined out of line
+		glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)(count * 6), GL_UNSIGNED_INT, 0, baseVertex + (int)(first * 4));
+		Profiler::Get().AddCounter("draw.calls", 1);
+	}
+	Profiler::Get().AddCounter("ui.quadsDrawn", quads);
+	Profiler::Get().AddCounter("draw.triangles", quads * 2);
+
+	glBindVertexArray(0);
+	glEnable(GL_DEPTH_TEST);
+}
+
+void UIRenderer::EndFrame() {
+	stream.EndFrame();
+}
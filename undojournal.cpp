@@ -0,0 +1,155 @@
+#include "undojournal.h"
+#include "deltacodec.h"
+#include "profiler.h"
+#include <algorithm>
+#include <iostream>
+
+void UndoJournal::Encode(const TransformChunks& before, const TransformChunks& after, Entry& entry) {
+	for (size_t chunk = 0; chunk < after.ChunkCount(); chunk++) {
+		if (after.SharesChunk(before, chunk)) {
+			continue; // never written since the snapshot, nothing to diff
+		}
+		size_t chunkBytes = after.ChunkLength(chunk) * sizeof(TransformComponent);
+		if (DeltaCodec::Encode((const unsigned char*)before.ChunkData(chunk), (const unsigned char*)after.ChunkData(chunk), chunkBytes, entry.data)) {
+			entry.chunks.push_back((uint32_t)chunk);
+			entry.ends.push_back((uint32_t)entry.data.size());
+		}
+	}
+	// entries live for a long time, don't let them keep the slack from growing
+	entry.chunks.shrink_to_fit();
+	entry.ends.shrink_to_fit();
+	entry.data.shrink_to_fit();
+}
+
+bool UndoJournal::Apply(const Entry& entry, TransformChunks& transforms) {
+	uint32_t start = 0;
+	for (size_t record = 0; record < entry.chunks.size(); record++) {
+		uint32_t chunk = entry.chunks[record];
+		if (chunk >= transforms.ChunkCount()) {
+			return false;
+		}
+		unsigned char* items = (unsigned char*)transforms.EditChunk(chunk); // clones it if a snapshot still holds it
+		if (!DeltaCodec::Apply(items, transforms.ChunkLength(chunk) * sizeof(TransformComponent), entry.data.data() + start, entry.ends[record] - start)) {
+			return false;
+		}
+		start = entry.ends[record];
+	}
+	return true;
+}
+
+void UndoJournal::Record(const TransformChunks& before, const TransformChunks& after, uint32_t tag, double time) {
+	ScopedTimer timer("edit.record");
+	if (before.Size() != after.Size()) {
+		std::cout << "Error: undo history cleared, an edit changed the number of objects" << std::endl;
+		Clear();
+		return;
+	}
+	DropRedo();
+
+	// Coalescing //
+	// a run keeps the state from before its first edit, so merging is just diffing against that again. the chunks the
+	// run hasn't touched are shared with after and skipped, whatever the earlier edits changed gets diffed once more
+	bool merge = tag != 0 && tag == coalesceTag && time - coalesceTime <= coalesceWindow;
+	if (merge) {
+		if (coalesceEntry) {
+			Pop();
+		}
+		Entry entry;
+		Encode(coalesceBefore, after, entry);
+		coalesceEntry = !entry.chunks.empty(); // dragged back to where it started, nothing to undo
+		if (coalesceEntry) {
+			Push(entry);
+		}
+		coalesceTime = time;
+		return;
+	}
+	EndCoalescing();
+	// Coalescing //
+
+	Entry entry;
+	Encode(before, after, entry);
+	if (entry.chunks.empty()) {
+		return;
+	}
+	Push(entry);
+	if (tag != 0) {
+		coalesceBefore = before;
+		coalesceTag = tag;
+		coalesceTime = time;
+		coalesceEntry = true;
+	}
+}
+
+void UndoJournal::EndCoalescing() {
+	coalesceBefore = TransformChunks(); // lets go of the chunks it held
+	coalesceTag = 0;
+	coalesceEntry = false;
+}
+
+bool UndoJournal::Undo(TransformChunks& transforms) {
+	ScopedTimer timer("edit.undo");
+	EndCoalescing();
+	if (applied == 0) {
+		return false;
+	}
+	if (!Apply(entries[applied - 1], transforms)) {
+		std::cout << "Error: undo history doesn't fit the level, cleared" << std::endl;
+		Clear();
+		return false;
+	}
+	applied--;
+	return true;
+}
+
+bool UndoJournal::Redo(TransformChunks& transforms) {
+	ScopedTimer timer("edit.redo");
+	EndCoalescing();
+	if (applied == entries.size()) {
+		return false;
+	}
+	if (!Apply(entries[applied], transforms)) {
+		std::cout << "Error: undo history doesn't fit the level, cleared" << std::endl;
+		Clear();
+		return false;
+	}
+	applied++;
+	return true;
+}
+
+void UndoJournal::Clear() {
+	entries.clear();
+	applied = 0;
+	bytes = 0;
+	EndCoalescing();
+}
+
+void UndoJournal::Push(Entry& entry) {
+	bytes += entry.Bytes();
+	entries.push_back(Entry());
+	entries.back().chunks.swap(entry.chunks);
+	entries.back().ends.swap(entry.ends);
+	entries.back().data.swap(entry.data);
+	applied = entries.size();
+	Trim();
+}
+
+void UndoJournal::Pop() {
+	bytes -= entries.back().Bytes();
+	entries.pop_back();
+	applied = std::min(applied, entries.size());
+}
+
+void UndoJournal::DropRedo() {
+	while (entries.size() > applied) {
+		Pop();
+	}
+}
+
+// oldest first, the newest entry is kept even if it's over the budget on its own
+void UndoJournal::Trim() {
+	while (bytes > budget && entries.size() > 1) {
+		bytes -= entries.front().Bytes();
+		entries.pop_front();
+		applied--;
+	}
+}
@@ -0,0 +1,59 @@
+#include "uniformbuffers.h"
+#include "profiler.h"
+#include <cstring>
+
+UniformBuffers::UniformBuffers() : stream(GL_UNIFORM_BUFFER, 8 * 1024 * 1024, "uniform buffers"), alignment(256), objectStride(0), objectsOffset(0), mappedObjects(nullptr) {
+	int offsetAlignment = 256;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+	alignment = (unsigned int)offsetAlignment;
+	objectStride = ((unsigned int)sizeof(ObjectUniforms) + alignment - 1) / alignment * alignment;
+}
+
+void UniformBuffers::BindBlocks(unsigned int program) {
+	unsigned int frameIndex = glGetUniformBlockIndex(program, "FrameData");
+	if (frameIndex != GL_INVALID_INDEX) {
+		glUniformBlockBinding(program, frameIndex, FRAME_BLOCK_BINDING);
+	}
+	unsigned int objectIndex = glGetUniformBlockIndex(program, "ObjectData");
+	if (objectIndex != GL_INVALID_INDEX) {
+		glUniformBlockBinding(program, objectIndex, OBJECT_BLOCK_BINDING);
+	}
+}
+
+void UniformBuffers::Unload() {
+	stream.Unload();
+}
+
+void UniformBuffers::SetFrame(const FrameUniforms& frame) {
+	size_t offset = 0;
+	if (stream.Write(&frame, sizeof(FrameUniforms), offset, alignment)) {
+		glBindBufferRange(GL_UNIFORM_BUFFER, FRAME_BLOCK_BINDING, stream.ID(), offset, sizeof(FrameUniforms));
+	}
+}
+
+bool UniformBuffers::BeginObjects(unsigned int count) {
+	Profiler::Get().AddCounter("uniforms.objects", count);
+	StreamBuffer::Allocation allocation = stream.Map((size_t)count * objectStride, alignment);
+	objectsOffset = allocation.offset;
+	mappedObjects = allocation.data;
+	return mappedObjects != nullptr || count == 0;
+}
+
+void UniformBuffers::WriteObject(unsigned int index, const ObjectUniforms& object) {
+	if (mappedObjects) {
+		std::memcpy(mappedObjects + (size_t)index * objectStride, &object, sizeof(ObjectUniforms));
+	}
+}
+
+void UniformBuffers::EndObjects() {
+	stream.Unmap();
+	mappedObjects = nullptr;
+}
+
+void UniformBuffers::BindObject(unsigned int index) {
+	glBindBufferRange(GL_UNIFORM_BUFFER, OBJECT_BLOCK_BINDING, stream.ID(), objectsOffset + (size_t)index * objectStride, sizeof(ObjectUniforms));
+}
+
+void UniformBuffers::EndFrame() {
+	stream.EndFrame();
+}